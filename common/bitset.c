@@ -0,0 +1,217 @@
+/*
+ * bitset.c    Gretchen Kerfoot    Spring 2025
+ *
+ * Implementation of the bitset module.
+ * Members are bits in an array of bytes; bit n lives in byte n / 8.
+ * The file format is the magic "TSEBITS1" followed by the byte array.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bitset.h"
+
+#define BITSET_MAGIC "TSEBITS1"
+#define BITSET_MAGIC_LEN 8
+
+//private type for the bitset
+typedef struct bitset {
+  unsigned char* bits;  //one bit per possible member
+  int numBytes;         //bytes allocated for bits
+} bitset_t;
+
+
+/*
+ * Creates a new, empty bitset.
+ *
+ * Returns:
+ *   pointer to new bitset, or NULL if out of memory
+ */
+bitset_t* bitset_new(void) {
+  bitset_t* set = malloc(sizeof(bitset_t));
+  if (set == NULL) {
+    return NULL;
+  }
+
+  set->bits = NULL;
+  set->numBytes = 0;
+  return set;
+}
+
+
+/*
+ * Adds n to the set, growing the byte array to fit.
+ *
+ * Returns:
+ *   true if success, false if invalid or out of memory
+ */
+bool bitset_set(bitset_t* set, const int n) {
+  if (set == NULL || n < 0) {
+    return false;
+  }
+
+  if (n / 8 >= set->numBytes) {
+    int numBytes = (set->numBytes == 0) ? 16 : set->numBytes;
+    while (n / 8 >= numBytes) {
+      numBytes *= 2;
+    }
+    unsigned char* bits = realloc(set->bits, numBytes);
+    if (bits == NULL) {
+      return false;
+    }
+    memset(bits + set->numBytes, 0, numBytes - set->numBytes);
+    set->bits = bits;
+    set->numBytes = numBytes;
+  }
+
+  set->bits[n / 8] |= (unsigned char)(1 << (n % 8));
+  return true;
+}
+
+
+/*
+ * Tests whether n is in the set.
+ */
+bool bitset_test(const bitset_t* set, const int n) {
+  if (set == NULL || n < 0 || n / 8 >= set->numBytes) {
+    return false;
+  }
+  return (set->bits[n / 8] >> (n % 8)) & 1;
+}
+
+
+/*
+ * Counts the members of the set.
+ */
+int bitset_count(const bitset_t* set) {
+  if (set == NULL) {
+    return 0;
+  }
+
+  int count = 0;
+  for (int i = 0; i < set->numBytes; i++) {
+    for (unsigned char b = set->bits[i]; b != 0; b &= b - 1) {
+      count++;
+    }
+  }
+  return count;
+}
+
+
+/*
+ * Finds the smallest member >= from, skipping empty bytes quickly.
+ *
+ * Returns:
+ *   the member, or -1 if none
+ */
+int bitset_next(const bitset_t* set, const int from) {
+  if (set == NULL) {
+    return -1;
+  }
+
+  int n = (from < 0) ? 0 : from;
+  while (n / 8 < set->numBytes) {
+    unsigned char b = set->bits[n / 8] >> (n % 8);
+    if (b == 0) {
+      n = (n / 8 + 1) * 8;  //nothing more in this byte
+    } else if (b & 1) {
+      return n;
+    } else {
+      n++;
+    }
+  }
+  return -1;
+}
+
+
+/*
+ * Saves the set to filename, by way of a temporary file.
+ *
+ * Returns:
+ *   true if success, false on error
+ */
+bool bitset_save(const bitset_t* set, const char* filename) {
+  if (set == NULL || filename == NULL) {
+    return false;
+  }
+
+  char* tempFile = malloc(strlen(filename) + 5);
+  if (tempFile == NULL) {
+    return false;
+  }
+  sprintf(tempFile, "%s.tmp", filename);
+
+  FILE* fp = fopen(tempFile, "wb");
+  if (fp == NULL) {
+    free(tempFile);
+    return false;
+  }
+
+  bool ok = fwrite(BITSET_MAGIC, 1, BITSET_MAGIC_LEN, fp) == BITSET_MAGIC_LEN &&
+            fwrite(set->bits, 1, set->numBytes, fp) == (size_t)set->numBytes;
+  if (fclose(fp) != 0) {
+    ok = false;
+  }
+
+  if (ok) {
+    ok = (rename(tempFile, filename) == 0);
+  } else {
+    remove(tempFile);
+  }
+  free(tempFile);
+  return ok;
+}
+
+
+/*
+ * Loads a set from filename.
+ *
+ * Returns:
+ *   pointer to new bitset, or NULL on error
+ */
+bitset_t* bitset_load(const char* filename) {
+  if (filename == NULL) {
+    return NULL;
+  }
+
+  FILE* fp = fopen(filename, "rb");
+  if (fp == NULL) {
+    return NULL;
+  }
+
+  char magic[BITSET_MAGIC_LEN];
+  if (fread(magic, 1, BITSET_MAGIC_LEN, fp) != BITSET_MAGIC_LEN ||
+      memcmp(magic, BITSET_MAGIC, BITSET_MAGIC_LEN) != 0) {
+    fclose(fp);
+    return NULL;
+  }
+
+  //the rest of the file is the byte array
+  fseek(fp, 0, SEEK_END);
+  long numBytes = ftell(fp) - BITSET_MAGIC_LEN;
+  fseek(fp, BITSET_MAGIC_LEN, SEEK_SET);
+
+  bitset_t* set = bitset_new();
+  if (set != NULL && numBytes > 0) {
+    set->bits = malloc(numBytes);
+    set->numBytes = (int)numBytes;
+    if (set->bits == NULL || fread(set->bits, 1, numBytes, fp) != (size_t)numBytes) {
+      bitset_delete(set);
+      set = NULL;
+    }
+  }
+
+  fclose(fp);
+  return set;
+}
+
+
+/*
+ * Frees all memory used by the set.
+ */
+void bitset_delete(bitset_t* set) {
+  if (set == NULL) return;
+
+  free(set->bits);
+  free(set);
+}
@@ -0,0 +1,81 @@
+/*
+ * bitset.h    Gretchen Kerfoot    Spring 2025
+ *
+ * This is the header file for the bitset module.
+ * A bitset is a growable set of non-negative integers (such as docIDs),
+ * stored one bit per possible member, so membership tests take constant
+ * time. It can be saved to and loaded from a file.
+ */
+
+#ifndef __BITSET_H
+#define __BITSET_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+//global types
+typedef struct bitset bitset_t;
+
+/*
+ * Creates a new, empty bitset.
+ *
+ * Returns:
+ *   pointer to a new bitset_t, or NULL if out of memory
+ * Caller is responsible for:
+ *   later calling bitset_delete
+ */
+bitset_t* bitset_new(void);
+
+/*
+ * Adds n to the set, growing it as needed.
+ *
+ * Returns:
+ *   true if successful, false if n is negative or out of memory
+ */
+bool bitset_set(bitset_t* set, const int n);
+
+/*
+ * Returns true if n is in the set; false if not, or if set is NULL.
+ */
+bool bitset_test(const bitset_t* set, const int n);
+
+/*
+ * Returns the number of members of the set, or 0 if NULL.
+ */
+int bitset_count(const bitset_t* set);
+
+/*
+ * Returns the smallest member that is >= from, or -1 if there is none.
+ * Useful for visiting every member in increasing order.
+ */
+int bitset_next(const bitset_t* set, const int from);
+
+/*
+ * Saves the set to a file.
+ *
+ * Caller provides:
+ *   set - valid bitset
+ *   filename - path to a writable file
+ * Returns:
+ *   true if successful, false on error
+ * Notes:
+ *   The set is written to filename.tmp and renamed over filename, so a
+ *   reader never sees a partially written file.
+ */
+bool bitset_save(const bitset_t* set, const char* filename);
+
+/*
+ * Loads a set saved by bitset_save.
+ *
+ * Returns:
+ *   pointer to a new bitset_t, or NULL if the file cannot be read or
+ *   is not a saved bitset
+ */
+bitset_t* bitset_load(const char* filename);
+
+/*
+ * Frees all memory used by the set; ignores NULL.
+ */
+void bitset_delete(bitset_t* set);
+
+#endif // __BITSET_H
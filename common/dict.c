@@ -0,0 +1,363 @@
+/*
+ * dict.c    Gretchen Kerfoot    Spring 2025
+ *
+ * Implementation of the dict module, a sorted front-coded dictionary.
+ * The words live in one byte array of blocks; each block starts with
+ *   vbyte(length) bytes
+ * for its first word, followed by up to DICT_BLOCK - 1 entries of
+ *   vbyte(shared) vbyte(length - shared) suffix
+ * An array of block offsets makes binary search over blocks possible.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "dict.h"
+#include "vbyte.h"
+
+//private type for the dictionary
+typedef struct dict {
+  unsigned char* data;  //front-coded blocks
+  int len;              //bytes of data in use
+  int cap;              //bytes of data allocated
+  int* blocks;          //offset of each block in data
+  int blockCap;         //number of offsets allocated
+  int numTerms;         //number of words
+  int maxLen;           //length of the longest word
+  char* last;           //most recently added word
+  int lastCap;          //bytes allocated for last
+} dict_t;
+
+//helper function prototypes
+static int dict_lowerBound(const dict_t* dict, const char* word, char* buf);
+static int dict_termCmp(const unsigned char* term, const int len, const char* word);
+static bool dict_reserve(dict_t* dict, const int extra);
+
+
+/*
+ * Creates a new, empty dictionary.
+ *
+ * Returns:
+ *   pointer to new dictionary, or NULL if out of memory
+ */
+dict_t* dict_new(void) {
+  dict_t* dict = malloc(sizeof(dict_t));
+  if (dict == NULL) {
+    return NULL;
+  }
+
+  dict->data = NULL;
+  dict->len = 0;
+  dict->cap = 0;
+  dict->blocks = NULL;
+  dict->blockCap = 0;
+  dict->numTerms = 0;
+  dict->maxLen = 0;
+  dict->last = NULL;
+  dict->lastCap = 0;
+  return dict;
+}
+
+
+/*
+ * Appends word, starting a new block every DICT_BLOCK words and otherwise
+ * coding it against the previous word.
+ *
+ * Returns:
+ *   term number of word, or -1 if out of order or out of memory
+ */
+int dict_add(dict_t* dict, const char* word) {
+  if (dict == NULL || word == NULL || word[0] == '\0') {
+    return -1;
+  }
+  if (dict->numTerms > 0 && strcmp(word, dict->last) <= 0) {
+    return -1;
+  }
+
+  int len = strlen(word);
+  if (!dict_reserve(dict, 2 * VBYTE_MAXLEN + len)) {
+    return -1;
+  }
+
+  //remembers the word, for coding the next one
+  if (len + 1 > dict->lastCap) {
+    char* bigger = realloc(dict->last, len + 1);
+    if (bigger == NULL) {
+      return -1;
+    }
+    dict->last = bigger;
+    dict->lastCap = len + 1;
+  }
+
+  int shared = 0;
+  if (dict->numTerms % DICT_BLOCK == 0) {
+    //starts a new block with the whole word
+    int numBlocks = dict->numTerms / DICT_BLOCK;
+    if (numBlocks == dict->blockCap) {
+      int blockCap = (dict->blockCap == 0) ? 16 : dict->blockCap * 2;
+      int* bigger = realloc(dict->blocks, blockCap * sizeof(int));
+      if (bigger == NULL) {
+        return -1;
+      }
+      dict->blocks = bigger;
+      dict->blockCap = blockCap;
+    }
+    dict->blocks[numBlocks] = dict->len;
+    dict->len += vbyte_encode(dict->data + dict->len, len);
+  } else {
+    while (word[shared] != '\0' && word[shared] == dict->last[shared]) {
+      shared++;
+    }
+    dict->len += vbyte_encode(dict->data + dict->len, shared);
+    dict->len += vbyte_encode(dict->data + dict->len, len - shared);
+  }
+  memcpy(dict->data + dict->len, word + shared, len - shared);
+  dict->len += len - shared;
+
+  memcpy(dict->last, word, len + 1);
+  if (len > dict->maxLen) {
+    dict->maxLen = len;
+  }
+  return dict->numTerms++;
+}
+
+
+/*
+ * Returns number of words in the dictionary.
+ */
+int dict_size(const dict_t* dict) {
+  return (dict == NULL) ? 0 : dict->numTerms;
+}
+
+
+/*
+ * Finds the term number of word.
+ *
+ * Returns:
+ *   term number, or -1 if not found
+ */
+int dict_find(const dict_t* dict, const char* word) {
+  if (dict == NULL || word == NULL || dict->numTerms == 0) {
+    return -1;
+  }
+
+  char* buf = malloc(dict->maxLen + 1);
+  if (buf == NULL) {
+    return -1;
+  }
+
+  //the lower bound is the word itself if it is present
+  int term = dict_lowerBound(dict, word, buf);
+  if (term == dict->numTerms || strcmp(buf, word) != 0) {
+    term = -1;
+  }
+  free(buf);
+  return term;
+}
+
+
+/*
+ * Finds the range of words starting with prefix: from the first word
+ * >= prefix up to the first word >= the prefix's successor (the prefix
+ * with its last byte incremented).
+ *
+ * Returns:
+ *   number of words in the range
+ */
+int dict_prefix(const dict_t* dict, const char* prefix, int* first) {
+  if (first != NULL) {
+    *first = 0;
+  }
+  if (dict == NULL || prefix == NULL || first == NULL || dict->numTerms == 0) {
+    return 0;
+  }
+
+  int len = strlen(prefix);
+  char* buf = malloc(dict->maxLen + len + 2);
+  if (buf == NULL) {
+    return 0;
+  }
+
+  *first = dict_lowerBound(dict, prefix, buf);
+
+  //the successor drops trailing 0xff bytes, which cannot be incremented
+  char* successor = buf + dict->maxLen + 1;
+  memcpy(successor, prefix, len + 1);
+  while (len > 0 && (unsigned char)successor[len - 1] == 0xff) {
+    successor[--len] = '\0';
+  }
+
+  int last = dict->numTerms;
+  if (len > 0) {
+    successor[len - 1]++;
+    last = dict_lowerBound(dict, successor, buf);
+  }
+  free(buf);
+  return last - *first;
+}
+
+
+/*
+ * Decodes terms first..last-1 in order and passes each to itemfunc.
+ */
+void dict_range(const dict_t* dict, const int first, const int last, void* arg,
+                void (*itemfunc)(void* arg, const int term, const char* word)) {
+  if (dict == NULL || itemfunc == NULL) {
+    return;
+  }
+  int start = (first < 0) ? 0 : first;
+  int end = (last > dict->numTerms) ? dict->numTerms : last;
+  if (start >= end) {
+    return;
+  }
+
+  char* buf = malloc(dict->maxLen + 1);
+  if (buf == NULL) {
+    return;
+  }
+
+  //decodes from the start of first's block
+  const unsigned char* pos = dict->data + dict->blocks[start / DICT_BLOCK];
+  for (int term = start - start % DICT_BLOCK; term < end; term++) {
+    int shared = 0;
+    if (term % DICT_BLOCK == 0) {
+      pos = dict->data + dict->blocks[term / DICT_BLOCK];
+    } else {
+      shared = vbyte_decode(&pos, dict->data + dict->len);
+    }
+    int rest = vbyte_decode(&pos, dict->data + dict->len);
+    memcpy(buf + shared, pos, rest);
+    buf[shared + rest] = '\0';
+    pos += rest;
+
+    if (term >= start) {
+      (*itemfunc)(arg, term, buf);
+    }
+  }
+  free(buf);
+}
+
+
+/*
+ * Returns bytes of memory used by the dictionary.
+ */
+size_t dict_memory(const dict_t* dict) {
+  if (dict == NULL) {
+    return 0;
+  }
+  return sizeof(dict_t) + dict->cap + dict->blockCap * sizeof(int) + dict->lastCap;
+}
+
+
+/*
+ * Frees all memory used by the dictionary.
+ */
+void dict_delete(dict_t* dict) {
+  if (dict == NULL) return;
+
+  free(dict->data);
+  free(dict->blocks);
+  free(dict->last);
+  free(dict);
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Finds the first term >= word: binary searches for the last block whose
+ * first word is <= word, then scans that block. buf must have room for
+ * the longest word; on return it holds the term found (if any).
+ *
+ * Returns:
+ *   the term number, or numTerms if every word is < word
+ */
+static int dict_lowerBound(const dict_t* dict, const char* word, char* buf) {
+  int numBlocks = (dict->numTerms + DICT_BLOCK - 1) / DICT_BLOCK;
+
+  //invariant: blocks before lo start <= word, blocks from hi on start > word
+  int lo = 0;
+  int hi = numBlocks;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    const unsigned char* pos = dict->data + dict->blocks[mid];
+    int len = vbyte_decode(&pos, dict->data + dict->len);
+    if (dict_termCmp(pos, len, word) <= 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == 0) {
+    //word is before the first block, so the answer is its first word
+    const unsigned char* pos = dict->data;
+    int len = vbyte_decode(&pos, dict->data + dict->len);
+    memcpy(buf, pos, len);
+    buf[len] = '\0';
+    return 0;
+  }
+
+  //scans the block, which starts <= word
+  int block = lo - 1;
+  int term = block * DICT_BLOCK;
+  int end = (term + DICT_BLOCK < dict->numTerms) ? term + DICT_BLOCK : dict->numTerms;
+  const unsigned char* pos = dict->data + dict->blocks[block];
+  for (; term < end; term++) {
+    int shared = (term % DICT_BLOCK == 0) ? 0 : (int)vbyte_decode(&pos, dict->data + dict->len);
+    int rest = vbyte_decode(&pos, dict->data + dict->len);
+    memcpy(buf + shared, pos, rest);
+    buf[shared + rest] = '\0';
+    pos += rest;
+    if (strcmp(buf, word) >= 0) {
+      return term;
+    }
+  }
+
+  //the answer is the first word of the next block, if there is one
+  if (term < dict->numTerms) {
+    pos = dict->data + dict->blocks[block + 1];
+    int len = vbyte_decode(&pos, dict->data + dict->len);
+    memcpy(buf, pos, len);
+    buf[len] = '\0';
+  }
+  return term;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Compares a stored term of len bytes (not terminated) with word, as
+ * strcmp would.
+ */
+static int dict_termCmp(const unsigned char* term, const int len, const char* word) {
+  for (int i = 0; i < len; i++) {
+    unsigned char c = word[i];
+    if (c == '\0' || term[i] != c) {
+      return (term[i] > c) ? 1 : -1;
+    }
+  }
+  return (word[len] == '\0') ? 0 : -1;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Ensures there is room for extra more bytes of data.
+ */
+static bool dict_reserve(dict_t* dict, const int extra) {
+  if (dict->len + extra <= dict->cap) {
+    return true;
+  }
+
+  int cap = (dict->cap == 0) ? 256 : dict->cap * 2;
+  while (cap < dict->len + extra) {
+    cap *= 2;
+  }
+
+  unsigned char* data = realloc(dict->data, cap);
+  if (data == NULL) {
+    return false;
+  }
+  dict->data = data;
+  dict->cap = cap;
+  return true;
+}
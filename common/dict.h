@@ -0,0 +1,95 @@
+/*
+ * dict.h    Gretchen Kerfoot    Spring 2025
+ *
+ * This is the header file for the dict module.
+ * A dict is a sorted term dictionary: it maps each word to a term number
+ * (0, 1, 2, ... in strcmp order), which callers use to index their own
+ * arrays, such as the index's postings lists.
+ *
+ * Words are front coded in blocks of DICT_BLOCK: the first word of each
+ * block is stored whole, and each other word as the length of the prefix
+ * it shares with the word before it plus the rest of its bytes. A lookup
+ * binary searches the blocks' first words, then scans one block. Because
+ * the words are sorted, all words with a given prefix are a contiguous
+ * range of term numbers.
+ *
+ * Words must be added in increasing strcmp order, which is the order of
+ * the words in a binary index file.
+ */
+
+#ifndef __DICT_H
+#define __DICT_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+//number of words per front-coded block
+#define DICT_BLOCK 16
+
+//global types
+typedef struct dict dict_t;
+
+/*
+ * Creates a new, empty dictionary.
+ *
+ * Returns:
+ *   pointer to a new dict_t, or NULL if out of memory
+ * Caller is responsible for:
+ *   later calling dict_delete
+ */
+dict_t* dict_new(void);
+
+/*
+ * Adds a word at the end of the dictionary.
+ *
+ * Caller provides:
+ *   dict - valid dictionary
+ *   word - nonempty word, larger (by strcmp) than every word already added
+ * Returns:
+ *   the word's term number, or -1 if the word is out of order or out of
+ *   memory
+ */
+int dict_add(dict_t* dict, const char* word);
+
+/*
+ * Returns the number of words in the dictionary, or 0 if NULL.
+ */
+int dict_size(const dict_t* dict);
+
+/*
+ * Returns the term number of word, or -1 if it is not in the dictionary.
+ */
+int dict_find(const dict_t* dict, const char* word);
+
+/*
+ * Finds the range of words that start with prefix.
+ *
+ * Caller provides:
+ *   dict - valid dictionary
+ *   prefix - the prefix (the empty prefix matches every word)
+ *   first - where to store the term number of the first match
+ * Returns:
+ *   the number of matching words; they are *first, *first + 1, ...
+ */
+int dict_prefix(const dict_t* dict, const char* prefix, int* first);
+
+/*
+ * Calls itemfunc(arg, term, word) for terms first through last - 1,
+ * in order. The word is only valid during the call.
+ * Does nothing if dict or itemfunc is NULL, or the range is empty.
+ */
+void dict_range(const dict_t* dict, const int first, const int last, void* arg,
+                void (*itemfunc)(void* arg, const int term, const char* word));
+
+/*
+ * Returns the number of bytes of memory used by the dictionary, or 0 if
+ * NULL.
+ */
+size_t dict_memory(const dict_t* dict);
+
+/*
+ * Frees all memory used by the dictionary; ignores NULL.
+ */
+void dict_delete(dict_t* dict);
+
+#endif // __DICT_H
@@ -0,0 +1,686 @@
+/*
+ * doctable.c    Gretchen Kerfoot    Spring 2025
+ *
+ * Implementation of the doctable module.
+ * A table is in one of two forms. One being built (or changed) keeps
+ * growable arrays indexed by docID and a pool of URL strings, where
+ * replaced URLs are simply abandoned; saving writes only the live ones.
+ * One read by doctable_load points straight into the mapped file (see
+ * doctable.h for its layout), and is copied into the first form only if
+ * it is changed.
+ * A docwriter streams fixed-size records (docrecord_t) and the URLs to
+ * two temporary files, then reads the records back once per array of
+ * the file layout to assemble the table.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "doctable.h"
+
+#define DOCTABLE_MAGIC "TSEDOCS1"
+#define DOCTABLE_MAGIC_LEN 8
+#define DOCTABLE_HEADER (DOCTABLE_MAGIC_LEN + 2 * sizeof(uint32_t))
+#define NO_URL UINT32_MAX   //in-memory urls entry of a docID not recorded
+
+//private type for the table
+typedef struct doctable {
+  //mapped form: map is non-NULL, and the arrays point into it
+  void* map;                //the mapped file
+  size_t mapLen;            //bytes mapped
+  const uint32_t* offsets;  //numDocs + 1 URL boundaries in pool
+
+  //in-memory form: map is NULL
+  uint32_t* urls;           //start of each docID's URL in pool, or NO_URL
+  int cap;                  //docIDs allocated in urls, depths, lengths
+  char* poolBuf;            //growable pool
+  size_t poolLen;           //bytes of poolBuf in use
+  size_t poolCap;           //bytes of poolBuf allocated
+
+  //both forms; a mapped table's arrays are never written, since it is
+  //thawed into the in-memory form first
+  int32_t* depths;          //numDocs depths
+  uint32_t* lengths;        //numDocs lengths
+  const char* pool;         //URL strings
+  int numDocs;              //docIDs 0 .. numDocs - 1 have entries
+} doctable_t;
+
+//private type for the writer
+typedef struct docwriter {
+  char* filename;      //the table's file
+  char* recsFile;      //filename.recs
+  char* poolFile;      //filename.pool
+  FILE* recs;          //a docrecord_t for each docID from 0 on
+  FILE* pool;          //the URLs, in docID order
+  int numDocs;         //records written
+  uint64_t poolBytes;  //bytes written to pool
+} docwriter_t;
+
+//a docID's entry in the writer's records file
+typedef struct docrecord {
+  uint32_t urlBytes;   //size of its URL with its '\0', or 0 if none
+  int32_t depth;
+  uint32_t length;
+} docrecord_t;
+
+//records read back at once when assembling the table
+#define DOCWRITER_BATCH 1024
+
+//helper function prototypes
+static bool doctable_thaw(doctable_t* table);
+static bool doctable_grow(doctable_t* table, const int numDocs);
+static bool doctable_writeAll(FILE* fp, const void* data, const size_t len);
+static char* docwriter_path(const char* filename, const char* suffix);
+static bool docwriter_copyField(docwriter_t* writer, FILE* fp, const int field);
+
+
+/*
+ * Creates a new, empty table in the in-memory form.
+ *
+ * Returns:
+ *   pointer to new table, or NULL if out of memory
+ */
+doctable_t* doctable_new(void) {
+  doctable_t* table = malloc(sizeof(doctable_t));
+  if (table == NULL) {
+    return NULL;
+  }
+
+  table->map = NULL;
+  table->mapLen = 0;
+  table->offsets = NULL;
+  table->urls = NULL;
+  table->cap = 0;
+  table->poolBuf = NULL;
+  table->poolLen = 0;
+  table->poolCap = 0;
+  table->depths = NULL;
+  table->lengths = NULL;
+  table->pool = NULL;
+  table->numDocs = 0;
+  return table;
+}
+
+
+/*
+ * Grows the arrays to hold docIDs up to lastDoc.
+ *
+ * Returns:
+ *   true if success, false if invalid or out of memory
+ */
+bool doctable_reserve(doctable_t* table, const int lastDoc) {
+  if (table == NULL || lastDoc < 0) {
+    return false;
+  }
+  return doctable_thaw(table) && doctable_grow(table, lastDoc + 1);
+}
+
+
+/*
+ * Records a document, appending its URL to the pool.
+ *
+ * Returns:
+ *   true if success, false if invalid or out of memory
+ */
+bool doctable_set(doctable_t* table, const int docID, const char* url,
+                  const int depth, const int length) {
+  if (table == NULL || docID <= 0 || url == NULL) {
+    return false;
+  }
+  if (!doctable_thaw(table) || !doctable_grow(table, docID + 1)) {
+    return false;
+  }
+
+  size_t len = strlen(url) + 1;
+  if (table->poolLen + len > table->poolCap) {
+    size_t poolCap = (table->poolCap == 0) ? 4096 : table->poolCap * 2;
+    while (poolCap < table->poolLen + len) {
+      poolCap *= 2;
+    }
+    if (poolCap >= NO_URL) {
+      return false;
+    }
+    char* bigger = realloc(table->poolBuf, poolCap);
+    if (bigger == NULL) {
+      return false;
+    }
+    table->poolBuf = bigger;
+    table->poolCap = poolCap;
+    table->pool = bigger;
+  }
+
+  memcpy(table->poolBuf + table->poolLen, url, len);
+  table->urls[docID] = (uint32_t)table->poolLen;
+  table->poolLen += len;
+  table->depths[docID] = depth;
+  table->lengths[docID] = (length < 0) ? 0 : length;
+  return true;
+}
+
+
+/*
+ * Forgets a document by clearing its entry.
+ *
+ * Returns:
+ *   true if success, false if out of memory
+ */
+bool doctable_remove(doctable_t* table, const int docID) {
+  if (table == NULL) {
+    return false;
+  }
+  if (docID <= 0 || docID >= table->numDocs) {
+    return true;  //nothing recorded
+  }
+  if (!doctable_thaw(table)) {
+    return false;
+  }
+
+  table->urls[docID] = NO_URL;
+  table->depths[docID] = -1;
+  table->lengths[docID] = 0;
+  return true;
+}
+
+
+/*
+ * Looks up the URL of docID in whichever form the table is in.
+ */
+const char* doctable_url(const doctable_t* table, const int docID) {
+  if (table == NULL || docID <= 0 || docID >= table->numDocs) {
+    return NULL;
+  }
+  if (table->map != NULL) {
+    uint32_t start = table->offsets[docID];
+    return (start == table->offsets[docID + 1]) ? NULL : table->pool + start;
+  }
+  uint32_t start = table->urls[docID];
+  return (start == NO_URL) ? NULL : table->pool + start;
+}
+
+
+/*
+ * Looks up the depth of docID.
+ */
+int doctable_depth(const doctable_t* table, const int docID) {
+  if (table == NULL || docID <= 0 || docID >= table->numDocs) {
+    return -1;
+  }
+  return table->depths[docID];
+}
+
+
+/*
+ * Looks up the length of docID.
+ */
+int doctable_length(const doctable_t* table, const int docID) {
+  if (table == NULL || docID <= 0 || docID >= table->numDocs) {
+    return 0;
+  }
+  return (int)table->lengths[docID];
+}
+
+
+/*
+ * Finds the largest docID that has a URL.
+ */
+int doctable_lastDoc(const doctable_t* table) {
+  if (table == NULL) {
+    return 0;
+  }
+  for (int docID = table->numDocs - 1; docID > 0; docID--) {
+    if (doctable_url(table, docID) != NULL) {
+      return docID;
+    }
+  }
+  return 0;
+}
+
+
+/*
+ * Saves the table to filename, by way of a temporary file. The pool is
+ * rewritten in docID order with only the URLs still recorded.
+ *
+ * Returns:
+ *   true if success, false on error
+ */
+bool doctable_save(const doctable_t* table, const char* filename) {
+  if (table == NULL || filename == NULL) {
+    return false;
+  }
+
+  //trims entries past the last recorded docID
+  uint32_t numDocs = doctable_lastDoc(table);
+  numDocs = (numDocs == 0) ? 0 : numDocs + 1;
+
+  uint32_t* offsets = malloc((numDocs + 1) * sizeof(uint32_t));
+  char* tempFile = malloc(strlen(filename) + 5);
+  if (offsets == NULL || tempFile == NULL) {
+    free(offsets);
+    free(tempFile);
+    return false;
+  }
+
+  uint32_t poolBytes = 0;
+  for (uint32_t docID = 0; docID < numDocs; docID++) {
+    offsets[docID] = poolBytes;
+    const char* url = doctable_url(table, docID);
+    if (url != NULL) {
+      poolBytes += strlen(url) + 1;
+    }
+  }
+  offsets[numDocs] = poolBytes;
+
+  sprintf(tempFile, "%s.tmp", filename);
+  FILE* fp = fopen(tempFile, "wb");
+  if (fp == NULL) {
+    free(offsets);
+    free(tempFile);
+    return false;
+  }
+
+  bool ok = doctable_writeAll(fp, DOCTABLE_MAGIC, DOCTABLE_MAGIC_LEN) &&
+            doctable_writeAll(fp, &numDocs, sizeof(uint32_t)) &&
+            doctable_writeAll(fp, &poolBytes, sizeof(uint32_t)) &&
+            doctable_writeAll(fp, offsets, (numDocs + 1) * sizeof(uint32_t)) &&
+            doctable_writeAll(fp, table->depths, numDocs * sizeof(int32_t)) &&
+            doctable_writeAll(fp, table->lengths, numDocs * sizeof(uint32_t));
+  for (uint32_t docID = 0; ok && docID < numDocs; docID++) {
+    const char* url = doctable_url(table, docID);
+    if (url != NULL) {
+      ok = doctable_writeAll(fp, url, strlen(url) + 1);
+    }
+  }
+  if (fclose(fp) != 0) {
+    ok = false;
+  }
+
+  if (ok) {
+    ok = (rename(tempFile, filename) == 0);
+  } else {
+    remove(tempFile);
+  }
+  free(offsets);
+  free(tempFile);
+  return ok;
+}
+
+
+/*
+ * Maps filename into memory and checks that its sizes and offsets are
+ * consistent, so that lookups need no further checks.
+ *
+ * Returns:
+ *   pointer to new table, or NULL on error
+ */
+doctable_t* doctable_load(const char* filename) {
+  if (filename == NULL) {
+    return NULL;
+  }
+
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) {
+    return NULL;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < DOCTABLE_HEADER + sizeof(uint32_t)) {
+    close(fd);
+    return NULL;
+  }
+  size_t mapLen = st.st_size;
+  void* map = mmap(NULL, mapLen, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);  //the mapping stays valid
+  if (map == MAP_FAILED) {
+    return NULL;
+  }
+
+  const char* base = map;
+  uint32_t numDocs, poolBytes;
+  memcpy(&numDocs, base + DOCTABLE_MAGIC_LEN, sizeof(uint32_t));
+  memcpy(&poolBytes, base + DOCTABLE_MAGIC_LEN + sizeof(uint32_t), sizeof(uint32_t));
+
+  //the sizes must add up to the file's size exactly
+  bool ok = memcmp(base, DOCTABLE_MAGIC, DOCTABLE_MAGIC_LEN) == 0 &&
+            numDocs < INT32_MAX / 16 &&
+            DOCTABLE_HEADER + (3 * (uint64_t)numDocs + 1) * sizeof(uint32_t)
+            + poolBytes == mapLen;
+
+  const uint32_t* offsets = (const uint32_t*)(base + DOCTABLE_HEADER);
+  const char* pool = base + DOCTABLE_HEADER + (3 * (size_t)numDocs + 1) * sizeof(uint32_t);
+
+  //offsets must increase to poolBytes, and each URL end in '\0'
+  ok = ok && offsets[0] == 0 && offsets[numDocs] == poolBytes;
+  for (uint32_t docID = 0; ok && docID < numDocs; docID++) {
+    ok = offsets[docID] <= offsets[docID + 1] &&
+         (offsets[docID] == offsets[docID + 1] || pool[offsets[docID + 1] - 1] == '\0');
+  }
+
+  doctable_t* table = ok ? doctable_new() : NULL;
+  if (table == NULL) {
+    munmap(map, mapLen);
+    return NULL;
+  }
+  table->map = map;
+  table->mapLen = mapLen;
+  table->offsets = offsets;
+  table->depths = (int32_t*)(offsets + numDocs + 1);
+  table->lengths = (uint32_t*)(table->depths + numDocs);
+  table->pool = pool;
+  table->numDocs = numDocs;
+  return table;
+}
+
+
+/*
+ * Frees all memory used by the table.
+ */
+void doctable_delete(doctable_t* table) {
+  if (table == NULL) return;
+
+  if (table->map != NULL) {
+    munmap(table->map, table->mapLen);
+  } else {
+    free(table->urls);
+    free(table->depths);
+    free(table->lengths);
+    free(table->poolBuf);
+  }
+  free(table);
+}
+
+
+/*
+ * Creates the writer's temporary files.
+ *
+ * Returns:
+ *   pointer to new writer, or NULL on error
+ */
+docwriter_t* docwriter_new(const char* filename) {
+  if (filename == NULL) {
+    return NULL;
+  }
+  docwriter_t* writer = malloc(sizeof(docwriter_t));
+  if (writer == NULL) {
+    return NULL;
+  }
+
+  writer->filename = docwriter_path(filename, "");
+  writer->recsFile = docwriter_path(filename, ".recs");
+  writer->poolFile = docwriter_path(filename, ".pool");
+  writer->recs = (writer->recsFile != NULL) ? fopen(writer->recsFile, "w+b") : NULL;
+  writer->pool = (writer->poolFile != NULL) ? fopen(writer->poolFile, "w+b") : NULL;
+  writer->numDocs = 0;
+  writer->poolBytes = 0;
+  if (writer->filename == NULL || writer->recs == NULL || writer->pool == NULL) {
+    docwriter_delete(writer);
+    return NULL;
+  }
+  return writer;
+}
+
+
+/*
+ * Writes empty records for any docIDs skipped, then docID's record and
+ * its URL.
+ *
+ * Returns:
+ *   true if success, false if invalid or on write error
+ */
+bool docwriter_add(docwriter_t* writer, const int docID, const char* url,
+                   const int depth, const int length) {
+  if (writer == NULL || docID < writer->numDocs || docID <= 0 || url == NULL) {
+    return false;
+  }
+
+  docrecord_t empty = { 0, -1, 0 };
+  for (; writer->numDocs < docID; writer->numDocs++) {
+    if (!doctable_writeAll(writer->recs, &empty, sizeof(docrecord_t))) {
+      return false;
+    }
+  }
+
+  size_t len = strlen(url) + 1;
+  docrecord_t record = { (uint32_t)len, depth, (length < 0) ? 0 : length };
+  if (writer->poolBytes + len >= NO_URL ||
+      !doctable_writeAll(writer->recs, &record, sizeof(docrecord_t)) ||
+      !doctable_writeAll(writer->pool, url, len)) {
+    return false;
+  }
+  writer->numDocs++;
+  writer->poolBytes += len;
+  return true;
+}
+
+
+/*
+ * Assembles the table in filename.tmp and renames it over filename: the
+ * header, then the offsets, depths, and lengths, each from one pass over
+ * the records, then a copy of the pool.
+ *
+ * Returns:
+ *   true if success, false on error
+ */
+bool docwriter_finish(docwriter_t* writer) {
+  if (writer == NULL || fflush(writer->recs) != 0 || fflush(writer->pool) != 0) {
+    return false;
+  }
+
+  char* tempFile = docwriter_path(writer->filename, ".tmp");
+  FILE* fp = (tempFile != NULL) ? fopen(tempFile, "wb") : NULL;
+  if (fp == NULL) {
+    free(tempFile);
+    return false;
+  }
+
+  uint32_t numDocs = writer->numDocs;
+  uint32_t poolBytes = (uint32_t)writer->poolBytes;
+  bool ok = numDocs < INT32_MAX / 16 &&
+            doctable_writeAll(fp, DOCTABLE_MAGIC, DOCTABLE_MAGIC_LEN) &&
+            doctable_writeAll(fp, &numDocs, sizeof(uint32_t)) &&
+            doctable_writeAll(fp, &poolBytes, sizeof(uint32_t));
+  for (int field = 0; ok && field < 3; field++) {
+    ok = docwriter_copyField(writer, fp, field);
+  }
+
+  //copies the pool
+  char buf[BUFSIZ];
+  size_t n;
+  rewind(writer->pool);
+  while (ok && (n = fread(buf, 1, sizeof(buf), writer->pool)) > 0) {
+    ok = doctable_writeAll(fp, buf, n);
+  }
+  ok = ok && !ferror(writer->pool);
+  if (fclose(fp) != 0) {
+    ok = false;
+  }
+
+  if (ok) {
+    ok = (rename(tempFile, writer->filename) == 0);
+  } else {
+    remove(tempFile);
+  }
+  free(tempFile);
+  return ok;
+}
+
+
+/*
+ * Closes and removes the temporary files, and frees the writer.
+ */
+void docwriter_delete(docwriter_t* writer) {
+  if (writer == NULL) return;
+
+  if (writer->recs != NULL) {
+    fclose(writer->recs);
+    remove(writer->recsFile);
+  }
+  if (writer->pool != NULL) {
+    fclose(writer->pool);
+    remove(writer->poolFile);
+  }
+  free(writer->filename);
+  free(writer->recsFile);
+  free(writer->poolFile);
+  free(writer);
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Converts a mapped table to the in-memory form, so it can be changed;
+ * does nothing to a table already in memory.
+ *
+ * Returns:
+ *   true if success, false if out of memory (the table is unchanged)
+ */
+static bool doctable_thaw(doctable_t* table) {
+  if (table->map == NULL) {
+    return true;
+  }
+
+  int numDocs = table->numDocs;
+  size_t poolBytes = table->offsets[numDocs];
+  int cap = (numDocs < 16) ? 16 : numDocs;
+  uint32_t* urls = malloc(cap * sizeof(uint32_t));
+  int32_t* depths = malloc(cap * sizeof(int32_t));
+  uint32_t* lengths = malloc(cap * sizeof(uint32_t));
+  char* poolBuf = malloc(poolBytes + 1);
+  if (urls == NULL || depths == NULL || lengths == NULL || poolBuf == NULL) {
+    free(urls);
+    free(depths);
+    free(lengths);
+    free(poolBuf);
+    return false;
+  }
+
+  for (int docID = 0; docID < numDocs; docID++) {
+    bool present = table->offsets[docID] != table->offsets[docID + 1];
+    urls[docID] = present ? table->offsets[docID] : NO_URL;
+  }
+  memcpy(depths, table->depths, numDocs * sizeof(int32_t));
+  memcpy(lengths, table->lengths, numDocs * sizeof(uint32_t));
+  memcpy(poolBuf, table->pool, poolBytes);
+
+  munmap(table->map, table->mapLen);
+  table->map = NULL;
+  table->mapLen = 0;
+  table->offsets = NULL;
+  table->urls = urls;
+  table->cap = cap;
+  table->poolBuf = poolBuf;
+  table->poolLen = poolBytes;
+  table->poolCap = poolBytes + 1;
+  table->depths = depths;
+  table->lengths = lengths;
+  table->pool = poolBuf;
+  return true;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Ensures an in-memory table has entries for docIDs 0 .. numDocs - 1,
+ * new ones recording nothing.
+ */
+static bool doctable_grow(doctable_t* table, const int numDocs) {
+  if (numDocs > table->cap) {
+    int cap = (table->cap == 0) ? 16 : table->cap * 2;
+    while (cap < numDocs) {
+      cap *= 2;
+    }
+
+    uint32_t* urls = realloc(table->urls, cap * sizeof(uint32_t));
+    if (urls == NULL) {
+      return false;
+    }
+    table->urls = urls;
+    int32_t* depths = realloc(table->depths, cap * sizeof(int32_t));
+    if (depths == NULL) {
+      return false;
+    }
+    table->depths = depths;
+    uint32_t* lengths = realloc(table->lengths, cap * sizeof(uint32_t));
+    if (lengths == NULL) {
+      return false;
+    }
+    table->lengths = lengths;
+    table->cap = cap;
+  }
+
+  for (int docID = table->numDocs; docID < numDocs; docID++) {
+    table->urls[docID] = NO_URL;
+    table->depths[docID] = -1;
+    table->lengths[docID] = 0;
+  }
+  if (numDocs > table->numDocs) {
+    table->numDocs = numDocs;
+  }
+  return true;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Writes len bytes to fp; true if all were written.
+ */
+static bool doctable_writeAll(FILE* fp, const void* data, const size_t len) {
+  return len == 0 || fwrite(data, 1, len, fp) == len;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Returns a new string filename followed by suffix, or NULL if out of
+ * memory.
+ */
+static char* docwriter_path(const char* filename, const char* suffix) {
+  char* path = malloc(strlen(filename) + strlen(suffix) + 1);
+  if (path != NULL) {
+    sprintf(path, "%s%s", filename, suffix);
+  }
+  return path;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Reads the writer's records back from the start and writes one array
+ * of the file layout to fp: field 0 is the offsets (with the final one,
+ * the pool's size), 1 the depths, and 2 the lengths.
+ *
+ * Returns:
+ *   true if success, false on error
+ */
+static bool docwriter_copyField(docwriter_t* writer, FILE* fp, const int field) {
+  docrecord_t records[DOCWRITER_BATCH];
+  uint32_t values[DOCWRITER_BATCH];
+  uint32_t offset = 0;
+  size_t n;
+
+  rewind(writer->recs);
+  while ((n = fread(records, sizeof(docrecord_t), DOCWRITER_BATCH, writer->recs)) > 0) {
+    for (size_t i = 0; i < n; i++) {
+      if (field == 0) {
+        values[i] = offset;
+        offset += records[i].urlBytes;
+      } else if (field == 1) {
+        memcpy(&values[i], &records[i].depth, sizeof(int32_t));
+      } else {
+        values[i] = records[i].length;
+      }
+    }
+    if (!doctable_writeAll(fp, values, n * sizeof(uint32_t))) {
+      return false;
+    }
+  }
+  if (ferror(writer->recs)) {
+    return false;
+  }
+  return field != 0 || doctable_writeAll(fp, &offset, sizeof(uint32_t));
+}
@@ -0,0 +1,176 @@
+/*
+ * doctable.h    Gretchen Kerfoot    Spring 2025
+ *
+ * This is the header file for the doctable module.
+ * A doctable holds what the querier needs to know about each document to
+ * print a result: its URL, its crawl depth, and its length in indexed
+ * words. The indexer saves one beside every index file it writes
+ * (indexFilename.docs), so the querier never has to open page files.
+ *
+ * The file is laid out to be used in place after mmap, without parsing:
+ *   "TSEDOCS1" magic
+ *   uint32 numDocs        entries for docIDs 0 .. numDocs - 1
+ *   uint32 poolBytes      size of the string pool
+ *   uint32 offsets[numDocs + 1]
+ *                         docID d's URL is pool[offsets[d]] up to its
+ *                         '\0'; it has none if offsets[d] == offsets[d + 1]
+ *   int32  depths[numDocs]
+ *   uint32 lengths[numDocs]
+ *   char   pool[poolBytes]
+ * Numbers are in the machine's native byte order, so a table is read
+ * only on the kind of machine that wrote it.
+ *
+ * A docwriter writes the same file without holding the table in memory,
+ * for documents recorded in increasing docID order: each one goes
+ * straight to temporary files beside it, which are assembled into the
+ * table at the end.
+ */
+
+#ifndef __DOCTABLE_H
+#define __DOCTABLE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+//global types
+typedef struct doctable doctable_t;
+typedef struct docwriter docwriter_t;
+
+/*
+ * Creates a new, empty table.
+ *
+ * Returns:
+ *   pointer to a new doctable_t, or NULL if out of memory
+ * Caller is responsible for:
+ *   later calling doctable_delete
+ */
+doctable_t* doctable_new(void);
+
+/*
+ * Makes room for docIDs up to lastDoc, so that recording them does not
+ * have to grow the table, as when the number of pages is known ahead.
+ *
+ * Returns:
+ *   true if successful, false if arguments are invalid or out of memory
+ */
+bool doctable_reserve(doctable_t* table, const int lastDoc);
+
+/*
+ * Records a document, replacing anything recorded for its docID.
+ *
+ * Caller provides:
+ *   table - valid table
+ *   docID - positive docID
+ *   url - the page's URL
+ *   depth - the page's crawl depth
+ *   length - the number of words indexed from the page
+ * Returns:
+ *   true if successful, false if arguments are invalid or out of memory
+ * Notes:
+ *   A table read by doctable_load is copied into memory the first time
+ *   it is changed.
+ */
+bool doctable_set(doctable_t* table, const int docID, const char* url,
+                  const int depth, const int length);
+
+/*
+ * Forgets a document, as when its page file has disappeared.
+ *
+ * Returns:
+ *   true if successful (or docID was not recorded), false if out of memory
+ */
+bool doctable_remove(doctable_t* table, const int docID);
+
+/*
+ * Returns the URL of docID, owned by the table, or NULL if not recorded.
+ */
+const char* doctable_url(const doctable_t* table, const int docID);
+
+/*
+ * Returns the crawl depth of docID, or -1 if not recorded.
+ */
+int doctable_depth(const doctable_t* table, const int docID);
+
+/*
+ * Returns the number of words indexed from docID, or 0 if not recorded.
+ */
+int doctable_length(const doctable_t* table, const int docID);
+
+/*
+ * Returns the largest docID recorded, or 0 if none.
+ */
+int doctable_lastDoc(const doctable_t* table);
+
+/*
+ * Saves the table to a file.
+ *
+ * Caller provides:
+ *   table - valid table
+ *   filename - path to a writable file
+ * Returns:
+ *   true if successful, false on error
+ * Notes:
+ *   The table is written to filename.tmp and renamed over filename, so a
+ *   reader never sees a partially written file.
+ */
+bool doctable_save(const doctable_t* table, const char* filename);
+
+/*
+ * Loads a table saved by doctable_save by mapping the file into memory.
+ *
+ * Returns:
+ *   pointer to a new doctable_t, or NULL if the file cannot be read or
+ *   is not a saved table
+ * Notes:
+ *   Lookups read the mapped file directly; nothing is parsed or copied.
+ */
+doctable_t* doctable_load(const char* filename);
+
+/*
+ * Frees all memory used by the table, unmapping its file; ignores NULL.
+ */
+void doctable_delete(doctable_t* table);
+
+/*
+ * Starts writing a table to a file, document by document.
+ *
+ * Caller provides:
+ *   filename - path to a writable file
+ * Returns:
+ *   pointer to a new docwriter_t, or NULL if its temporary files
+ *   (filename.recs and filename.pool) cannot be created or out of memory
+ * Caller is responsible for:
+ *   later calling docwriter_delete
+ */
+docwriter_t* docwriter_new(const char* filename);
+
+/*
+ * Records a document, as doctable_set would.
+ *
+ * Caller provides:
+ *   writer - valid writer
+ *   docID - docID larger than any already recorded
+ *   url, depth, length - as for doctable_set
+ * Returns:
+ *   true if successful, false if arguments are invalid or on write error
+ */
+bool docwriter_add(docwriter_t* writer, const int docID, const char* url,
+                   const int depth, const int length);
+
+/*
+ * Writes the table of the documents recorded to the writer's file, as
+ * doctable_save would, reading back its temporary files a buffer at a
+ * time.
+ *
+ * Returns:
+ *   true if successful, false on error
+ */
+bool docwriter_finish(docwriter_t* writer);
+
+/*
+ * Removes the writer's temporary files and frees it; ignores NULL. A
+ * table not finished is never written.
+ */
+void docwriter_delete(docwriter_t* writer);
+
+#endif // __DOCTABLE_H
@@ -2,33 +2,147 @@
  * index.c    Gretchen Kerfoot    Spring 2025
  *
  * This module implements the index type for the TSE.
- * It supports creating a new index, inserting words and docIDs, 
- * saving an index to a file, loading it from a file, deleting it, and 
- * looking up the counters for a given word in the index.
+ * It supports creating a new index, inserting words and docIDs,
+ * saving an index to a file, loading it from a file, deleting it, and
+ * looking up the postings for a given word in the index.
  *
- * Each word maps to a counters_t structure, which maps docIDs to counts.
+ * Each word maps to a plist_t structure, a compressed list of
+ * (docID, count) pairs sorted by docID.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include "index.h"
 #include "hashtable.h"
-#include "counters.h"
+#include "hash.h"
+#include "plist.h"
+#include "vbyte.h"
+#include "bitset.h"
+#include "dict.h"
 #include "file.h"
-#include "memory.h"
 
-//helper function prototypes
-void index_save_helper(void* fp, const char* word, void* item);
-void index_counter_print(void* fp, const int docID, const int count);
+//magic string at the start of a binary index file; version 2 files
+//store words whole, version 1 files also have no metadata section, and
+//both are still accepted
+#define INDEX_MAGIC "TSEINDX3"
+#define INDEX_MAGIC_V2 "TSEINDX2"
+#define INDEX_MAGIC_V1 "TSEINDX1"
+#define INDEX_MAGIC_LEN 8
+#define INDEX_VERSION 3
+
+//suffix of the tombstone file kept beside an index file
+#define INDEX_TOMBSTONES ".deleted"
+
+//estimated bytes of hashtable bookkeeping per word, beyond the key itself
+#define INDEX_WORD_OVERHEAD 64
+
+//most runs index_merge has open at once; more are merged in passes
+#define INDEX_MERGE_FANIN 64
+
+//index metadata: which docIDs the index covers, and when it was built
+typedef struct index_meta {
+  int* ranges;         //first, last, first, last, ... sorted and disjoint
+  int numRanges;       //number of (first, last) ranges
+  int rangeCap;        //number of ranges allocated
+  time_t time;         //when the covered pages were read, 0 if unknown
+  int version;         //format version of the file it was read from
+} index_meta_t;
 
 //private type for the index
 typedef struct index {
-  hashtable_t* table;  //maps word (char*) -> counters_t*
+  hashtable_t* table;  //maps word (char*) -> plist_t*, while building
+  dict_t* dict;        //sorted words of a loaded index, NULL while building
+  plist_t** postings;  //postings of each dict term
+  int postingsCap;     //number of postings pointers allocated
+  int numWords;        //number of distinct words
+  size_t memory;       //estimated bytes used by words and postings
+  index_meta_t meta;   //docIDs covered and build time
+  bitset_t* removed;   //tombstoned docIDs, NULL if none
 } index_t;
 
+//one (word, postings) pair, used to write words in sorted order
+typedef struct index_entry {
+  const char* word;
+  plist_t* postings;
+} index_entry_t;
+
+//a callback on (word, postings), carried through dict_range and 
+//hashtable_iterate
+typedef struct index_visit {
+  index_t* index;
+  const char* prefix;  //only words with this prefix are visited, if not NULL
+  int count;           //number of words visited
+  void* arg;
+  void (*itemfunc)(void* arg, const char* word, plist_t* postings);
+} index_visit_t;
+
+//an output binary index file, written in word order
+typedef struct index_writer {
+  FILE* fp;
+  char* prev;          //previous word written, for front coding
+  unsigned int prevCap;
+  bool ok;             //false once a write has failed
+} index_writer_t;
+
+//one input of a k-way merge: an open index file and its current record
+typedef struct index_run {
+  FILE* fp;
+  int version;         //format version of the file
+  char* word;          //current word
+  unsigned int wordCap;
+  plist_t* postings;   //postings for the current word, NULL once exhausted
+  int order;           //position in the list of runs, to break ties
+} index_run_t;
 
-/* 
+//growable array of (docID, count) pairs, used to load the text format
+typedef struct index_pairs {
+  int* pairs;  //docID, count, docID, count, ...
+  int num;     //number of pairs
+  int cap;     //number of pairs allocated
+} index_pairs_t;
+
+//helper function prototypes
+static index_entry_t* index_sorted(index_t* index);
+static void index_sorted_helper(void* arg, const char* word, void* item);
+static int index_entry_cmp(const void* a, const void* b);
+static bool index_iterateSorted(index_t* index, void* arg,
+                                void (*itemfunc)(void* arg, const char* word,
+                                                 plist_t* postings));
+static void index_dict_helper(void* arg, const int term, const char* word);
+static void index_prefix_helper(void* arg, const char* word, void* item);
+static void index_save_helper(void* arg, const char* word, plist_t* postings);
+static void index_saveText_helper(void* arg, const char* word, plist_t* postings);
+static void index_counter_print(void* fp, const int docID, const int count);
+static bool index_addTerm(index_t* index, const char* word, plist_t* postings);
+static bool index_freeze(index_t* index);
+static bool index_copyWord(char** buf, unsigned int* bufCap, const char* word,
+                           const unsigned int len);
+static bool index_metaCover(index_meta_t* meta, const int first, const int last);
+static bool index_metaCovers(const index_meta_t* meta, const int docID);
+static bool index_metaUnion(index_meta_t* meta, const index_meta_t* other);
+static bool index_writeHeader(FILE* fp, const index_meta_t* meta);
+static int index_readHeader(FILE* fp, index_meta_t* meta);
+static plist_t* index_combine(plist_t* old, const plist_t* delta,
+                              const int* replaced, const int numReplaced);
+static int index_docCmp(const void* a, const void* b);
+static bool index_writeEntry(index_writer_t* out, const char* word,
+                             const plist_t* postings);
+static int index_readEntry(FILE* fp, const int version, char** word,
+                           unsigned int* wordCap, plist_t** postings);
+static bool index_mergeRuns(char* const runFiles[], const int numRuns,
+                            const char* filename);
+static void index_removeRuns(char** runFiles, const int numRuns);
+static bool index_runAdvance(index_run_t* run);
+static int index_runCmp(const index_run_t* a, const index_run_t* b);
+static void index_heapDown(index_run_t** heap, const int n, int i);
+static bool index_loadBinary(index_t* index, FILE* fp);
+static bool index_loadText(index_t* index, FILE* fp);
+static char* index_tombstoneFile(const char* filename);
+
+
+/*
  * Creates a new index with the given number of slots.
  *
  * Caller provides:
@@ -47,45 +161,135 @@ index_t* index_new(const int numSlots) {
     free(index);
     return NULL;
   }
+  index->dict = NULL;
+  index->postings = NULL;
+  index->postingsCap = 0;
+  index->numWords = 0;
+  index->memory = sizeof(index_t);
+  index->meta.ranges = NULL;
+  index->meta.numRanges = 0;
+  index->meta.rangeCap = 0;
+  index->meta.time = 0;
+  index->meta.version = INDEX_VERSION;
+  index->removed = NULL;
 
   return index;
 }
 
 /*
  * Inserts word for a given docID into the index.
- * If word is new, allocates a new counters set.
+ * If word is new, allocates a new postings list.
  * If docID exists, increments its count.
  *
  * Returns:
  *   true if success, false if error
  */
 bool index_insert(index_t* index, const char* word, const int docID) {
-  if (index == NULL || word == NULL || docID <= 0) {
+  if (word == NULL) {
+    return false;
+  }
+  return index_insertHashed(index, word, hash_bytes(word, strlen(word)), docID);
+}
+
+
+/*
+ * Inserts word, whose hash is given, for a given docID into the index;
+ * the hash serves both to find the word and to insert it if new.
+ *
+ * Returns:
+ *   true if success, false if error
+ */
+bool index_insertHashed(index_t* index, const char* word, const uint64_t hash,
+                        const int docID) {
+  if (index == NULL || word == NULL || docID <= 0 || index->table == NULL) {
     return false;
   }
 
-  counters_t* ctrs = hashtable_find(index->table, word);
+  plist_t* postings = hashtable_findHashed(index->table, word, hash);
 
-  if (ctrs == NULL) {
-    //word not in index yet--allocates new counters set
-    ctrs = counters_new();
-    if (ctrs == NULL) {
+  if (postings == NULL) {
+    //word not in index yet--allocates new postings list
+    postings = plist_new();
+    if (postings == NULL) {
       return false; //memory error
     }
 
-    if (!hashtable_insert(index->table, word, ctrs)) {
-      counters_delete(ctrs); //cleanup
+    if (!hashtable_insertHashed(index->table, word, hash, postings)) {
+      plist_delete(postings); //cleanup
       return false;
     }
+    index->numWords++;
+    index->memory += strlen(word) + 1 + INDEX_WORD_OVERHEAD + plist_memory(postings);
   }
 
-  counters_add(ctrs, docID);
-  return true;
+  size_t before = plist_memory(postings);
+  bool ok = plist_add(postings, docID);
+  index->memory += plist_memory(postings) - before;
+  return ok;
+}
+
+
+/*
+ * Records that docIDs first..last have been indexed.
+ *
+ * Returns:
+ *   true if success, false if invalid or out of memory
+ */
+bool index_cover(index_t* index, const int first, const int last) {
+  if (index == NULL || first <= 0 || last < first) {
+    return false;
+  }
+  return index_metaCover(&index->meta, first, last);
+}
+
+
+/*
+ * Returns true if docID has been recorded as indexed.
+ */
+bool index_covers(index_t* index, const int docID) {
+  return index != NULL && index_metaCovers(&index->meta, docID);
+}
+
+
+/*
+ * Returns the largest docID covered by the index, 0 if none.
+ */
+int index_lastDoc(index_t* index) {
+  if (index == NULL || index->meta.numRanges == 0) {
+    return 0;
+  }
+  return index->meta.ranges[2 * index->meta.numRanges - 1];
+}
+
+
+/*
+ * Returns the time at which the index's pages were read, 0 if unknown.
+ */
+time_t index_time(index_t* index) {
+  return (index == NULL) ? 0 : index->meta.time;
+}
+
+
+/*
+ * Sets the time at which the index's pages were read.
+ */
+void index_setTime(index_t* index, const time_t time) {
+  if (index != NULL) {
+    index->meta.time = time;
+  }
+}
+
+
+/*
+ * Returns estimated memory used by the index, in bytes.
+ */
+size_t index_memory(index_t* index) {
+  return (index == NULL) ? 0 : index->memory;
 }
 
 
-/* 
- * Saves the index to a file in the required format.
+/*
+ * Saves the index to a file in the compressed binary format.
  *
  * Returns:
  *   true if successful, false if error
@@ -95,108 +299,1273 @@ bool index_save(index_t* index, const char* filename) {
     return false;
   }
 
-  FILE* fp = fopen(filename, "w");
+  FILE* fp = fopen(filename, "wb");
   if (fp == NULL) {
     return false;
   }
 
-  hashtable_iterate(index->table, fp, index_save_helper);
-  fclose(fp);
-  return true;
+  index_writer_t out = { fp, NULL, 0, true };
+  out.ok = index_writeHeader(fp, &index->meta) &&
+           index_iterateSorted(index, &out, index_save_helper) &&
+           out.ok && vbyte_write(fp, 0);
+
+  free(out.prev);
+  if (fclose(fp) != 0) {
+    out.ok = false;
+  }
+  return out.ok;
 }
 
 
-/* 
- * HELPER FUNCTION
- * Called for each word in the hashtable.
- * Prints the word, then its docID/count pairs from counters.
+/*
+ * Merges binary index files whose docID ranges do not overlap into one.
+ * At most INDEX_MERGE_FANIN runs are merged at once: while there are
+ * more, each pass merges consecutive groups of them into intermediate
+ * runs (filename.passP.G), which are removed once the next pass has
+ * read them. So open files and memory stay bounded however many runs 
+ * there are. The final merge goes to a temporary file that is renamed
+ * over filename only once it is complete.
+ *
+ * Returns:
+ *   true if successful, false if error (filename is then unchanged)
  */
-void index_save_helper(void* fp, const char* word, void* item) {
-  if (fp == NULL || word == NULL || item == NULL) {
-    return;
+bool index_merge(char* const runFiles[], const int numRuns, const char* filename) {
+  if (runFiles == NULL || numRuns <= 0 || filename == NULL) {
+    return false;
   }
 
-  fprintf((FILE*)fp, "%s", word);
-  counters_t* ctrs = item;
+  //the caller's runs are inputs to the first pass, but never removed
+  char* const* inputs = runFiles;
+  char** passFiles = NULL;
+  int numInputs = numRuns;
+  bool ok = true;
+
+  for (int pass = 0; ok && numInputs > INDEX_MERGE_FANIN; pass++) {
+    int numOutputs = (numInputs + INDEX_MERGE_FANIN - 1) / INDEX_MERGE_FANIN;
+    char** outputs = calloc(numOutputs, sizeof(char*));
+    ok = (outputs != NULL);
+    for (int g = 0; ok && g < numOutputs; g++) {
+      int first = g * INDEX_MERGE_FANIN;
+      int count = (numInputs - first < INDEX_MERGE_FANIN) ? numInputs - first
+                                                          : INDEX_MERGE_FANIN;
+      outputs[g] = malloc(strlen(filename) + 32);
+      ok = (outputs[g] != NULL);
+      if (ok) {
+        sprintf(outputs[g], "%s.pass%d.%d", filename, pass, g);
+        ok = index_mergeRuns(inputs + first, count, outputs[g]);
+      }
+    }
+    index_removeRuns(passFiles, numInputs);
+    passFiles = outputs;
+    inputs = outputs;
+    numInputs = numOutputs;
+  }
 
-  counters_iterate(ctrs, fp, index_counter_print);
-  fprintf((FILE*)fp, "\n");
+  char* tempFile = malloc(strlen(filename) + 5);
+  ok = ok && (tempFile != NULL);
+  if (ok) {
+    sprintf(tempFile, "%s.tmp", filename);
+    ok = index_mergeRuns(inputs, numInputs, tempFile);
+    if (ok) {
+      ok = (rename(tempFile, filename) == 0);
+    }
+    if (!ok) {
+      remove(tempFile);
+    }
+  }
+  free(tempFile);
+  index_removeRuns(passFiles, numInputs);
+  return ok;
 }
 
 
-/* 
+/*
  * HELPER FUNCTION
- * Called for each docID/count in a counters set.
- * Prints " docID count".
+ * Merges runs into the binary index file filename, all at once. Each 
+ * input is sorted by word, so a k-way merge on a heap of the inputs' 
+ * current words produces the output in sorted order while holding only
+ * one record per input in memory.
+ *
+ * Returns:
+ *   true if successful, false if error
  */
-void index_counter_print(void* fp, const int docID, const int count) {
-  fprintf((FILE*)fp, " %d %d", docID, count);
+static bool index_mergeRuns(char* const runFiles[], const int numRuns,
+                            const char* filename) {
+  index_run_t* runs = calloc(numRuns, sizeof(index_run_t));
+  index_run_t** heap = calloc(numRuns, sizeof(index_run_t*));
+  index_writer_t out = { fopen(filename, "wb"), NULL, 0, true };
+  bool ok = (runs != NULL && heap != NULL && out.fp != NULL);
+
+  //the merged index covers every run's docIDs, and is as old as the oldest
+  index_meta_t meta = { NULL, 0, 0, 0, 0 };
+  index_meta_t runMeta = { NULL, 0, 0, 0, 0 };
+
+  //opens each run and reads its header and first record
+  int n = 0;
+  for (int i = 0; ok && i < numRuns; i++) {
+    runs[i].order = i;
+    runs[i].fp = fopen(runFiles[i], "rb");
+    ok = runs[i].fp != NULL &&
+         index_readHeader(runs[i].fp, &runMeta) == 1 &&
+         index_metaUnion(&meta, &runMeta);
+    runs[i].version = runMeta.version;
+    ok = ok && index_runAdvance(&runs[i]);
+    if (ok && (i == 0 || runMeta.time < meta.time)) {
+      meta.time = runMeta.time;
+    }
+    if (ok && runs[i].postings != NULL) {
+      heap[n++] = &runs[i];
+    }
+  }
+  free(runMeta.ranges);
+  for (int i = n / 2 - 1; ok && i >= 0; i--) {
+    index_heapDown(heap, n, i);
+  }
+
+  ok = ok && index_writeHeader(out.fp, &meta);
+  free(meta.ranges);
+
+  char* word = NULL;
+  unsigned int wordCap = 0;
+  while (ok && n > 0) {
+    //takes the smallest word; equal words come out in run order
+    index_run_t* top = heap[0];
+    ok = index_copyWord(&word, &wordCap, top->word, strlen(top->word));
+    plist_t* merged = top->postings;
+    top->postings = NULL;
+
+    do {
+      if (heap[0]->postings != NULL) {
+        ok = ok && plist_concat(merged, heap[0]->postings);
+        plist_delete(heap[0]->postings);
+        heap[0]->postings = NULL;
+      }
+      ok = ok && index_runAdvance(heap[0]);
+      if (heap[0]->postings == NULL) {
+        heap[0] = heap[--n];  //run is exhausted
+      }
+      if (n > 0) {
+        index_heapDown(heap, n, 0);
+      }
+    } while (ok && n > 0 && strcmp(heap[0]->word, word) == 0);
+
+    ok = ok && index_writeEntry(&out, word, merged);
+    plist_delete(merged);
+  }
+  free(word);
+
+  ok = ok && vbyte_write(out.fp, 0);
+
+  //cleans up
+  free(out.prev);
+  if (out.fp != NULL && fclose(out.fp) != 0) {
+    ok = false;
+  }
+  for (int i = 0; runs != NULL && i < numRuns; i++) {
+    if (runs[i].fp != NULL) {
+      fclose(runs[i].fp);
+    }
+    free(runs[i].word);
+    plist_delete(runs[i].postings);
+  }
+  free(runs);
+  free(heap);
+  return ok;
 }
 
 
-/* 
- * Loads an index from a file, making assumption that file format is correct
+/*
+ * Rewrites an index file with the postings of a delta index applied.
+ * The old file is streamed in word order alongside the delta's sorted
+ * words; the result goes to a temporary file that is renamed over the 
+ * old one only once it is complete.
  *
  * Returns:
- *   pointer to index if successful, or NULL if error
+ *   true if successful, false if error (the old file is then unchanged)
  */
-index_t* index_load(const char* filename) {
-  if (filename == NULL) {
-    return NULL;
+bool index_update(const char* filename, index_t* delta,
+                  const int* replaced, const int numReplaced) {
+  if (filename == NULL || delta == NULL || numReplaced < 0 ||
+      (numReplaced > 0 && replaced == NULL)) {
+    return false;
   }
 
-  FILE* fp = fopen(filename, "r");
-  if (fp == NULL) {
+  //the delta's words, in sorted order, to merge with the old file's
+  index_entry_t* entries = index_sorted(delta);
+  if (entries == NULL) {
+    return false;
+  }
+
+  char* tempFile = malloc(strlen(filename) + 5);
+  FILE* in = fopen(filename, "rb");
+  index_writer_t out = { NULL, NULL, 0, true };
+  index_meta_t meta = { NULL, 0, 0, 0, 0 };
+  bool ok = (tempFile != NULL && in != NULL &&
+             index_readHeader(in, &meta) == 1 &&
+             index_metaUnion(&meta, &delta->meta));
+  if (ok) {
+    meta.time = delta->meta.time;
+    sprintf(tempFile, "%s.tmp", filename);
+    out.fp = fopen(tempFile, "wb");
+    ok = (out.fp != NULL) && index_writeHeader(out.fp, &meta);
+  }
+
+  char* word = NULL;
+  unsigned int wordCap = 0;
+  plist_t* postings = NULL;
+  int status = ok ? index_readEntry(in, meta.version, &word, &wordCap, &postings) : -1;
+  int next = 0;  //next delta entry
+
+  while (ok && (status == 1 || next < delta->numWords)) {
+    //picks the smaller of the old file's word and the delta's next word
+    int cmp;
+    if (status != 1) {
+      cmp = 1;
+    } else if (next == delta->numWords) {
+      cmp = -1;
+    } else {
+      cmp = strcmp(word, entries[next].word);
+    }
+
+    //a word only in the delta is written as is
+    plist_t* merged;
+    const char* outWord;
+    if (cmp > 0) {
+      merged = entries[next].postings;
+      outWord = entries[next].word;
+    } else {
+      merged = index_combine(postings, (cmp == 0) ? entries[next].postings : NULL,
+                             replaced, numReplaced);
+      outWord = word;
+    }
+
+    ok = (merged != NULL);
+    if (ok && plist_size(merged) > 0) {
+      ok = index_writeEntry(&out, outWord, merged);
+    }
+    if (cmp <= 0 && merged != postings) {
+      plist_delete(merged);
+    }
+
+    if (cmp >= 0) {
+      next++;
+    }
+    if (cmp <= 0) {
+      plist_delete(postings);
+      postings = NULL;
+      status = ok ? index_readEntry(in, meta.version, &word, &wordCap, &postings) : -1;
+    }
+  }
+  ok = ok && status == 0 && vbyte_write(out.fp, 0);
+
+  //cleans up, then replaces the old file only if the new one is complete
+  plist_delete(postings);
+  free(word);
+  free(out.prev);
+  free(entries);
+  free(meta.ranges);
+  if (in != NULL) {
+    fclose(in);
+  }
+  if (out.fp != NULL && fclose(out.fp) != 0) {
+    ok = false;
+  }
+  if (out.fp != NULL) {
+    if (ok) {
+      ok = (rename(tempFile, filename) == 0);
+    } else {
+      remove(tempFile);
+    }
+  }
+  free(tempFile);
+  return ok;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Combines a word's postings from the old index with its postings from
+ * the delta (which may be NULL), dropping old postings for replaced docIDs.
+ *
+ * Returns:
+ *   old itself if it can be reused (old is then also extended by delta),
+ *   otherwise a new postings list; NULL if out of memory
+ */
+static plist_t* index_combine(plist_t* old, const plist_t* delta,
+                              const int* replaced, const int numReplaced) {
+  //common cases: nothing replaced, and new documents all after the old ones
+  if (numReplaced == 0 && delta == NULL) {
+    return old;
+  }
+  if (numReplaced == 0 && plist_firstDoc(delta) > plist_lastDoc(old)) {
+    return plist_concat(old, delta) ? old : NULL;
+  }
+
+  //general case: decodes both and merges them by docID
+  postings_t* oldPostings = postings_new();
+  postings_t* deltaPostings = postings_new();
+  plist_t* merged = plist_new();
+  if (oldPostings == NULL || deltaPostings == NULL || merged == NULL
+      || !plist_toPostings(old, oldPostings)
+      || (delta != NULL && !plist_toPostings(delta, deltaPostings))) {
+    postings_delete(oldPostings);
+    postings_delete(deltaPostings);
+    plist_delete(merged);
     return NULL;
   }
 
-  index_t* index = index_new(500); //reasonable default size
-  if (index == NULL) {
-    fclose(fp);
+  //replaced is sorted, so it is walked alongside the old postings
+  postings_iter_t oldIter;
+  postings_iter_t deltaIter;
+  postings_iter_init(&oldIter, oldPostings);
+  postings_iter_init(&deltaIter, deltaPostings);
+  int r = 0;
+  int oldDoc, oldCount, deltaDoc, deltaCount;
+  bool haveOld = postings_iter_next(&oldIter, &oldDoc, &oldCount);
+  bool haveDelta = postings_iter_next(&deltaIter, &deltaDoc, &deltaCount);
+  bool ok = true;
+
+  while (ok && (haveOld || haveDelta)) {
+    while (haveOld && r < numReplaced && replaced[r] < oldDoc) {
+      r++;
+    }
+    if (haveOld && r < numReplaced && replaced[r] == oldDoc) {
+      //old posting for a replaced document
+      haveOld = postings_iter_next(&oldIter, &oldDoc, &oldCount);
+    } else if (!haveDelta || (haveOld && oldDoc < deltaDoc)) {
+      ok = plist_append(merged, oldDoc, oldCount);
+      haveOld = postings_iter_next(&oldIter, &oldDoc, &oldCount);
+    } else {
+      if (haveOld && oldDoc == deltaDoc) {
+        //the delta's posting supersedes the old one
+        haveOld = postings_iter_next(&oldIter, &oldDoc, &oldCount);
+      }
+      ok = plist_append(merged, deltaDoc, deltaCount);
+      haveDelta = postings_iter_next(&deltaIter, &deltaDoc, &deltaCount);
+    }
+  }
+
+  postings_delete(oldPostings);
+  postings_delete(deltaPostings);
+  if (!ok) {
+    //a postings list missing some documents must not replace the old one
+    plist_delete(merged);
     return NULL;
   }
+  return merged;
+}
 
-  char* word;
-  while ((word = file_readWord(fp)) != NULL) {
-    counters_t* ctrs = counters_new();
-    if (ctrs == NULL) {
-      free(word);
-      continue;
+
+/*
+ * HELPER FUNCTION
+ * qsort comparator for docIDs (or for pairs led by a docID).
+ */
+static int index_docCmp(const void* a, const void* b) {
+  int docA = *(const int*)a;
+  int docB = *(const int*)b;
+  return (docA > docB) - (docA < docB);
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Removes and frees index_merge's intermediate runs; ignores NULL.
+ */
+static void index_removeRuns(char** runFiles, const int numRuns) {
+  if (runFiles == NULL) return;
+
+  for (int i = 0; i < numRuns; i++) {
+    if (runFiles[i] != NULL) {
+      remove(runFiles[i]);
+      free(runFiles[i]);
     }
+  }
+  free(runFiles);
+}
 
-    int docID, count;
-    while (fscanf(fp, "%d %d", &docID, &count) == 2) {
-      counters_set(ctrs, docID, count);
+
+/*
+ * HELPER FUNCTION
+ * Reads the next record of a run into run->word and run->postings.
+ * At the end of the run, run->postings is left NULL.
+ *
+ * Returns:
+ *   true if a record or the end was read, false on error
+ */
+static bool index_runAdvance(index_run_t* run) {
+  int status = index_readEntry(run->fp, run->version, &run->word, &run->wordCap,
+                               &run->postings);
+  if (status == 0) {
+    run->postings = NULL;
+  }
+  return status >= 0;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Orders runs by current word, then by position in the list of runs.
+ */
+static int index_runCmp(const index_run_t* a, const index_run_t* b) {
+  int cmp = strcmp(a->word, b->word);
+  return (cmp != 0) ? cmp : a->order - b->order;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Restores the min-heap property below position i.
+ */
+static void index_heapDown(index_run_t** heap, const int n, int i) {
+  while (true) {
+    int least = i;
+    int left = 2 * i + 1;
+    int right = left + 1;
+    if (left < n && index_runCmp(heap[left], heap[least]) < 0) {
+      least = left;
     }
+    if (right < n && index_runCmp(heap[right], heap[least]) < 0) {
+      least = right;
+    }
+    if (least == i) {
+      return;
+    }
+    index_run_t* temp = heap[i];
+    heap[i] = heap[least];
+    heap[least] = temp;
+    i = least;
+  }
+}
 
-    hashtable_insert(index->table, word, ctrs);
-    free(word);
+
+/*
+ * HELPER FUNCTION
+ * Writes one record of the binary format, front coded against the 
+ * previous word written:
+ *   vbyte(length - shared) vbyte(shared) suffix plist
+ * Words must be written in increasing order, so the suffix is never empty.
+ *
+ * Returns:
+ *   true if successful, false on write error or out-of-order word
+ */
+static bool index_writeEntry(index_writer_t* out, const char* word,
+                             const plist_t* postings) {
+  unsigned int shared = 0;
+  if (out->prev != NULL) {
+    while (word[shared] != '\0' && word[shared] == out->prev[shared]) {
+      shared++;
+    }
   }
 
-  fclose(fp);
-  return index;
+  unsigned int len = strlen(word);
+  if (len == shared) {
+    return false;
+  }
+
+  return vbyte_write(out->fp, len - shared) &&
+         vbyte_write(out->fp, shared) &&
+         fwrite(word + shared, 1, len - shared, out->fp) == len - shared &&
+         plist_write(postings, out->fp) &&
+         index_copyWord(&out->prev, &out->prevCap, word, len);
 }
 
 
-/* 
- * Frees all memory used by the index.
+/*
+ * HELPER FUNCTION
+ * Reads one record of the binary format. The word is read into *word,
+ * which must still hold the previous record's word, since it is front 
+ * coded against it; *word is grown as needed (its capacity is kept in 
+ * *wordCap). Version 1 and 2 records hold the whole word.
+ *
+ * Returns:
+ *   1 if a record was read into *word and *postings,
+ *   0 if the terminating record was read,
+ *   -1 on EOF, malformed input, or out of memory
  */
-void index_delete(index_t* index) {
-  if (index == NULL) return;
+static int index_readEntry(FILE* fp, const int version, char** word,
+                           unsigned int* wordCap, plist_t** postings) {
+  unsigned int len;
+  unsigned int shared = 0;
+  if (!vbyte_read(fp, &len)) {
+    return -1;
+  }
+  if (len == 0) {
+    return 0;  //end of index
+  }
+  if (version >= 3 && !vbyte_read(fp, &shared)) {
+    return -1;
+  }
+  if (shared > 0 && (*word == NULL || shared > strlen(*word))) {
+    return -1;  //shares more than the previous word has
+  }
 
-  hashtable_delete(index->table, (void (*)(void*)) counters_delete);
-  free(index);
+  if (shared + len + 1 > *wordCap) {
+    char* bigger = realloc(*word, shared + len + 1);
+    if (bigger == NULL) {
+      return -1;
+    }
+    *word = bigger;
+    *wordCap = shared + len + 1;
+  }
+  if (fread(*word + shared, 1, len, fp) != len) {
+    return -1;
+  }
+  (*word)[shared + len] = '\0';
+
+  *postings = plist_read(fp);
+  return (*postings == NULL) ? -1 : 1;
 }
 
+
 /*
- * Looks up the counters for a given word in the index
+ * Reads the docID coverage and build time recorded in an index file.
  *
  * Returns:
- *  counters_t associated with word if found, NULL otherwise
+ *   true if successful, false if the file is unreadable or not binary
  */
-counters_t* index_find(index_t* index, const char* word) {
-  if (index == NULL || word == NULL) {
-    return NULL;
+bool index_info(const char* filename, int* lastDoc, time_t* time) {
+  if (filename == NULL) {
+    return false;
   }
-  return hashtable_find(index->table, word);
+
+  FILE* fp = fopen(filename, "rb");
+  if (fp == NULL) {
+    return false;
+  }
+
+  index_meta_t meta = { NULL, 0, 0, 0, 0 };
+  bool ok = (index_readHeader(fp, &meta) == 1);
+  fclose(fp);
+
+  if (ok && lastDoc != NULL) {
+    *lastDoc = (meta.numRanges == 0) ? 0 : meta.ranges[2 * meta.numRanges - 1];
+  }
+  if (ok && time != NULL) {
+    *time = meta.time;
+  }
+  free(meta.ranges);
+  return ok;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Adds docIDs first..last to the coverage, merging overlapping or
+ * adjacent ranges so that the ranges stay sorted and disjoint.
+ *
+ * Returns:
+ *   true if success, false if out of memory
+ */
+static bool index_metaCover(index_meta_t* meta, const int first, const int last) {
+  if (meta->numRanges == meta->rangeCap) {
+    int cap = (meta->rangeCap == 0) ? 4 : meta->rangeCap * 2;
+    int* bigger = realloc(meta->ranges, 2 * cap * sizeof(int));
+    if (bigger == NULL) {
+      return false;
+    }
+    meta->ranges = bigger;
+    meta->rangeCap = cap;
+  }
+
+  //inserts the new range in order of its first docID
+  int i = meta->numRanges;
+  while (i > 0 && meta->ranges[2 * (i - 1)] > first) {
+    meta->ranges[2 * i] = meta->ranges[2 * (i - 1)];
+    meta->ranges[2 * i + 1] = meta->ranges[2 * (i - 1) + 1];
+    i--;
+  }
+  meta->ranges[2 * i] = first;
+  meta->ranges[2 * i + 1] = last;
+  meta->numRanges++;
+
+  //coalesces ranges that now overlap or touch
+  int n = 0;
+  for (int j = 1; j < meta->numRanges; j++) {
+    if (meta->ranges[2 * j] <= meta->ranges[2 * n + 1] + 1) {
+      if (meta->ranges[2 * j + 1] > meta->ranges[2 * n + 1]) {
+        meta->ranges[2 * n + 1] = meta->ranges[2 * j + 1];
+      }
+    } else {
+      n++;
+      meta->ranges[2 * n] = meta->ranges[2 * j];
+      meta->ranges[2 * n + 1] = meta->ranges[2 * j + 1];
+    }
+  }
+  meta->numRanges = n + 1;
+  return true;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Returns true if docID lies in one of the covered ranges.
+ */
+static bool index_metaCovers(const index_meta_t* meta, const int docID) {
+  int lo = 0;
+  int hi = meta->numRanges - 1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (docID < meta->ranges[2 * mid]) {
+      hi = mid - 1;
+    } else if (docID > meta->ranges[2 * mid + 1]) {
+      lo = mid + 1;
+    } else {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Adds all of other's covered ranges to meta.
+ */
+static bool index_metaUnion(index_meta_t* meta, const index_meta_t* other) {
+  for (int i = 0; i < other->numRanges; i++) {
+    if (!index_metaCover(meta, other->ranges[2 * i], other->ranges[2 * i + 1])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Writes the magic and metadata that begin a binary index file:
+ *   magic vbyte(time) vbyte(numRanges) [vbyte(first) vbyte(last - first)]...
+ */
+static bool index_writeHeader(FILE* fp, const index_meta_t* meta) {
+  bool ok = fwrite(INDEX_MAGIC, 1, INDEX_MAGIC_LEN, fp) == INDEX_MAGIC_LEN &&
+            vbyte_write(fp, (unsigned int)meta->time) &&
+            vbyte_write(fp, meta->numRanges);
+  for (int i = 0; ok && i < meta->numRanges; i++) {
+    ok = vbyte_write(fp, meta->ranges[2 * i]) &&
+         vbyte_write(fp, meta->ranges[2 * i + 1] - meta->ranges[2 * i]);
+  }
+  return ok;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Reads the magic and metadata at the start of a binary index file,
+ * replacing any coverage already in meta, and notes the file's version.
+ * A version 1 file has no metadata, so it is read as covering nothing, 
+ * built at an unknown time.
+ *
+ * Returns:
+ *   1 if a binary header was read,
+ *   0 if the file does not start with a binary magic,
+ *   -1 on malformed input or out of memory
+ */
+static int index_readHeader(FILE* fp, index_meta_t* meta) {
+  meta->numRanges = 0;
+  meta->time = 0;
+
+  char magic[INDEX_MAGIC_LEN];
+  if (fread(magic, 1, INDEX_MAGIC_LEN, fp) != INDEX_MAGIC_LEN) {
+    return 0;
+  }
+  if (memcmp(magic, INDEX_MAGIC_V1, INDEX_MAGIC_LEN) == 0) {
+    meta->version = 1;
+    return 1;
+  }
+  if (memcmp(magic, INDEX_MAGIC_V2, INDEX_MAGIC_LEN) == 0) {
+    meta->version = 2;
+  } else if (memcmp(magic, INDEX_MAGIC, INDEX_MAGIC_LEN) == 0) {
+    meta->version = INDEX_VERSION;
+  } else {
+    return 0;
+  }
+
+  unsigned int time, numRanges;
+  if (!vbyte_read(fp, &time) || !vbyte_read(fp, &numRanges)) {
+    return -1;
+  }
+  meta->time = time;
+  for (unsigned int i = 0; i < numRanges; i++) {
+    unsigned int first, length;
+    if (!vbyte_read(fp, &first) || !vbyte_read(fp, &length) ||
+        !index_metaCover(meta, first, first + length)) {
+      return -1;
+    }
+  }
+  return 1;
+}
+
+
+/*
+ * Saves the index to a file in the text format.
+ *
+ * Returns:
+ *   true if successful, false if error
+ */
+bool index_saveText(index_t* index, const char* filename) {
+  if (index == NULL || filename == NULL) {
+    return false;
+  }
+
+  FILE* fp = fopen(filename, "w");
+  if (fp == NULL) {
+    return false;
+  }
+
+  bool ok = index_iterateSorted(index, fp, index_saveText_helper);
+  return (fclose(fp) == 0) && ok;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Returns a newly allocated array of all (word, postings) pairs of an
+ * index being built, sorted by word, or NULL if out of memory or the 
+ * index was loaded. Caller frees the array (not the words).
+ */
+static index_entry_t* index_sorted(index_t* index) {
+  if (index->table == NULL) {
+    return NULL;
+  }
+
+  index_entry_t* entries = malloc((index->numWords + 1) * sizeof(index_entry_t));
+  if (entries == NULL) {
+    return NULL;
+  }
+
+  index_entry_t* next = entries;
+  hashtable_iterate(index->table, &next, index_sorted_helper);
+  qsort(entries, index->numWords, sizeof(index_entry_t), index_entry_cmp);
+  return entries;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Called for each word in the hashtable; appends it to the entries array.
+ */
+static void index_sorted_helper(void* arg, const char* word, void* item) {
+  index_entry_t** next = arg;
+  (*next)->word = word;
+  (*next)->postings = item;
+  (*next)++;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * qsort comparator ordering entries by word.
+ */
+static int index_entry_cmp(const void* a, const void* b) {
+  return strcmp(((const index_entry_t*)a)->word, ((const index_entry_t*)b)->word);
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Calls itemfunc(arg, word, postings) for every word, in sorted order:
+ * straight from the dictionary of a loaded index, or by sorting the 
+ * hashtable of an index being built.
+ *
+ * Returns:
+ *   true if successful, false if out of memory
+ */
+static bool index_iterateSorted(index_t* index, void* arg,
+                                void (*itemfunc)(void* arg, const char* word,
+                                                 plist_t* postings)) {
+  if (index->dict != NULL) {
+    index_visit_t visit = { index, NULL, 0, arg, itemfunc };
+    dict_range(index->dict, 0, index->numWords, &visit, index_dict_helper);
+    return true;
+  }
+
+  index_entry_t* entries = index_sorted(index);
+  if (entries == NULL) {
+    return false;
+  }
+  for (int i = 0; i < index->numWords; i++) {
+    (*itemfunc)(arg, entries[i].word, entries[i].postings);
+  }
+  free(entries);
+  return true;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Called by dict_range for each term; passes its word and postings on.
+ */
+static void index_dict_helper(void* arg, const int term, const char* word) {
+  index_visit_t* visit = arg;
+  (*visit->itemfunc)(visit->arg, word, visit->index->postings[term]);
+  visit->count++;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Called for each word in the hashtable; passes it on if it has the prefix.
+ */
+static void index_prefix_helper(void* arg, const char* word, void* item) {
+  index_visit_t* visit = arg;
+  if (strncmp(word, visit->prefix, strlen(visit->prefix)) == 0) {
+    (*visit->itemfunc)(visit->arg, word, item);
+    visit->count++;
+  }
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Writes one word's record to the index_writer_t in arg.
+ */
+static void index_save_helper(void* arg, const char* word, plist_t* postings) {
+  index_writer_t* out = arg;
+  out->ok = out->ok && index_writeEntry(out, word, postings);
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Prints one word's line of the text format to the file in arg.
+ */
+static void index_saveText_helper(void* arg, const char* word, plist_t* postings) {
+  fprintf(arg, "%s", word);
+  plist_iterate(postings, arg, index_counter_print);
+  fprintf(arg, "\n");
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Called for each docID/count in a postings list.
+ * Prints " docID count".
+ */
+static void index_counter_print(void* fp, const int docID, const int count) {
+  fprintf((FILE*)fp, " %d %d", docID, count);
+}
+
+
+/*
+ * Loads an index from a file, making assumption that file format is correct
+ *
+ * Returns:
+ *   pointer to index if successful, or NULL if error
+ */
+index_t* index_load(const char* filename) {
+  if (filename == NULL) {
+    return NULL;
+  }
+
+  FILE* fp = fopen(filename, "rb");
+  if (fp == NULL) {
+    return NULL;
+  }
+
+  index_t* index = index_new(500); //reasonable default size
+  if (index == NULL) {
+    fclose(fp);
+    return NULL;
+  }
+
+  //checks for the binary magic; otherwise reads the text format, whose
+  //words come in any order and are sorted into the dictionary afterward
+  bool ok;
+  int header = index_readHeader(fp, &index->meta);
+  if (header == 1) {
+    hashtable_delete(index->table, NULL);
+    index->table = NULL;
+    index->dict = dict_new();
+    ok = (index->dict != NULL) && index_loadBinary(index, fp);
+  } else if (header == 0) {
+    rewind(fp);
+    ok = index_loadText(index, fp) && index_freeze(index);
+  } else {
+    ok = false;
+  }
+
+  fclose(fp);
+  if (!ok) {
+    index_delete(index);
+    return NULL;
+  }
+
+  //loads tombstones for removed documents, if there are any
+  char* tombstones = index_tombstoneFile(filename);
+  if (tombstones != NULL) {
+    index->removed = bitset_load(tombstones);
+    free(tombstones);
+  }
+  return index;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Reads word records from a binary index file positioned after the magic.
+ *
+ * Returns:
+ *   true if the terminating record was reached, false on error
+ */
+static bool index_loadBinary(index_t* index, FILE* fp) {
+  char* word = NULL;
+  unsigned int wordCap = 0;
+  plist_t* postings;
+  int status;
+
+  //words come in sorted order, so go straight into the dictionary
+  while ((status = index_readEntry(fp, index->meta.version, &word, &wordCap,
+                                   &postings)) == 1) {
+    if (!index_addTerm(index, word, postings)) {
+      plist_delete(postings);
+      status = -1;
+      break;
+    }
+  }
+  index->memory += dict_memory(index->dict);
+
+  free(word);
+  return status == 0;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Appends a word, larger than any before it, and its postings to the 
+ * dictionary of an index being loaded.
+ *
+ * Returns:
+ *   true if successful, false if out of order or out of memory
+ */
+static bool index_addTerm(index_t* index, const char* word, plist_t* postings) {
+  if (index->numWords == index->postingsCap) {
+    int cap = (index->postingsCap == 0) ? 256 : index->postingsCap * 2;
+    plist_t** bigger = realloc(index->postings, cap * sizeof(plist_t*));
+    if (bigger == NULL) {
+      return false;
+    }
+    index->memory += (cap - index->postingsCap) * sizeof(plist_t*);
+    index->postings = bigger;
+    index->postingsCap = cap;
+  }
+
+  if (dict_add(index->dict, word) != index->numWords) {
+    return false;
+  }
+  index->postings[index->numWords++] = postings;
+  index->memory += plist_memory(postings);
+  return true;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Moves the words of an index built in its hashtable into a sorted 
+ * dictionary, as if the index had been loaded from a binary file.
+ *
+ * Returns:
+ *   true if successful, false if out of memory
+ */
+static bool index_freeze(index_t* index) {
+  index_entry_t* entries = index_sorted(index);
+  index->dict = dict_new();
+  if (entries == NULL || index->dict == NULL) {
+    free(entries);
+    return false;
+  }
+
+  int numWords = index->numWords;
+  index->numWords = 0;
+  index->memory = sizeof(index_t);
+  bool ok = true;
+  for (int i = 0; i < numWords; i++) {
+    if (ok) {
+      ok = index_addTerm(index, entries[i].word, entries[i].postings);
+    }
+    if (!ok) {
+      plist_delete(entries[i].postings);  //not moved, so freed here
+    }
+  }
+  index->memory += dict_memory(index->dict);
+
+  //the postings now belong to the dictionary side
+  hashtable_delete(index->table, NULL);
+  index->table = NULL;
+  free(entries);
+  return ok;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Copies the first len bytes of word, and a terminator, into *buf,
+ * growing it as needed (its capacity is kept in *bufCap).
+ *
+ * Returns:
+ *   true if successful, false if out of memory
+ */
+static bool index_copyWord(char** buf, unsigned int* bufCap, const char* word,
+                           const unsigned int len) {
+  if (len + 1 > *bufCap) {
+    char* bigger = realloc(*buf, len + 1);
+    if (bigger == NULL) {
+      return false;
+    }
+    *buf = bigger;
+    *bufCap = len + 1;
+  }
+  memcpy(*buf, word, len);
+  (*buf)[len] = '\0';
+  return true;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Reads lines of the form "word docID count [docID count]..."
+ * The docIDs on a line may appear in any order.
+ *
+ * Returns:
+ *   true if successful, false if out of memory
+ */
+static bool index_loadText(index_t* index, FILE* fp) {
+  index_pairs_t pairs = { NULL, 0, 0 };
+  bool ok = true;
+  int lastDoc = 0;
+
+  char* word;
+  while (ok && (word = file_readWord(fp)) != NULL) {
+    pairs.num = 0;
+
+    int docID, count;
+    while (fscanf(fp, "%d %d", &docID, &count) == 2) {
+      if (pairs.num == pairs.cap) {
+        pairs.cap = (pairs.cap == 0) ? 16 : pairs.cap * 2;
+        int* bigger = realloc(pairs.pairs, 2 * pairs.cap * sizeof(int));
+        if (bigger == NULL) {
+          ok = false;
+          break;
+        }
+        pairs.pairs = bigger;
+      }
+      pairs.pairs[2 * pairs.num] = docID;
+      pairs.pairs[2 * pairs.num + 1] = count;
+      pairs.num++;
+    }
+
+    //postings lists are built in docID order
+    qsort(pairs.pairs, pairs.num, 2 * sizeof(int), index_docCmp);
+
+    plist_t* postings = plist_new();
+    if (postings == NULL) {
+      free(word);
+      ok = false;
+      break;
+    }
+    for (int i = 0; i < pairs.num; i++) {
+      plist_append(postings, pairs.pairs[2 * i], pairs.pairs[2 * i + 1]);
+    }
+    if (plist_lastDoc(postings) > lastDoc) {
+      lastDoc = plist_lastDoc(postings);
+    }
+
+    if (hashtable_insert(index->table, word, postings)) {
+      index->numWords++;
+      index->memory += strlen(word) + 1 + INDEX_WORD_OVERHEAD + plist_memory(postings);
+    } else {
+      plist_delete(postings);
+    }
+    free(word);
+  }
+
+  free(pairs.pairs);
+
+  //the text format has no metadata; assumes pages 1..lastDoc were indexed
+  if (ok && lastDoc > 0) {
+    ok = index_metaCover(&index->meta, 1, lastDoc);
+  }
+  return ok;
+}
+
+
+/*
+ * Frees all memory used by the index.
+ */
+void index_delete(index_t* index) {
+  if (index == NULL) return;
+
+  if (index->table != NULL) {
+    hashtable_delete(index->table, (void (*)(void*)) plist_delete);
+  } else {
+    for (int i = 0; i < index->numWords; i++) {
+      plist_delete(index->postings[i]);
+    }
+  }
+  free(index->postings);
+  dict_delete(index->dict);
+  free(index->meta.ranges);
+  bitset_delete(index->removed);
+  free(index);
+}
+
+/*
+ * Looks up the postings for a given word in the index
+ *
+ * Returns:
+ *  plist_t associated with word if found, NULL otherwise
+ */
+plist_t* index_find(index_t* index, const char* word) {
+  if (index == NULL || word == NULL) {
+    return NULL;
+  }
+  if (index->dict != NULL) {
+    int term = dict_find(index->dict, word);
+    return (term < 0) ? NULL : index->postings[term];
+  }
+  return hashtable_find(index->table, word);
+}
+
+
+/*
+ * Calls itemfunc for each word starting with prefix: a range scan of the
+ * dictionary of a loaded index, or a scan of the whole hashtable of an 
+ * index being built.
+ *
+ * Returns:
+ *   number of words visited
+ */
+int index_prefix(index_t* index, const char* prefix, void* arg,
+                 void (*itemfunc)(void* arg, const char* word, plist_t* postings)) {
+  if (index == NULL || prefix == NULL || itemfunc == NULL) {
+    return 0;
+  }
+
+  index_visit_t visit = { index, prefix, 0, arg, itemfunc };
+  if (index->dict != NULL) {
+    int first;
+    int count = dict_prefix(index->dict, prefix, &first);
+    dict_range(index->dict, first, first + count, &visit, index_dict_helper);
+  } else {
+    hashtable_iterate(index->table, &visit, index_prefix_helper);
+  }
+  return visit.count;
+}
+
+
+/*
+ * Returns true if docID has been removed with index_remove.
+ */
+bool index_isRemoved(index_t* index, const int docID) {
+  return index != NULL && bitset_test(index->removed, docID);
+}
+
+
+/*
+ * Adds tombstones for the given docIDs to the index file's tombstone file.
+ *
+ * Returns:
+ *   true if successful, false on error
+ */
+bool index_remove(const char* filename, const int* docIDs, const int numDocs) {
+  if (filename == NULL || docIDs == NULL || numDocs < 0) {
+    return false;
+  }
+
+  char* tombstones = index_tombstoneFile(filename);
+  if (tombstones == NULL) {
+    return false;
+  }
+
+  bitset_t* removed = bitset_load(tombstones);
+  if (removed == NULL) {
+    removed = bitset_new();
+  }
+
+  bool ok = (removed != NULL);
+  for (int i = 0; ok && i < numDocs; i++) {
+    ok = (docIDs[i] > 0) && bitset_set(removed, docIDs[i]);
+  }
+  ok = ok && bitset_save(removed, tombstones);
+
+  bitset_delete(removed);
+  free(tombstones);
+  return ok;
+}
+
+
+/*
+ * Rewrites the index file without the postings of removed documents,
+ * then drops the tombstones that were applied.
+ *
+ * Returns:
+ *   true if successful, false on error
+ */
+bool index_compact(const char* filename) {
+  if (filename == NULL) {
+    return false;
+  }
+
+  char* tombstones = index_tombstoneFile(filename);
+  if (tombstones == NULL) {
+    return false;
+  }
+
+  //gathers the removed docIDs, in increasing order
+  bitset_t* removed = bitset_load(tombstones);
+  int numReplaced = bitset_count(removed);
+  int* replaced = malloc((numReplaced + 1) * sizeof(int));
+  int n = 0;
+  for (int docID = bitset_next(removed, 1); replaced != NULL && docID > 0;
+       docID = bitset_next(removed, docID + 1)) {
+    replaced[n++] = docID;
+  }
+
+  //an empty delta with the old build time leaves coverage and time as is
+  time_t built;
+  index_t* delta = index_new(1);
+  bool ok = (replaced != NULL && delta != NULL &&
+             index_info(filename, NULL, &built));
+  if (ok) {
+    index_setTime(delta, built);
+    ok = index_update(filename, delta, replaced, n);
+  }
+
+  //keeps only tombstones added while compacting
+  if (ok && n > 0) {
+    bitset_t* current = bitset_load(tombstones);
+    bitset_t* remaining = bitset_new();
+    ok = (remaining != NULL);
+    for (int docID = bitset_next(current, 1); ok && docID > 0;
+         docID = bitset_next(current, docID + 1)) {
+      if (!bitset_test(removed, docID)) {
+        ok = bitset_set(remaining, docID);
+      }
+    }
+    if (ok) {
+      ok = (bitset_count(remaining) > 0) ? bitset_save(remaining, tombstones)
+                                         : (remove(tombstones) == 0);
+    }
+    bitset_delete(current);
+    bitset_delete(remaining);
+  }
+
+  index_delete(delta);
+  bitset_delete(removed);
+  free(replaced);
+  free(tombstones);
+  return ok;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Returns the newly allocated path of the tombstone file for an index
+ * file, or NULL if out of memory.
+ */
+static char* index_tombstoneFile(const char* filename) {
+  char* path = malloc(strlen(filename) + strlen(INDEX_TOMBSTONES) + 1);
+  if (path != NULL) {
+    sprintf(path, "%s%s", filename, INDEX_TOMBSTONES);
+  }
+  return path;
 }
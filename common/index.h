@@ -4,8 +4,27 @@
  * This is the header file for the index module.
  * It provides functions for creating, updating, saving, loading, and 
  * deleting an index structure used by the TSE.
- * The index is a hashtable mapping from words (strings) to counters sets, 
- * where each counters set stores (docID, count) pairs.
+ * The index maps words (strings) to compressed postings lists (see 
+ * plist.h), where each list stores (docID, count) pairs in increasing 
+ * docID order. While an index is built with index_insert, its words are
+ * kept in a hashtable; an index read by index_load keeps them instead in
+ * a sorted, front-coded dictionary (see dict.h), which is smaller and 
+ * supports prefix lookups with index_prefix.
+ *
+ * Index files are written in a compressed binary format:
+ *   "TSEINDX3" magic, metadata (the build time and the ranges of docIDs
+ *   covered), then for each word in sorted order
+ *     vbyte(length - shared) vbyte(shared) suffix plist
+ *   where shared is the length of the prefix the word has in common with
+ *   the word before it, and finally vbyte(0). Files from earlier versions 
+ *   ("TSEINDX2", "TSEINDX1"), which store each word whole, are still read.
+ * The original text format (one line per word: word docID count ...)
+ * can still be written with index_saveText, and index_load reads both.
+ *
+ * Documents can be removed without rewriting the index: index_remove 
+ * records tombstones in a bitmap file beside the index (filename.deleted),
+ * which index_load reads so that callers can skip removed docIDs with 
+ * index_isRemoved. index_compact later rewrites the index without them.
  */
 
 //header guard prevents multiple inclusion of same header file
@@ -14,7 +33,9 @@
 
 #include <stdio.h>
 #include <stdbool.h>
-#include "counters.h"
+#include <stdint.h>
+#include <time.h>
+#include "plist.h"
 
 //global types
 typedef struct index index_t;
@@ -40,32 +61,158 @@ index_t* index_new(const int numSlots);
  * Returns:
  *   true if insertion was successful, false otherwise
  * Notes:
- *   Allocates a new counters set for a word if not already present.
- *   Increments count for docID if already present
+ *   Allocates a new postings list for a word if not already present.
+ *   Increments count for docID if already present.
+ *   For each word, docIDs must be inserted in nondecreasing order, as 
+ *   the indexer does when it visits pages 1, 2, 3, ...
+ *   An index read by index_load is read-only; inserting into it fails.
  */
 bool index_insert(index_t* index, const char* word, const int docID);
 
 
 /*
- * Saves the index to a file in the required format.
+ * Inserts the given word/docID pair, as index_insert, with the word's
+ * hash already computed, so a tokenizer can hash each word once.
+ *
+ * Caller provides:
+ *   as for index_insert, and
+ *   hash - hash_bytes(word, strlen(word)) (see hash.h)
+ * Returns:
+ *   true if insertion was successful, false otherwise
+ */
+bool index_insertHashed(index_t* index, const char* word, const uint64_t hash,
+                        const int docID);
+
+
+/*
+ * Saves the index to a file in the compressed binary format.
  *
  * Caller provides:
  *   index - pointer to a valid index
  *   filename - path to a writable output file
  * Returns:
  *   true if file written successfully, false otherwise
+ * Notes:
+ *   Words are written in sorted order.
  */
 bool index_save(index_t* index, const char* filename);
 
+/*
+ * Merges several binary index files into one binary index file.
+ *
+ * Caller provides:
+ *   runFiles - array of paths to binary index files ("runs"), in order;
+ *              every docID in a run must be larger than every docID in 
+ *              the runs before it, as when the indexer flushes partial 
+ *              indexes while visiting pages in docID order
+ *   numRuns - number of paths in runFiles
+ *   filename - path to a writable output file
+ * Returns:
+ *   true if the merged file was written successfully, false otherwise
+ * Notes:
+ *   Runs are streamed, so memory use does not depend on their size, and
+ *   at most 64 are open at once; more are merged in passes through 
+ *   intermediate files beside filename. The postings for a word found 
+ *   in several runs are concatenated. The output is written to 
+ *   filename.tmp and renamed, so a failed merge leaves filename as it was.
+ */
+bool index_merge(char* const runFiles[], const int numRuns, const char* filename);
+
+/*
+ * Rewrites an index file, applying a delta index built from new or 
+ * changed pages.
+ *
+ * Caller provides:
+ *   filename - path to an existing binary index file
+ *   delta - index built with index_insert of the pages to add or 
+ *           re-index, with its coverage (index_cover) and build time 
+ *           (index_setTime) recorded
+ *   replaced - sorted array of docIDs whose old postings are dropped,
+ *              because the page changed or disappeared; may be NULL
+ *              if numReplaced is 0
+ *   numReplaced - number of docIDs in replaced
+ * Returns:
+ *   true if the file was updated, false otherwise
+ * Notes:
+ *   The result is written to filename.tmp and renamed over filename, so
+ *   the file is replaced atomically and left untouched on error.
+ *   The old index is streamed, not loaded. The new file covers the union
+ *   of the old and delta coverage, and takes the delta's build time.
+ */
+bool index_update(const char* filename, index_t* delta,
+                  const int* replaced, const int numReplaced);
+
+/*
+ * Reads the metadata recorded in a binary index file.
+ *
+ * Caller provides:
+ *   filename - path to a binary index file
+ *   lastDoc - where to store the largest docID covered (may be NULL)
+ *   time - where to store the build time, 0 if unknown (may be NULL)
+ * Returns:
+ *   true if successful, false if unreadable or not a binary index file
+ */
+bool index_info(const char* filename, int* lastDoc, time_t* time);
+
+/*
+ * Records that the pages with docIDs first..last have been indexed.
+ *
+ * Returns:
+ *   true if successful, false if the range is invalid or out of memory
+ * Notes:
+ *   The coverage is saved with the index, so that a later update knows
+ *   which pages it already contains, even those with no words.
+ */
+bool index_cover(index_t* index, const int first, const int last);
+
+/*
+ * Returns true if docID has been recorded as indexed.
+ */
+bool index_covers(index_t* index, const int docID);
+
+/*
+ * Returns the largest docID recorded as indexed (the index's high-water
+ * mark), or 0 if none.
+ */
+int index_lastDoc(index_t* index);
+
+/*
+ * Gets or sets the time at which the index's pages were read; 0 if unknown.
+ */
+time_t index_time(index_t* index);
+void index_setTime(index_t* index, const time_t time);
+
+/*
+ * Returns the estimated number of bytes of memory used by the index,
+ * including its words and postings, or 0 if index is NULL.
+ */
+size_t index_memory(index_t* index);
+
+/*
+ * Saves the index to a file in the text format, one line per word:
+ *   word docID count [docID count]...
+ *
+ * Caller provides:
+ *   index - pointer to a valid index
+ *   filename - path to a writable output file
+ * Returns:
+ *   true if file written successfully, false otherwise
+ * Notes:
+ *   Words are written in sorted order, docIDs in increasing order.
+ */
+bool index_saveText(index_t* index, const char* filename);
+
 /*
  * Loads an index from an existing file.
  *
  * Caller provides:
- *   filename - path to an index file formatted as specified
+ *   filename - path to an index file, in binary or text format
  * Returns:
  *   pointer to an index_t structure if successful, or NULL on failure
  * Notes:
+ *   The format is detected from the magic at the start of the file.
  *   Assumes the input file format is already correct
+ *   The words are kept in a sorted dictionary, and the index is read-only.
  */
 index_t* index_load(const char* filename);
 
@@ -78,15 +225,78 @@ index_t* index_load(const char* filename);
 void index_delete(index_t* index);
 
 /*
- * Looks up the counters for a given word in the index
+ * Looks up the postings for a given word in the index
  *
  * Caller provides:
  *  index - pointer to a valid index or NULL
  *  word - target word
  * Returns:
- *  pointer to the counters_t structure for the word
+ *  pointer to the plist_t structure for the word, owned by the index
  *  NULL if not found
  */
-counters_t* index_find(index_t* index, const char* word);
+plist_t* index_find(index_t* index, const char* word);
+
+/*
+ * Visits every word in the index that starts with the given prefix
+ *
+ * Caller provides:
+ *  index - pointer to a valid index or NULL
+ *  prefix - the prefix to match
+ *  arg - passed through to itemfunc
+ *  itemfunc - called as itemfunc(arg, word, postings) for each match
+ * Returns:
+ *  the number of matching words
+ * Notes:
+ *  For an index read by index_load, the matches are a contiguous range 
+ *  of the sorted dictionary, found by binary search and visited in sorted
+ *  order. For an index being built, the whole hashtable is scanned and 
+ *  the order is undefined.
+ */
+int index_prefix(index_t* index, const char* prefix, void* arg,
+                 void (*itemfunc)(void* arg, const char* word, plist_t* postings));
+
+/*
+ * Returns true if docID was removed (tombstoned) when the index was loaded.
+ *
+ * Caller provides:
+ *   index - pointer to a valid index or NULL
+ *   docID - document to check
+ * Notes:
+ *   This is a constant-time bitmap test, cheap enough to make for every
+ *   posting a query visits.
+ */
+bool index_isRemoved(index_t* index, const int docID);
+
+/*
+ * Removes documents from an index file by recording tombstones for them.
+ *
+ * Caller provides:
+ *   filename - path to an index file
+ *   docIDs - array of positive docIDs to remove
+ *   numDocs - number of docIDs
+ * Returns:
+ *   true if the tombstones were saved, false otherwise
+ * Notes:
+ *   The index file itself is not rewritten; the removal takes effect for 
+ *   every later index_load. The tombstone file is replaced atomically.
+ */
+bool index_remove(const char* filename, const int* docIDs, const int numDocs);
+
+/*
+ * Compacts an index file, rewriting it without the postings of removed
+ * documents and then clearing their tombstones.
+ *
+ * Caller provides:
+ *   filename - path to an existing binary index file
+ * Returns:
+ *   true if successful (or there was nothing to compact), false otherwise
+ * Notes:
+ *   The index is rewritten with index_update, so it is streamed and 
+ *   replaced atomically; queriers may keep using the old file meanwhile.
+ *   Removed documents stay in the index's coverage, so a later update 
+ *   does not add them back unless their page file changes.
+ *   Run one compaction at a time.
+ */
+bool index_compact(const char* filename);
 
 #endif // __INDEX_H
@@ -0,0 +1,326 @@
+/*
+ * manifest.c    Gretchen Kerfoot    Spring 2025
+ *
+ * Implementation of the manifest module.
+ * The pages are kept in parallel arrays in docID order, with each page's
+ * offset alongside its size, so lookups by docID and by offset are
+ * binary searches.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "manifest.h"
+
+#define MANIFEST_MAGIC "TSEMANIFEST1"
+
+//private type for the manifest
+typedef struct manifest {
+  int* docIDs;     //numDocs docIDs, increasing
+  long* bytes;     //size of each page
+  long* offsets;   //total size of the pages before each one
+  int numDocs;
+  int cap;         //entries allocated
+  long totalBytes;
+} manifest_t;
+
+//helper function prototypes
+static int manifest_search(const manifest_t* manifest, const int docID);
+static char* manifest_path(const char* pageDirectory, const char* suffix);
+
+
+/*
+ * Creates a new, empty manifest.
+ *
+ * Returns:
+ *   pointer to new manifest, or NULL if out of memory
+ */
+manifest_t* manifest_new(void) {
+  manifest_t* manifest = malloc(sizeof(manifest_t));
+  if (manifest == NULL) {
+    return NULL;
+  }
+  manifest->docIDs = NULL;
+  manifest->bytes = NULL;
+  manifest->offsets = NULL;
+  manifest->numDocs = 0;
+  manifest->cap = 0;
+  manifest->totalBytes = 0;
+  return manifest;
+}
+
+
+/*
+ * Appends a page, doubling the arrays when they are full.
+ *
+ * Returns:
+ *   true if success, false if invalid or out of memory
+ */
+bool manifest_add(manifest_t* manifest, const int docID, const long bytes) {
+  if (manifest == NULL || docID <= manifest_lastDoc(manifest) || bytes < 0) {
+    return false;
+  }
+
+  if (manifest->numDocs == manifest->cap) {
+    int cap = (manifest->cap == 0) ? 64 : manifest->cap * 2;
+    int* docIDs = realloc(manifest->docIDs, cap * sizeof(int));
+    if (docIDs == NULL) {
+      return false;
+    }
+    manifest->docIDs = docIDs;
+    long* sizes = realloc(manifest->bytes, cap * sizeof(long));
+    if (sizes == NULL) {
+      return false;
+    }
+    manifest->bytes = sizes;
+    long* offsets = realloc(manifest->offsets, cap * sizeof(long));
+    if (offsets == NULL) {
+      return false;
+    }
+    manifest->offsets = offsets;
+    manifest->cap = cap;
+  }
+
+  manifest->docIDs[manifest->numDocs] = docID;
+  manifest->bytes[manifest->numDocs] = bytes;
+  manifest->offsets[manifest->numDocs] = manifest->totalBytes;
+  manifest->numDocs++;
+  manifest->totalBytes += bytes;
+  return true;
+}
+
+
+/*
+ * Saves the manifest to pageDirectory/.manifest, by way of a temporary
+ * file.
+ *
+ * Returns:
+ *   true if success, false on error
+ */
+bool manifest_save(const manifest_t* manifest, const char* pageDirectory) {
+  if (manifest == NULL || pageDirectory == NULL) {
+    return false;
+  }
+
+  char* filename = manifest_path(pageDirectory, "");
+  char* tempFile = manifest_path(pageDirectory, ".tmp");
+  FILE* fp = (tempFile != NULL) ? fopen(tempFile, "w") : NULL;
+  if (filename == NULL || fp == NULL) {
+    free(filename);
+    free(tempFile);
+    return false;
+  }
+
+  bool ok = fprintf(fp, "%s\n%d %ld\n", MANIFEST_MAGIC,
+                    manifest->numDocs, manifest->totalBytes) > 0;
+  for (int i = 0; ok && i < manifest->numDocs; i++) {
+    ok = fprintf(fp, "%d %ld %ld\n", manifest->docIDs[i],
+                 manifest->bytes[i], manifest->offsets[i]) > 0;
+  }
+  if (fclose(fp) != 0) {
+    ok = false;
+  }
+
+  if (ok) {
+    ok = (rename(tempFile, filename) == 0);
+  } else {
+    remove(tempFile);
+  }
+  free(filename);
+  free(tempFile);
+  return ok;
+}
+
+
+/*
+ * Loads pageDirectory/.manifest, checking that its docIDs increase and
+ * that its offsets and total agree with its sizes.
+ *
+ * Returns:
+ *   pointer to new manifest, or NULL if missing, invalid, or out of memory
+ */
+manifest_t* manifest_load(const char* pageDirectory) {
+  if (pageDirectory == NULL) {
+    return NULL;
+  }
+
+  char* filename = manifest_path(pageDirectory, "");
+  FILE* fp = (filename != NULL) ? fopen(filename, "r") : NULL;
+  free(filename);
+  if (fp == NULL) {
+    return NULL;
+  }
+
+  char magic[sizeof(MANIFEST_MAGIC)];
+  int numDocs;
+  long totalBytes;
+  manifest_t* manifest = NULL;
+  if (fscanf(fp, "%12s %d %ld", magic, &numDocs, &totalBytes) == 3 &&
+      strcmp(magic, MANIFEST_MAGIC) == 0 && numDocs >= 0) {
+    manifest = manifest_new();
+  }
+
+  //each line must continue the pages before it
+  for (int i = 0; manifest != NULL && i < numDocs; i++) {
+    int docID;
+    long bytes, offset;
+    if (fscanf(fp, "%d %ld %ld", &docID, &bytes, &offset) != 3 ||
+        offset != manifest->totalBytes ||
+        !manifest_add(manifest, docID, bytes)) {
+      manifest_delete(manifest);
+      manifest = NULL;
+    }
+  }
+  if (manifest != NULL && manifest->totalBytes != totalBytes) {
+    manifest_delete(manifest);
+    manifest = NULL;
+  }
+
+  fclose(fp);
+  return manifest;
+}
+
+
+/*
+ * Returns the number of pages listed.
+ */
+int manifest_numDocs(const manifest_t* manifest) {
+  return (manifest == NULL) ? 0 : manifest->numDocs;
+}
+
+
+/*
+ * Returns the last docID listed, or 0 if none.
+ */
+int manifest_lastDoc(const manifest_t* manifest) {
+  if (manifest == NULL || manifest->numDocs == 0) {
+    return 0;
+  }
+  return manifest->docIDs[manifest->numDocs - 1];
+}
+
+
+/*
+ * Returns the total size of the pages listed.
+ */
+long manifest_totalBytes(const manifest_t* manifest) {
+  return (manifest == NULL) ? 0 : manifest->totalBytes;
+}
+
+
+/*
+ * Returns the size of page docID, or -1 if not listed.
+ */
+long manifest_bytes(const manifest_t* manifest, const int docID) {
+  if (manifest == NULL) {
+    return -1;
+  }
+  int i = manifest_search(manifest, docID);
+  if (i == manifest->numDocs || manifest->docIDs[i] != docID) {
+    return -1;
+  }
+  return manifest->bytes[i];
+}
+
+
+/*
+ * Returns the total size of the pages below docID.
+ */
+long manifest_offset(const manifest_t* manifest, const int docID) {
+  if (manifest == NULL) {
+    return 0;
+  }
+  int i = manifest_search(manifest, docID);
+  return (i == manifest->numDocs) ? manifest->totalBytes : manifest->offsets[i];
+}
+
+
+/*
+ * Returns the first listed docID at or after docID, or one past the last.
+ */
+int manifest_nextDoc(const manifest_t* manifest, const int docID) {
+  if (manifest == NULL) {
+    return docID;
+  }
+  int i = manifest_search(manifest, docID);
+  return (i == manifest->numDocs) ? manifest_lastDoc(manifest) + 1
+                                  : manifest->docIDs[i];
+}
+
+
+/*
+ * Returns the first docID whose offset is at least offset, by binary
+ * search on the offsets.
+ */
+int manifest_docAtOffset(const manifest_t* manifest, const long offset) {
+  if (manifest == NULL) {
+    return 1;
+  }
+
+  //finds the first page starting at or after offset
+  int low = 0;
+  int high = manifest->numDocs;
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (manifest->offsets[mid] < offset) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  if (low == manifest->numDocs) {
+    return manifest_lastDoc(manifest) + 1;
+  }
+  //docIDs in a gap just before that page have the same offset
+  return (low == 0) ? 1 : manifest->docIDs[low - 1] + 1;
+}
+
+
+/*
+ * Frees the manifest; ignores NULL.
+ */
+void manifest_delete(manifest_t* manifest) {
+  if (manifest == NULL) {
+    return;
+  }
+  free(manifest->docIDs);
+  free(manifest->bytes);
+  free(manifest->offsets);
+  free(manifest);
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Returns the index of the first listed page with a docID at least
+ * docID, or numDocs if there is none.
+ */
+static int manifest_search(const manifest_t* manifest, const int docID) {
+  int low = 0;
+  int high = manifest->numDocs;
+  while (low < high) {
+    int mid = low + (high - low) / 2;
+    if (manifest->docIDs[mid] < docID) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Returns a new string pageDirectory/.manifest followed by suffix, or
+ * NULL if out of memory.
+ */
+static char* manifest_path(const char* pageDirectory, const char* suffix) {
+  char* path = malloc(strlen(pageDirectory) + strlen("/.manifest") +
+                      strlen(suffix) + 1);
+  if (path != NULL) {
+    sprintf(path, "%s/.manifest%s", pageDirectory, suffix);
+  }
+  return path;
+}
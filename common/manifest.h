@@ -0,0 +1,114 @@
+/*
+ * manifest.h    Gretchen Kerfoot    Spring 2025
+ *
+ * This is the header file for the manifest module.
+ * A manifest lists the pages a crawl saved in a pageDirectory: how many
+ * there are, and each one's docID, size in bytes, and offset (the bytes
+ * of all the listed pages before it). The crawler writes it beside
+ * .crawler (pageDirectory/.manifest), so the indexer knows the corpus
+ * before reading it: it can size its tables up front, split pages among
+ * threads by bytes rather than by count, and skip docIDs that have no
+ * page instead of stopping at the first one.
+ *
+ * The file is text:
+ *   TSEMANIFEST1
+ *   numDocs totalBytes
+ *   docID bytes offset      (one line per page, in increasing docID order)
+ */
+
+#ifndef __MANIFEST_H
+#define __MANIFEST_H
+
+#include <stdbool.h>
+
+//global types
+typedef struct manifest manifest_t;
+
+/*
+ * Creates a new, empty manifest.
+ *
+ * Returns:
+ *   pointer to a new manifest_t, or NULL if out of memory
+ * Caller is responsible for:
+ *   later calling manifest_delete
+ */
+manifest_t* manifest_new(void);
+
+/*
+ * Lists a saved page.
+ *
+ * Caller provides:
+ *   manifest - valid manifest
+ *   docID - the page's docID, greater than any already listed
+ *   bytes - the size of its page file
+ * Returns:
+ *   true if listed, false if arguments are invalid or out of memory
+ */
+bool manifest_add(manifest_t* manifest, const int docID, const long bytes);
+
+/*
+ * Saves the manifest as pageDirectory/.manifest.
+ *
+ * Returns:
+ *   true if successful, false on error
+ * Notes:
+ *   The manifest is written to .manifest.tmp and renamed over .manifest,
+ *   so a reader never sees a partially written file.
+ */
+bool manifest_save(const manifest_t* manifest, const char* pageDirectory);
+
+/*
+ * Loads pageDirectory/.manifest.
+ *
+ * Returns:
+ *   pointer to a new manifest_t, or NULL if there is none or it is not a
+ *   valid manifest (as from a crawl that did not finish)
+ */
+manifest_t* manifest_load(const char* pageDirectory);
+
+/*
+ * Returns the number of pages listed (0 if manifest is NULL).
+ */
+int manifest_numDocs(const manifest_t* manifest);
+
+/*
+ * Returns the largest docID listed, or 0 if none.
+ */
+int manifest_lastDoc(const manifest_t* manifest);
+
+/*
+ * Returns the total size of the pages listed, in bytes.
+ */
+long manifest_totalBytes(const manifest_t* manifest);
+
+/*
+ * Returns the size of page docID in bytes, or -1 if it is not listed.
+ */
+long manifest_bytes(const manifest_t* manifest, const int docID);
+
+/*
+ * Returns the total size of the listed pages with docIDs below docID;
+ * for a listed page, this is its offset.
+ */
+long manifest_offset(const manifest_t* manifest, const int docID);
+
+/*
+ * Returns the smallest listed docID that is at least docID, or
+ * manifest_lastDoc + 1 if there is none.
+ */
+int manifest_nextDoc(const manifest_t* manifest, const int docID);
+
+/*
+ * Returns the smallest docID whose offset is at least the given offset,
+ * or manifest_lastDoc + 1 if there is none. Splitting the pages at the
+ * docIDs for offsets totalBytes * i / n gives n ranges of about equal
+ * size.
+ */
+int manifest_docAtOffset(const manifest_t* manifest, const long offset);
+
+/*
+ * Frees all memory used by the manifest; ignores NULL.
+ */
+void manifest_delete(manifest_t* manifest);
+
+#endif // __MANIFEST_H
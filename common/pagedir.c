@@ -6,11 +6,16 @@
  * directories, and loading webpage files.
  */
 
+#define _POSIX_C_SOURCE 200809L
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
 #include "webpage.h"
 #include "pagedir.h"
 #include "webpage.h"
@@ -54,14 +59,16 @@ bool pagedir_init(const char* pageDirectory) {
  *   page - a pointer to a valid webpage_t struct
  *   pageDirectory - path to the directory in which to save
  *   docID - unique integer ID for the page
+ * Returns:
+ *   the size of the file written, or -1 on error
  * Notes:
  *   Creates a file named pageDirectory/docID containing: 
  *   the URL (first line), the depth (second line),
  *   the page HTML (following lines)
  */
-void pagedir_save(const webpage_t* page, const char* pageDirectory, const int docID) {
+long pagedir_save(const webpage_t* page, const char* pageDirectory, const int docID) {
   if (page == NULL || pageDirectory == NULL || docID <= 0) {
-    return;
+    return -1;
   }
 
   //builds the path to the new page file (pageDirectory/docID)
@@ -72,7 +79,7 @@ void pagedir_save(const webpage_t* page, const char* pageDirectory, const int do
   FILE* fp = fopen(filepath, "w");
   if (fp == NULL) {
     fprintf(stderr, "Error: Unable to write page to file %s\n", filepath);
-    return;
+    return -1;
   }
 
   //writes URL, depth, and HTML contents
@@ -80,8 +87,13 @@ void pagedir_save(const webpage_t* page, const char* pageDirectory, const int do
   fprintf(fp, "%d\n", webpage_getDepth(page));
   fprintf(fp, "%s", webpage_getHTML(page));
 
-  //closes file
-  fclose(fp);
+  //closes file, noting how much was written
+  long bytes = ferror(fp) ? -1 : ftell(fp);
+  if (fclose(fp) != 0 || bytes < 0) {
+    fprintf(stderr, "Error: Unable to write page to file %s\n", filepath);
+    return -1;
+  }
+  return bytes;
 }
 
 
@@ -173,3 +185,101 @@ webpage_t* pagedir_load(const char* pageDirectory, const int docID) {
   webpage_t* page = webpage_new(url, depth, html);
   return page;
 }
+
+
+/* Makes a webpage from a page file's contents, parsed as pagedir_load
+ * reads the file: the URL up to the first newline, the depth as an 
+ * integer with the whitespace around it, and the rest as the HTML.
+ *
+ * Caller provides:
+ *   buffer - malloc'd file contents with room for len + 1 bytes, which
+ *            become the page's HTML, or are freed
+ *   len - size of the contents
+ * Returns:
+ *   pointer to a new webpage_t, or NULL if any part is missing
+ * Notes:
+ *   file_readLine and file_readFile stop at a 0xFF byte as if at the 
+ *   end of the file, so the contents end there too.
+ */
+webpage_t* pagedir_parse(char* buffer, const size_t len) {
+  if (buffer == NULL) {
+    return NULL;
+  }
+  char* end = memchr(buffer, 0xFF, len);
+  size_t size = (end != NULL) ? (size_t)(end - buffer) : len;
+  buffer[size] = '\0';
+
+  //reads the URL (first line)
+  char* newline = memchr(buffer, '\n', size);
+  size_t urlLen = (newline != NULL) ? (size_t)(newline - buffer) : size;
+  char* url = (size > 0) ? malloc(urlLen + 1) : NULL;
+  if (url == NULL) {
+    free(buffer);
+    return NULL;
+  }
+  memcpy(url, buffer, urlLen);
+  url[urlLen] = '\0';
+
+  //reads the depth (second line) and the whitespace after it
+  char* html = buffer + urlLen + (newline != NULL);
+  char* afterDepth;
+  long depth = strtol(html, &afterDepth, 10);
+  if (afterDepth == html) {
+    free(url);
+    free(buffer);
+    return NULL;
+  }
+  html = afterDepth;
+  while (isspace((unsigned char)*html)) {
+    html++;
+  }
+
+  //keeps the rest of the contents, moved to the front, as the HTML
+  size_t htmlLen = size - (html - buffer);
+  if (htmlLen == 0) {
+    free(url);
+    free(buffer);
+    return NULL;
+  }
+  memmove(buffer, html, htmlLen + 1);
+
+  webpage_t* page = webpage_new(url, (int)depth, buffer);
+  if (page == NULL) {
+    free(url);
+    free(buffer);
+  }
+  return page;
+}
+
+
+/* Looks up when the file pageDirectory/docID was last modified.
+ *
+ * Caller provides:
+ *   pageDirectory - crawler-produced directory
+ *   docID - positive document ID
+ * Returns:
+ *   modification time, 0 if the file does not exist, or -1 on any other
+ *   error
+ * Notes:
+ *   Only ENOENT means the file is gone; a caller that took any other 
+ *   failure for a deleted page would drop pages that still exist.
+ */
+time_t pagedir_mtime(const char* pageDirectory, const int docID) {
+  if (pageDirectory == NULL || docID <= 0) {
+    return -1;
+  }
+
+  char* filepath = malloc(strlen(pageDirectory) + 20); //enough for large integers
+  if (filepath == NULL) {
+    return -1;
+  }
+  sprintf(filepath, "%s/%d", pageDirectory, docID);
+
+  struct stat info;
+  int status = stat(filepath, &info);
+  free(filepath);
+  if (status != 0) {
+    return (errno == ENOENT) ? 0 : -1;
+  }
+  return info.st_mtime;
+}
@@ -14,6 +14,7 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <time.h>
 #include "webpage.h"
 
 /*
@@ -34,11 +35,14 @@ bool pagedir_init(const char* pageDirectory);
  *   page - pointer to valid webpage structure
  *   pageDirectory - path to target directory
  *   docID - unique integer ID for page
+ * Returns:
+ *   the number of bytes written, for the crawl's manifest (see 
+ *   manifest.h), or -1 if the page could not be saved
  * Notes:
  *   The saved file contains the URL (first line), depth (second line),
  *   and the  HTML content (following lines)
  */
-void pagedir_save(const webpage_t* page, const char* pageDirectory, const int docID);
+long pagedir_save(const webpage_t* page, const char* pageDirectory, const int docID);
 
 /*
  * Validates that the given directory was created by the crawler.
@@ -61,5 +65,31 @@ bool pagedir_validate(const char* pageDirectory);
  */
 webpage_t* pagedir_load(const char* pageDirectory, const int docID);
 
+/*
+ * Makes a webpage from the contents of a page file already read into
+ * memory, as pagedir_load would from the file itself.
+ *
+ * Caller provides:
+ *   buffer - malloc'd contents of the file, with room for len + 1 bytes;
+ *            it is taken over, and freed or kept as the page's HTML
+ *   len - number of bytes of the file in buffer
+ * Returns:
+ *   pointer to newly allocated webpage, or NULL if the contents are not
+ *   a saved page
+ */
+webpage_t* pagedir_parse(char* buffer, const size_t len);
+
+/*
+ * Returns the last-modification time of the page file with the given docID.
+ *
+ * Caller provides:
+ *   pageDirectory - path to crawler directory
+ *   docID - integer ID of the document
+ * Returns:
+ *   modification time of pageDirectory/docID, 0 if it does not exist, or
+ *   -1 if it cannot be checked (any other stat error, or out of memory)
+ */
+time_t pagedir_mtime(const char* pageDirectory, const int docID);
+
 #endif // __PAGEDIR_H
 
@@ -0,0 +1,662 @@
+/*
+ * pageloader.c    Gretchen Kerfoot    Spring 2025
+ *
+ * Implementation of the pageloader module.
+ * The pages being read are a ring of depth slots, in docID order: the
+ * oldest is the next to hand out, and as each is handed out, the read
+ * of the next docID starts in its slot.
+ *
+ * With threads, each read is a workpool task that loads the page with
+ * pagedir_load and marks its slot done. With io_uring, each slot moves
+ * through an open and as many reads as the file needs, each submitted
+ * as the one before completes; the completions are collected whenever
+ * the caller waits for a page, and the contents are parsed with
+ * pagedir_parse. The io_uring is driven with raw system calls, so
+ * liburing is not needed; without <linux/io_uring.h> it is left out.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "pagedir.h"
+#include "workpool.h"
+#include "pageloader.h"
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define HAVE_URING
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+#endif
+
+//bytes first allocated for a page the manifest does not give the size of
+#define FIRST_BUFFER 16384
+
+//one page being read
+typedef struct slot {
+  struct pageloader* loader;
+  int docID;
+  bool listed;          //listed in the manifest
+  bool done;            //the read has finished
+  webpage_t* page;      //the page read, or NULL if it could not be
+  char* path;           //pageDirectory/docID
+  char* buf;            //io_uring: the contents read so far
+  size_t len;           //bytes read into buf
+  size_t cap;           //bytes buf can hold, besides a terminating '\0'
+  int fd;               //io_uring: the open file, or -1 before it is open
+} slot_t;
+
+#ifdef HAVE_URING
+//an io_uring's rings, shared with the kernel
+typedef struct uring {
+  int fd;
+  unsigned sqEntries;
+  _Atomic unsigned* sqHead;
+  _Atomic unsigned* sqTail;
+  unsigned sqMask;
+  unsigned* sqArray;
+  struct io_uring_sqe* sqes;
+  _Atomic unsigned* cqHead;
+  _Atomic unsigned* cqTail;
+  unsigned cqMask;
+  struct io_uring_cqe* cqes;
+  void* sqMap;          //the mapped rings
+  size_t sqMapLen;
+  void* cqMap;          //same as sqMap if the kernel maps them together
+  size_t cqMapLen;
+  size_t sqesLen;
+  unsigned toSubmit;    //queued entries not yet submitted
+  int inFlight;         //operations submitted or queued, not completed
+} uring_t;
+#endif
+
+//private type for the loader
+typedef struct pageloader {
+  const char* pageDirectory;
+  const manifest_t* manifest;
+  int lastDoc;
+  pageloader_method_t method;
+  int depth;
+  slot_t* slots;        //ring of depth slots
+  int head;             //slot of the next page to hand out
+  int count;            //slots in use
+  int nextDoc;          //docID to schedule next
+  bool finished;        //no more pages to hand out
+  bool closing;         //being deleted: reads still finishing are discarded
+  int endDoc;           //docID to report once finished
+
+  //PAGELOADER_THREADS
+  workpool_t* pool;
+  pthread_mutex_t lock; //guards the slots' done flags
+  pthread_cond_t readDone;
+
+#ifdef HAVE_URING
+  //PAGELOADER_URING
+  uring_t* ring;
+#endif
+} pageloader_t;
+
+//helper function prototypes
+static bool pageloader_schedule(pageloader_t* loader, int* docID, bool* listed);
+static void pageloader_fill(pageloader_t* loader);
+static void pageloader_start(pageloader_t* loader, slot_t* slot);
+static void pageloader_wait(pageloader_t* loader, slot_t* slot);
+static void pageloader_read(void* arg, void* scratch);
+#ifdef HAVE_URING
+static void pageloader_complete(pageloader_t* loader, slot_t* slot, const int res);
+static void pageloader_finish(slot_t* slot, const bool ok);
+static void pageloader_reap(pageloader_t* loader);
+static uring_t* uring_new(const unsigned entries);
+static void uring_push(uring_t* ring, const struct io_uring_sqe* sqe);
+static void uring_submit(uring_t* ring, const unsigned minComplete);
+static void uring_delete(uring_t* ring);
+#endif
+
+
+/*
+ * Creates a loader, falling back from io_uring to threads, and from
+ * threads to reading synchronously, if they cannot be set up, and starts
+ * the first reads.
+ *
+ * Returns:
+ *   pointer to new loader, or NULL if invalid or out of memory
+ */
+pageloader_t* pageloader_new(const char* pageDirectory, const manifest_t* manifest,
+                             const int firstDoc, const int lastDoc,
+                             const pageloader_method_t method, const int depth) {
+  if (pageDirectory == NULL || firstDoc <= 0 || lastDoc < 0 || depth < 1) {
+    return NULL;
+  }
+  pageloader_t* loader = calloc(1, sizeof(pageloader_t));
+  if (loader == NULL) {
+    return NULL;
+  }
+  loader->pageDirectory = pageDirectory;
+  loader->manifest = manifest;
+  loader->lastDoc = lastDoc;
+  loader->method = method;
+  loader->depth = (method == PAGELOADER_SYNC) ? 1 : depth;
+  loader->nextDoc = firstDoc;
+  pthread_mutex_init(&loader->lock, NULL);
+  pthread_cond_init(&loader->readDone, NULL);
+
+#ifdef HAVE_URING
+  if (loader->method == PAGELOADER_URING) {
+    loader->ring = uring_new(loader->depth);
+  }
+  if (loader->method == PAGELOADER_URING && loader->ring == NULL) {
+    loader->method = PAGELOADER_THREADS;
+  }
+#else
+  if (loader->method == PAGELOADER_URING) {
+    loader->method = PAGELOADER_THREADS;
+  }
+#endif
+  if (loader->method == PAGELOADER_THREADS) {
+    loader->pool = workpool_new(loader->depth, NULL, NULL);
+    if (loader->pool == NULL) {
+      loader->method = PAGELOADER_SYNC;
+      loader->depth = 1;
+    }
+  }
+
+  //each slot's path has room for any docID
+  loader->slots = calloc(loader->depth, sizeof(slot_t));
+  bool ok = (loader->slots != NULL);
+  for (int i = 0; ok && i < loader->depth; i++) {
+    loader->slots[i].loader = loader;
+    loader->slots[i].fd = -1;
+    loader->slots[i].path = malloc(strlen(pageDirectory) + 13);
+    ok = (loader->slots[i].path != NULL);
+  }
+  if (!ok) {
+    pageloader_delete(loader);
+    return NULL;
+  }
+
+  pageloader_fill(loader);
+  return loader;
+}
+
+
+/*
+ * Hands out the oldest slot's page, skipping listed pages that could not
+ * be read, and starts the next read in its place.
+ *
+ * Returns:
+ *   the page, or NULL once there are no more
+ */
+webpage_t* pageloader_next(pageloader_t* loader, int* docID) {
+  if (loader == NULL || docID == NULL) {
+    return NULL;
+  }
+
+  while (!loader->finished) {
+    if (loader->count == 0) {
+      //only a limit on the docIDs ends the schedule
+      loader->finished = true;
+      loader->endDoc = loader->nextDoc;
+      break;
+    }
+
+    //takes the page out of its slot, which the next read may then reuse
+    slot_t* slot = &loader->slots[loader->head];
+    pageloader_wait(loader, slot);
+    webpage_t* page = slot->page;
+    int slotDoc = slot->docID;
+    slot->page = NULL;
+    loader->head = (loader->head + 1) % loader->depth;
+    loader->count--;
+
+    if (page == NULL && !slot->listed) {
+      //a missing page past the manifest is the end
+      loader->finished = true;
+      loader->endDoc = slotDoc;
+      break;
+    }
+    pageloader_fill(loader);
+    if (page != NULL) {
+      *docID = slotDoc;
+      return page;
+    }
+    fprintf(stderr, "Warning: cannot read page %d listed in the manifest\n", slotDoc);
+  }
+
+  *docID = loader->endDoc;
+  return NULL;
+}
+
+
+/*
+ * Returns the method in use.
+ */
+pageloader_method_t pageloader_method(const pageloader_t* loader) {
+  return (loader == NULL) ? PAGELOADER_SYNC : loader->method;
+}
+
+
+/*
+ * Lets the reads in flight finish, then frees everything.
+ */
+void pageloader_delete(pageloader_t* loader) {
+  if (loader == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&loader->lock);
+  loader->closing = true;
+  pthread_mutex_unlock(&loader->lock);
+
+  //workpool_delete runs the reads still queued before it stops
+  workpool_delete(loader->pool);
+#ifdef HAVE_URING
+  if (loader->ring != NULL) {
+    while (loader->ring->inFlight > 0) {
+      uring_submit(loader->ring, 1);
+      pageloader_reap(loader);
+    }
+    uring_delete(loader->ring);
+  }
+#endif
+
+  for (int i = 0; loader->slots != NULL && i < loader->depth; i++) {
+    webpage_delete(loader->slots[i].page);
+    free(loader->slots[i].buf);
+    free(loader->slots[i].path);
+  }
+  free(loader->slots);
+  pthread_cond_destroy(&loader->readDone);
+  pthread_mutex_destroy(&loader->lock);
+  free(loader);
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Picks the next docID to read: the next the manifest lists, or, past
+ * its end, the next in turn, up to lastDoc.
+ *
+ * Returns:
+ *   true with docID and whether it is listed, or false if none is left
+ */
+static bool pageloader_schedule(pageloader_t* loader, int* docID, bool* listed) {
+  if (loader->lastDoc != 0 && loader->nextDoc > loader->lastDoc) {
+    return false;
+  }
+  if (loader->nextDoc > manifest_lastDoc(loader->manifest)) {
+    *docID = loader->nextDoc++;
+    *listed = false;
+    return true;
+  }
+
+  int next = manifest_nextDoc(loader->manifest, loader->nextDoc);
+  if (loader->lastDoc != 0 && next > loader->lastDoc) {
+    loader->nextDoc = loader->lastDoc + 1;
+    return false;
+  }
+  *docID = next;
+  *listed = true;
+  loader->nextDoc = next + 1;
+  return true;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Starts reads in every free slot, unless the pages have run out.
+ */
+static void pageloader_fill(pageloader_t* loader) {
+  int docID;
+  bool listed;
+  while (!loader->finished && loader->count < loader->depth &&
+         pageloader_schedule(loader, &docID, &listed)) {
+    slot_t* slot = &loader->slots[(loader->head + loader->count) % loader->depth];
+    slot->docID = docID;
+    slot->listed = listed;
+    slot->done = false;
+    sprintf(slot->path, "%s/%d", loader->pageDirectory, docID);
+    loader->count++;
+    pageloader_start(loader, slot);
+  }
+#ifdef HAVE_URING
+  if (loader->ring != NULL) {
+    uring_submit(loader->ring, 0);
+  }
+#endif
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Starts reading a slot's page, by the loader's method; a synchronous
+ * read waits for pageloader_wait.
+ */
+static void pageloader_start(pageloader_t* loader, slot_t* slot) {
+  switch (loader->method) {
+    case PAGELOADER_SYNC:
+      break;
+
+    case PAGELOADER_THREADS:
+      if (!workpool_submit(loader->pool, pageloader_read, slot)) {
+        pageloader_read(slot, NULL);  //out of memory: reads it here
+      }
+      break;
+
+    case PAGELOADER_URING: {
+#ifdef HAVE_URING
+      long bytes = slot->listed ? manifest_bytes(loader->manifest, slot->docID) : -1;
+      slot->cap = (bytes >= 0) ? (size_t)bytes + 1 : FIRST_BUFFER;
+      slot->buf = malloc(slot->cap + 1);
+      slot->len = 0;
+      slot->fd = -1;
+      if (slot->buf == NULL) {
+        pageloader_finish(slot, false);
+        break;
+      }
+      struct io_uring_sqe sqe = { .opcode = IORING_OP_OPENAT };
+      sqe.fd = AT_FDCWD;
+      sqe.addr = (uintptr_t)slot->path;
+      sqe.open_flags = O_RDONLY;
+      sqe.user_data = (uintptr_t)slot;
+      uring_push(loader->ring, &sqe);
+#endif
+      break;
+    }
+  }
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Waits until a slot's read is done, reading it now if synchronous.
+ */
+static void pageloader_wait(pageloader_t* loader, slot_t* slot) {
+  switch (loader->method) {
+    case PAGELOADER_SYNC:
+      slot->page = pagedir_load(loader->pageDirectory, slot->docID);
+      slot->done = true;
+      break;
+
+    case PAGELOADER_THREADS:
+      pthread_mutex_lock(&loader->lock);
+      while (!slot->done) {
+        pthread_cond_wait(&loader->readDone, &loader->lock);
+      }
+      pthread_mutex_unlock(&loader->lock);
+      break;
+
+    case PAGELOADER_URING:
+#ifdef HAVE_URING
+      pageloader_reap(loader);
+      while (!slot->done) {
+        uring_submit(loader->ring, 1);
+        pageloader_reap(loader);
+      }
+#endif
+      break;
+  }
+}
+
+
+/*
+ * HELPER FUNCTION
+ * A workpool task: loads a slot's page and marks the slot done.
+ */
+static void pageloader_read(void* arg, void* scratch) {
+  slot_t* slot = arg;
+  pageloader_t* loader = slot->loader;
+  pthread_mutex_lock(&loader->lock);
+  bool closing = loader->closing;
+  pthread_mutex_unlock(&loader->lock);
+  webpage_t* page = closing ? NULL : pagedir_load(loader->pageDirectory, slot->docID);
+
+  pthread_mutex_lock(&loader->lock);
+  slot->page = page;
+  slot->done = true;
+  pthread_cond_broadcast(&loader->readDone);
+  pthread_mutex_unlock(&loader->lock);
+}
+
+
+#ifdef HAVE_URING
+/*
+ * HELPER FUNCTION
+ * Moves a slot on when its open or read completes with result res:
+ * an open file is read from the start, and a read that got anything is
+ * followed by another (into a bigger buffer, if this one is full) until
+ * one finds the end of the file.
+ */
+static void pageloader_complete(pageloader_t* loader, slot_t* slot, const int res) {
+  if (slot->fd < 0) {
+    if (res < 0) {
+      pageloader_finish(slot, false);
+      return;
+    }
+    slot->fd = res;
+  } else if (res <= 0) {
+    pageloader_finish(slot, res == 0);
+    return;
+  } else {
+    slot->len += res;
+  }
+
+  if (loader->closing) {
+    pageloader_finish(slot, false);
+    return;
+  }
+  if (slot->len == slot->cap) {
+    char* bigger = realloc(slot->buf, 2 * slot->cap + 1);
+    if (bigger == NULL) {
+      pageloader_finish(slot, false);
+      return;
+    }
+    slot->buf = bigger;
+    slot->cap *= 2;
+  }
+
+  struct io_uring_sqe sqe = { .opcode = IORING_OP_READ };
+  sqe.fd = slot->fd;
+  sqe.addr = (uintptr_t)(slot->buf + slot->len);
+  sqe.len = slot->cap - slot->len;
+  sqe.off = slot->len;
+  sqe.user_data = (uintptr_t)slot;
+  uring_push(loader->ring, &sqe);
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Closes a slot's file and marks it done, with its page parsed from what
+ * was read if ok.
+ */
+static void pageloader_finish(slot_t* slot, const bool ok) {
+  if (slot->fd >= 0) {
+    close(slot->fd);
+    slot->fd = -1;
+  }
+  if (ok && !slot->loader->closing) {
+    slot->page = pagedir_parse(slot->buf, slot->len);  //takes over buf
+  } else {
+    free(slot->buf);
+  }
+  slot->buf = NULL;
+  slot->done = true;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Handles every completion the kernel has posted.
+ */
+static void pageloader_reap(pageloader_t* loader) {
+  uring_t* ring = loader->ring;
+  unsigned head = atomic_load_explicit(ring->cqHead, memory_order_relaxed);
+  unsigned tail = atomic_load_explicit(ring->cqTail, memory_order_acquire);
+
+  while (head != tail) {
+    struct io_uring_cqe* cqe = &ring->cqes[head & ring->cqMask];
+    ring->inFlight--;
+    pageloader_complete(loader, (slot_t*)(uintptr_t)cqe->user_data, cqe->res);
+    head++;
+    if (head == tail) {
+      //completions handled may have been followed by more
+      atomic_store_explicit(ring->cqHead, head, memory_order_release);
+      tail = atomic_load_explicit(ring->cqTail, memory_order_acquire);
+    }
+  }
+  atomic_store_explicit(ring->cqHead, head, memory_order_release);
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Sets up an io_uring with room for entries operations, and checks that
+ * the kernel can open and read files with it.
+ *
+ * Returns:
+ *   pointer to new ring, or NULL if io_uring is unavailable, not allowed,
+ *   or too old, or if out of memory
+ */
+static uring_t* uring_new(const unsigned entries) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int fd = syscall(__NR_io_uring_setup, entries, &params);
+  if (fd < 0) {
+    return NULL;
+  }
+
+  //asks which operations the kernel supports
+  const int numOps = IORING_OP_READ + 1;
+  struct io_uring_probe* probe = calloc(1, sizeof(struct io_uring_probe) +
+                                        numOps * sizeof(struct io_uring_probe_op));
+  uring_t* ring = calloc(1, sizeof(uring_t));
+  bool ok = (probe != NULL && ring != NULL &&
+             syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE,
+                     probe, numOps) == 0 &&
+             probe->ops_len > IORING_OP_READ &&
+             (probe->ops[IORING_OP_OPENAT].flags & IO_URING_OP_SUPPORTED) &&
+             (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED));
+  free(probe);
+  if (!ok) {
+    free(ring);
+    close(fd);
+    return NULL;
+  }
+
+  //maps the submission and completion rings, and the submission entries
+  ring->fd = fd;
+  ring->sqMapLen = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cqMapLen = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single) {
+    if (ring->cqMapLen > ring->sqMapLen) {
+      ring->sqMapLen = ring->cqMapLen;
+    }
+    ring->cqMapLen = ring->sqMapLen;
+  }
+  ring->sqMap = mmap(NULL, ring->sqMapLen, PROT_READ | PROT_WRITE, MAP_SHARED,
+                     fd, IORING_OFF_SQ_RING);
+  ring->cqMap = single ? ring->sqMap
+                       : mmap(NULL, ring->cqMapLen, PROT_READ | PROT_WRITE,
+                              MAP_SHARED, fd, IORING_OFF_CQ_RING);
+  ring->sqesLen = params.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(NULL, ring->sqesLen, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    fd, IORING_OFF_SQES);
+  if (ring->sqMap == MAP_FAILED || ring->cqMap == MAP_FAILED ||
+      ring->sqes == MAP_FAILED) {
+    uring_delete(ring);
+    return NULL;
+  }
+
+  char* sq = ring->sqMap;
+  char* cq = ring->cqMap;
+  ring->sqEntries = params.sq_entries;
+  ring->sqHead = (_Atomic unsigned*)(sq + params.sq_off.head);
+  ring->sqTail = (_Atomic unsigned*)(sq + params.sq_off.tail);
+  ring->sqMask = *(unsigned*)(sq + params.sq_off.ring_mask);
+  ring->sqArray = (unsigned*)(sq + params.sq_off.array);
+  ring->cqHead = (_Atomic unsigned*)(cq + params.cq_off.head);
+  ring->cqTail = (_Atomic unsigned*)(cq + params.cq_off.tail);
+  ring->cqMask = *(unsigned*)(cq + params.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+  return ring;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Queues an operation, to be submitted by the next uring_submit. There
+ * is always room: each slot has at most one operation in flight, and the
+ * ring has an entry for every slot.
+ */
+static void uring_push(uring_t* ring, const struct io_uring_sqe* sqe) {
+  unsigned tail = atomic_load_explicit(ring->sqTail, memory_order_relaxed);
+  unsigned index = tail & ring->sqMask;
+  ring->sqes[index] = *sqe;
+  ring->sqArray[index] = index;
+  atomic_store_explicit(ring->sqTail, tail + 1, memory_order_release);
+  ring->toSubmit++;
+  ring->inFlight++;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Submits the queued operations and waits until at least minComplete
+ * operations have completed.
+ * Notes:
+ *   If the kernel refuses the ring, nothing can be done safely with the
+ *   buffers it may still be writing to, so the program exits, as
+ *   mem_assert does when out of memory.
+ */
+static void uring_submit(uring_t* ring, const unsigned minComplete) {
+  if (ring->toSubmit == 0 && minComplete == 0) {
+    return;
+  }
+  while (true) {
+    long submitted = syscall(__NR_io_uring_enter, ring->fd, ring->toSubmit,
+                             minComplete, minComplete > 0 ? IORING_ENTER_GETEVENTS : 0,
+                             NULL, 0);
+    if (submitted >= 0) {
+      ring->toSubmit -= submitted;
+      return;
+    }
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      fprintf(stderr, "Error: io_uring_enter failed: %s\n", strerror(errno));
+      exit(99);
+    }
+  }
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Unmaps and closes a ring; ignores NULL.
+ */
+static void uring_delete(uring_t* ring) {
+  if (ring == NULL) {
+    return;
+  }
+  if (ring->sqes != NULL && ring->sqes != MAP_FAILED) {
+    munmap(ring->sqes, ring->sqesLen);
+  }
+  if (ring->cqMap != NULL && ring->cqMap != MAP_FAILED && ring->cqMap != ring->sqMap) {
+    munmap(ring->cqMap, ring->cqMapLen);
+  }
+  if (ring->sqMap != NULL && ring->sqMap != MAP_FAILED) {
+    munmap(ring->sqMap, ring->sqMapLen);
+  }
+  close(ring->fd);
+  free(ring);
+}
+#endif
@@ -0,0 +1,91 @@
+/*
+ * pageloader.h    Gretchen Kerfoot    Spring 2025
+ *
+ * This is the header file for the pageloader module.
+ * A pageloader hands the pages of a crawl to the indexer one at a time,
+ * in docID order, while it reads the next ones ahead in the background,
+ * so that the latency of one page file's open and read overlaps those
+ * of many others. Indexing a crawl that is not in the page cache (as on
+ * network block storage) waits on I/O far more than it computes; with
+ * dozens of reads in flight, that waiting mostly disappears.
+ *
+ * Pages are read ahead in one of two ways:
+ *   PAGELOADER_URING - every open and read is queued on an io_uring,
+ *                      and the calling thread collects the completions;
+ *                      where the kernel does not allow io_uring, the
+ *                      loader falls back to threads
+ *   PAGELOADER_THREADS - a pool of threads, one per read in flight,
+ *                      each reads and parses whole pages
+ * PAGELOADER_SYNC reads each page only when it is asked for, with
+ * pagedir_load, as the indexer always did.
+ *
+ * Which pages are read is the same for every method. With a manifest
+ * (see manifest.h), the docIDs it lists are read, a listed page that
+ * cannot be read is skipped with a warning, and past its last docID,
+ * as without one, pages are read until one is missing.
+ */
+
+#ifndef __PAGELOADER_H
+#define __PAGELOADER_H
+
+#include <stdbool.h>
+#include "webpage.h"
+#include "manifest.h"
+
+//global types
+typedef struct pageloader pageloader_t;
+
+typedef enum pageloader_method {
+  PAGELOADER_SYNC,
+  PAGELOADER_THREADS,
+  PAGELOADER_URING
+} pageloader_method_t;
+
+/*
+ * Creates a loader for pages firstDoc through lastDoc and starts
+ * reading them.
+ *
+ * Caller provides:
+ *   pageDirectory - path to a valid crawler directory
+ *   manifest - the crawl's manifest, or NULL if it has none; it must
+ *              outlive the loader
+ *   firstDoc - first docID to read
+ *   lastDoc - last docID to read, or 0 for no limit
+ *   method - how to read ahead
+ *   depth - the most reads to keep in flight, at least 1 (ignored by
+ *           PAGELOADER_SYNC)
+ * Returns:
+ *   pointer to a new pageloader_t, or NULL if arguments are invalid or
+ *   out of memory
+ * Caller is responsible for:
+ *   later calling pageloader_delete
+ */
+pageloader_t* pageloader_new(const char* pageDirectory, const manifest_t* manifest,
+                             const int firstDoc, const int lastDoc,
+                             const pageloader_method_t method, const int depth);
+
+/*
+ * Returns the next page, waiting for it to be read if need be.
+ *
+ * Caller provides:
+ *   loader - valid loader
+ *   docID - set to the page's docID
+ * Returns:
+ *   the page, which the caller must webpage_delete, or NULL if there are
+ *   no more; *docID is then one past the last docID covered
+ */
+webpage_t* pageloader_next(pageloader_t* loader, int* docID);
+
+/*
+ * Returns the method the loader reads with, which is PAGELOADER_THREADS
+ * if it fell back from io_uring.
+ */
+pageloader_method_t pageloader_method(const pageloader_t* loader);
+
+/*
+ * Waits for the reads still in flight, then frees the loader and any
+ * pages it read that were not taken; ignores NULL.
+ */
+void pageloader_delete(pageloader_t* loader);
+
+#endif // __PAGELOADER_H
@@ -0,0 +1,484 @@
+/*
+ * plist.c    Gretchen Kerfoot    Spring 2025
+ *
+ * Implementation of the plist module, a compressed postings list.
+ * Postings are delta-encoded by docID and written with vbyte; the count
+ * rides in the low bit of the gap so that count-1 postings cost nothing
+ * extra. The most recently added posting is kept unencoded ("pending")
+ * until a larger docID arrives, so plist_add can keep incrementing it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "plist.h"
+#include "vbyte.h"
+
+//private type for the postings list
+typedef struct plist {
+  unsigned char* data;  //encoded postings, not including the pending one
+  int len;              //bytes of data in use
+  int cap;              //bytes of data allocated
+  int size;             //number of postings, including the pending one
+  int prevDoc;          //docID of the last encoded posting, 0 if none
+  int pendDoc;          //docID of the pending posting, 0 if none
+  int pendCount;        //count of the pending posting
+} plist_t;
+
+//helper function prototypes
+static bool plist_reserve(plist_t* pl, const int extra);
+static int plist_encode(unsigned char* buf, const int gap, const int count);
+static bool plist_flush(plist_t* pl);
+static bool plist_check(const plist_t* pl);
+
+
+/*
+ * Creates a new, empty postings list.
+ *
+ * Returns:
+ *   pointer to new plist, or NULL if out of memory
+ */
+plist_t* plist_new(void) {
+  plist_t* pl = malloc(sizeof(plist_t));
+  if (pl == NULL) {
+    return NULL;
+  }
+
+  pl->data = NULL;
+  pl->len = 0;
+  pl->cap = 0;
+  pl->size = 0;
+  pl->prevDoc = 0;
+  pl->pendDoc = 0;
+  pl->pendCount = 0;
+  return pl;
+}
+
+
+/*
+ * Counts one more occurrence in docID, starting a new posting if docID
+ * is larger than any seen so far.
+ *
+ * Returns:
+ *   true if success, false if docID is out of order or out of memory
+ */
+bool plist_add(plist_t* pl, const int docID) {
+  if (pl == NULL || docID <= 0) {
+    return false;
+  }
+
+  if (docID == pl->pendDoc) {
+    pl->pendCount++;
+    return true;
+  }
+
+  return plist_append(pl, docID, 1);
+}
+
+
+/*
+ * Appends a complete posting; docID must exceed every docID in the list.
+ *
+ * Returns:
+ *   true if success, false if invalid or out of memory
+ */
+bool plist_append(plist_t* pl, const int docID, const int count) {
+  if (pl == NULL || count <= 0 || docID <= plist_lastDoc(pl)) {
+    return false;
+  }
+
+  if (!plist_flush(pl)) {
+    return false;
+  }
+
+  pl->pendDoc = docID;
+  pl->pendCount = count;
+  pl->size++;
+  return true;
+}
+
+
+/*
+ * Appends src to dst: re-encodes src's first posting relative to the end
+ * of dst, then copies the remaining encoded bytes as they are.
+ *
+ * Returns:
+ *   true if success, false if out of order or out of memory
+ */
+bool plist_concat(plist_t* dst, const plist_t* src) {
+  if (dst == NULL || src == NULL) {
+    return false;
+  }
+  if (src->size == 0) {
+    return true;
+  }
+
+  //a list whose only posting is pending has no encoded bytes to copy
+  if (src->len == 0) {
+    return plist_append(dst, src->pendDoc, src->pendCount);
+  }
+
+  //decodes the first encoded posting of src
+  const unsigned char* pos = src->data;
+  const unsigned char* end = src->data + src->len;
+  unsigned int word = vbyte_decode(&pos, end);
+  int count = (word & 1) ? (int)vbyte_decode(&pos, end) + 2 : 1;
+  int firstDoc = (int)(word >> 1);
+
+  if (!plist_append(dst, firstDoc, count) || !plist_flush(dst)) {
+    return false;
+  }
+
+  //the rest of src's encoding is relative to firstDoc, so copies as is
+  int rest = src->len - (int)(pos - src->data);
+  if (!plist_reserve(dst, rest)) {
+    return false;
+  }
+  memcpy(dst->data + dst->len, pos, rest);
+  dst->len += rest;
+  dst->size += src->size - 1 - (src->pendDoc != 0 ? 1 : 0);
+  dst->prevDoc = src->prevDoc;
+
+  if (src->pendDoc != 0) {
+    return plist_append(dst, src->pendDoc, src->pendCount);
+  }
+  return true;
+}
+
+
+/*
+ * Returns number of postings in the list.
+ */
+int plist_size(const plist_t* pl) {
+  return (pl == NULL) ? 0 : pl->size;
+}
+
+
+/*
+ * Returns smallest docID in the list.
+ */
+int plist_firstDoc(const plist_t* pl) {
+  if (pl == NULL) {
+    return 0;
+  }
+  if (pl->len == 0) {
+    return pl->pendDoc;
+  }
+
+  const unsigned char* pos = pl->data;
+  return (int)(vbyte_decode(&pos, pl->data + pl->len) >> 1);
+}
+
+
+/*
+ * Returns largest docID in the list.
+ */
+int plist_lastDoc(const plist_t* pl) {
+  if (pl == NULL) {
+    return 0;
+  }
+  return (pl->pendDoc != 0) ? pl->pendDoc : pl->prevDoc;
+}
+
+
+/*
+ * Reports whether the list's docIDs are dense in their range.
+ */
+bool plist_isDense(const plist_t* pl) {
+  if (pl == NULL || pl->size < PLIST_DENSE_MIN) {
+    return false;
+  }
+  int range = plist_lastDoc(pl) - plist_firstDoc(pl) + 1;
+  return (long)pl->size * PLIST_DENSE >= range;
+}
+
+
+/*
+ * Returns bytes of memory used by the list.
+ */
+size_t plist_memory(const plist_t* pl) {
+  return (pl == NULL) ? 0 : sizeof(plist_t) + pl->cap;
+}
+
+
+/*
+ * Decodes each posting in docID order and passes it to itemfunc.
+ */
+void plist_iterate(const plist_t* pl, void* arg,
+                   void (*itemfunc)(void* arg, const int docID, const int count)) {
+  if (pl == NULL || itemfunc == NULL) {
+    return;
+  }
+
+  const unsigned char* pos = pl->data;
+  const unsigned char* end = pl->data + pl->len;
+  int docID = 0;
+
+  while (pos < end) {
+    unsigned int word = vbyte_decode(&pos, end);
+    int count = 1;
+    if (word & 1) {
+      count = (int)vbyte_decode(&pos, end) + 2;
+    }
+    docID += (int)(word >> 1);
+    (*itemfunc)(arg, docID, count);
+  }
+
+  if (pl->pendDoc != 0) {
+    (*itemfunc)(arg, pl->pendDoc, pl->pendCount);
+  }
+}
+
+
+/*
+ * Decodes every posting into the docIDs and counts arrays, stopping at
+ * the list's size however many bytes it has.
+ *
+ * Returns:
+ *   number of postings decoded
+ */
+int plist_decode(const plist_t* pl, int* docIDs, int* counts) {
+  if (pl == NULL || docIDs == NULL || counts == NULL) {
+    return 0;
+  }
+
+  const unsigned char* pos = pl->data;
+  const unsigned char* end = pl->data + pl->len;
+  int docID = 0;
+  int n = 0;
+
+  while (pos < end && n < pl->size) {
+    unsigned int word = vbyte_decode(&pos, end);
+    int count = 1;
+    if (word & 1) {
+      count = (int)vbyte_decode(&pos, end) + 2;
+    }
+    docID += (int)(word >> 1);
+    docIDs[n] = docID;
+    counts[n] = count;
+    n++;
+  }
+
+  if (pl->pendDoc != 0 && n < pl->size) {
+    docIDs[n] = pl->pendDoc;
+    counts[n] = pl->pendCount;
+    n++;
+  }
+  return n;
+}
+
+
+/*
+ * Decodes every posting onto the end of a postings list, reserving room
+ * for all of them first so that each append is a plain store.
+ *
+ * Returns:
+ *   true if successful, false on NULL or out of memory
+ */
+bool plist_toPostings(const plist_t* pl, postings_t* postings) {
+  if (pl == NULL || postings == NULL) {
+    return false;
+  }
+  if (!postings_reserve(postings, postings_size(postings) + pl->size)) {
+    return false;
+  }
+
+  const unsigned char* pos = pl->data;
+  const unsigned char* end = pl->data + pl->len;
+  int docID = 0;
+  bool ok = true;
+
+  while (pos < end) {
+    unsigned int word = vbyte_decode(&pos, end);
+    int count = 1;
+    if (word & 1) {
+      count = (int)vbyte_decode(&pos, end) + 2;
+    }
+    docID += (int)(word >> 1);
+    ok = postings_add(postings, docID, count) && ok;
+  }
+
+  if (pl->pendDoc != 0) {
+    ok = postings_add(postings, pl->pendDoc, pl->pendCount) && ok;
+  }
+  return ok;
+}
+
+
+/*
+ * Writes the list to fp, encoding the pending posting on the way out.
+ *
+ * Returns:
+ *   true if success, false on error
+ */
+bool plist_write(const plist_t* pl, FILE* fp) {
+  if (pl == NULL || fp == NULL) {
+    return false;
+  }
+
+  unsigned char tail[2 * VBYTE_MAXLEN];
+  int tailLen = 0;
+  if (pl->pendDoc != 0) {
+    tailLen = plist_encode(tail, pl->pendDoc - pl->prevDoc, pl->pendCount);
+  }
+
+  if (!vbyte_write(fp, pl->size) ||
+      !vbyte_write(fp, plist_lastDoc(pl)) ||
+      !vbyte_write(fp, pl->len + tailLen)) {
+    return false;
+  }
+  if (pl->len > 0 && fwrite(pl->data, 1, pl->len, fp) != (size_t)pl->len) {
+    return false;
+  }
+  if (tailLen > 0 && fwrite(tail, 1, tailLen, fp) != (size_t)tailLen) {
+    return false;
+  }
+  return true;
+}
+
+
+/*
+ * Reads a list written by plist_write; the data buffer is sized exactly.
+ * The postings are decoded once, so that a corrupt or truncated file is
+ * rejected here rather than overrunning a caller's arrays later.
+ *
+ * Returns:
+ *   pointer to new plist, or NULL on EOF or error
+ */
+plist_t* plist_read(FILE* fp) {
+  unsigned int size, lastDoc, nbytes;
+  if (!vbyte_read(fp, &size) || !vbyte_read(fp, &lastDoc) ||
+      !vbyte_read(fp, &nbytes)) {
+    return NULL;
+  }
+  if (size > INT_MAX || lastDoc > INT_MAX || nbytes > INT_MAX) {
+    return NULL;
+  }
+
+  plist_t* pl = plist_new();
+  if (pl == NULL) {
+    return NULL;
+  }
+
+  if (nbytes > 0) {
+    pl->data = malloc(nbytes);
+    if (pl->data == NULL || fread(pl->data, 1, nbytes, fp) != nbytes) {
+      plist_delete(pl);
+      return NULL;
+    }
+  }
+
+  pl->len = nbytes;
+  pl->cap = nbytes;
+  pl->size = size;
+  pl->prevDoc = lastDoc;
+  if (!plist_check(pl)) {
+    plist_delete(pl);
+    return NULL;
+  }
+  return pl;
+}
+
+
+/*
+ * Frees all memory used by the list.
+ */
+void plist_delete(plist_t* pl) {
+  if (pl == NULL) return;
+
+  free(pl->data);
+  free(pl);
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Ensures there is room for extra more bytes of data.
+ */
+static bool plist_reserve(plist_t* pl, const int extra) {
+  if (pl->len + extra <= pl->cap) {
+    return true;
+  }
+
+  int cap = (pl->cap == 0) ? 8 : pl->cap * 2;
+  while (cap < pl->len + extra) {
+    cap *= 2;
+  }
+
+  unsigned char* data = realloc(pl->data, cap);
+  if (data == NULL) {
+    return false;
+  }
+  pl->data = data;
+  pl->cap = cap;
+  return true;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Encodes one posting into buf; returns the number of bytes written.
+ */
+static int plist_encode(unsigned char* buf, const int gap, const int count) {
+  unsigned int word = ((unsigned int)gap << 1) | (count > 1 ? 1 : 0);
+  int len = vbyte_encode(buf, word);
+  if (count > 1) {
+    len += vbyte_encode(buf + len, count - 2);
+  }
+  return len;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Moves the pending posting, if any, into the encoded data.
+ */
+static bool plist_flush(plist_t* pl) {
+  if (pl->pendDoc == 0) {
+    return true;
+  }
+
+  if (!plist_reserve(pl, 2 * VBYTE_MAXLEN)) {
+    return false;
+  }
+
+  pl->len += plist_encode(pl->data + pl->len, pl->pendDoc - pl->prevDoc,
+                          pl->pendCount);
+  pl->prevDoc = pl->pendDoc;
+  pl->pendDoc = 0;
+  pl->pendCount = 0;
+  return true;
+}
+
+
+/*
+ * HELPER FUNCTION
+ * Checks a list just read: its bytes must hold exactly size postings,
+ * with increasing docIDs and counts that fit in an int, ending at
+ * lastDoc (prevDoc) and at the last byte.
+ */
+static bool plist_check(const plist_t* pl) {
+  if (!vbyte_complete(pl->data, pl->len)) {
+    return false;
+  }
+
+  const unsigned char* pos = pl->data;
+  const unsigned char* end = pl->data + pl->len;
+  int docID = 0;
+  int n = 0;
+
+  while (pos < end) {
+    unsigned int word = vbyte_decode(&pos, end);
+    unsigned int gap = word >> 1;
+    if (gap == 0 || gap > (unsigned int)(INT_MAX - docID) || n == pl->size) {
+      return false;
+    }
+    if ((word & 1) && (pos == end || vbyte_decode(&pos, end) > INT_MAX - 2)) {
+      return false;
+    }
+    docID += (int)gap;
+    n++;
+  }
+  return n == pl->size && docID == pl->prevDoc;
+}
@@ -0,0 +1,167 @@
+/*
+ * plist.h    Gretchen Kerfoot    Spring 2025
+ *
+ * This is the header file for the plist module.
+ * A plist is a compressed postings list: the (docID, count) pairs for one
+ * word, kept sorted by docID and stored as a byte string. Each posting is
+ * encoded as
+ *
+ *   vbyte((docID - previousDocID) << 1 | (count > 1))  [vbyte(count - 2)]
+ *
+ * so a posting with a small docID gap and a count of one (the common case)
+ * takes a single byte. The same encoding is used in memory and in the
+ * index file.
+ *
+ * Postings must be added in nondecreasing docID order, which is the order
+ * in which the indexer visits documents.
+ */
+
+#ifndef __PLIST_H
+#define __PLIST_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "postings.h"
+
+//global types
+typedef struct plist plist_t;
+
+//a list with at least PLIST_DENSE_MIN docIDs, and a docID in at least one
+//in PLIST_DENSE of its range, is dense
+#define PLIST_DENSE 8
+#define PLIST_DENSE_MIN 32
+
+/*
+ * Creates a new, empty postings list.
+ *
+ * Returns:
+ *   pointer to a new plist_t, or NULL if out of memory
+ * Caller is responsible for:
+ *   later calling plist_delete
+ */
+plist_t* plist_new(void);
+
+/*
+ * Counts one more occurrence of the word in docID.
+ *
+ * Caller provides:
+ *   pl - valid postings list
+ *   docID - positive docID, no smaller than any docID already added
+ * Returns:
+ *   true if successful, false if docID is out of order or out of memory
+ * Notes:
+ *   Repeated calls with the same docID increment its count.
+ */
+bool plist_add(plist_t* pl, const int docID);
+
+/*
+ * Appends a complete posting to the list.
+ *
+ * Caller provides:
+ *   pl - valid postings list
+ *   docID - positive docID, larger than any docID already in the list
+ *   count - positive occurrence count
+ * Returns:
+ *   true if successful, false if arguments are invalid or out of memory
+ */
+bool plist_append(plist_t* pl, const int docID, const int count);
+
+/*
+ * Appends all postings of src to the end of dst.
+ *
+ * Caller provides:
+ *   dst - valid postings list
+ *   src - valid postings list whose first docID is larger than any
+ *         docID in dst
+ * Returns:
+ *   true if successful, false if out of order or out of memory
+ * Notes:
+ *   Only the first posting of src is re-encoded; the rest is copied.
+ *   src is unchanged.
+ */
+bool plist_concat(plist_t* dst, const plist_t* src);
+
+/*
+ * Returns the number of postings (documents) in the list, or 0 if NULL.
+ */
+int plist_size(const plist_t* pl);
+
+/*
+ * Returns the smallest docID in the list, or 0 if empty or NULL.
+ */
+int plist_firstDoc(const plist_t* pl);
+
+/*
+ * Returns the largest docID in the list, or 0 if empty or NULL.
+ */
+int plist_lastDoc(const plist_t* pl);
+
+/*
+ * Returns true if the list is dense enough that its postings are better
+ * kept as a bitmap (see bitmap.h) than as a sorted list: if it has at 
+ * least PLIST_DENSE_MIN docIDs, and at least one docID in PLIST_DENSE of 
+ * the range from its first docID to its last. Returns false if NULL.
+ */
+bool plist_isDense(const plist_t* pl);
+
+/*
+ * Returns the number of bytes of memory used by the list, or 0 if NULL.
+ */
+size_t plist_memory(const plist_t* pl);
+
+/*
+ * Calls itemfunc(arg, docID, count) once for each posting, in increasing
+ * docID order. Does nothing if pl or itemfunc is NULL.
+ */
+void plist_iterate(const plist_t* pl, void* arg,
+                   void (*itemfunc)(void* arg, const int docID, const int count));
+
+/*
+ * Decodes the whole list into the caller's arrays, in increasing docID
+ * order.
+ *
+ * Caller provides:
+ *   pl - valid postings list
+ *   docIDs, counts - arrays with room for plist_size(pl) entries
+ * Returns:
+ *   the number of postings decoded
+ */
+int plist_decode(const plist_t* pl, int* docIDs, int* counts);
+
+/*
+ * Decodes the whole list into a postings list (see postings.h), adding 
+ * each posting's count with postings_add. This is a plain append when 
+ * every docID already in postings is smaller than this list's.
+ *
+ * Caller provides:
+ *   pl - valid postings list
+ *   postings - valid postings list to append to
+ * Returns:
+ *   true if successful, false if either is NULL or out of memory
+ */
+bool plist_toPostings(const plist_t* pl, postings_t* postings);
+
+/*
+ * Writes the list to fp as: vbyte(size) vbyte(lastDoc) vbyte(nbytes) bytes
+ *
+ * Returns:
+ *   true if successful, false on error
+ */
+bool plist_write(const plist_t* pl, FILE* fp);
+
+/*
+ * Reads a list written by plist_write from fp.
+ *
+ * Returns:
+ *   pointer to a new plist_t, or NULL on EOF, malformed input, or error
+ * Caller is responsible for:
+ *   later calling plist_delete
+ */
+plist_t* plist_read(FILE* fp);
+
+/*
+ * Frees all memory used by the list; ignores NULL.
+ */
+void plist_delete(plist_t* pl);
+
+#endif // __PLIST_H
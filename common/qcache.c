@@ -0,0 +1,262 @@
+/*
+ * qcache.c    Gretchen Kerfoot    Spring 2025
+ *
+ * Implementation of the qcache module.
+ * Entries are found through a chained hash table and are also linked in
+ * a list from most to least recently used, so a lookup, an insertion,
+ * and an eviction each take constant time.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "qcache.h"
+#include "hash.h"
+
+#define QCACHE_BUCKETS 64     //initial number of hash buckets
+
+//one cached query result
+typedef struct qentry {
+  char* key;
+  void* data;
+  size_t size;              //bytes of data
+  size_t bytes;             //memory charged to the cache for the entry
+  struct qentry* next;      //next entry in the same bucket
+  struct qentry* newer;     //neighbours in the recency list
+  struct qentry* older;
+} qentry_t;
+
+//private type for the cache
+typedef struct qcache {
+  qentry_t** buckets;
+  int numBuckets;
+  qentry_t* newest;         //most recently used entry
+  qentry_t* oldest;         //least recently used entry, evicted first
+  size_t maxBytes;
+  qcache_stats_t stats;
+} qcache_t;
+
+//function prototypes
+static qentry_t** qcache_slot(const qcache_t* cache, const char* key);
+static void qcache_unlink(qcache_t* cache, qentry_t* entry);
+static void qcache_pushNewest(qcache_t* cache, qentry_t* entry);
+static void qcache_remove(qcache_t* cache, qentry_t* entry);
+static void qcache_grow(qcache_t* cache);
+
+
+/*
+ * Creates a new, empty cache.
+ *
+ * Returns:
+ *   pointer to new cache, or NULL if out of memory
+ */
+qcache_t* qcache_new(const size_t maxBytes) {
+  qcache_t* cache = calloc(1, sizeof(qcache_t));
+  if (cache == NULL) {
+    return NULL;
+  }
+
+  cache->buckets = calloc(QCACHE_BUCKETS, sizeof(qentry_t*));
+  if (cache->buckets == NULL) {
+    free(cache);
+    return NULL;
+  }
+  cache->numBuckets = QCACHE_BUCKETS;
+  cache->maxBytes = maxBytes;
+  return cache;
+}
+
+/*
+ * Looks up a key and marks its entry most recently used.
+ *
+ * Returns:
+ *   the entry's data, or NULL if absent
+ */
+const void* qcache_find(qcache_t* cache, const char* key, size_t* size) {
+  if (cache == NULL || key == NULL) {
+    return NULL;
+  }
+
+  qentry_t* entry = *qcache_slot(cache, key);
+  if (entry == NULL) {
+    cache->stats.misses++;
+    return NULL;
+  }
+
+  cache->stats.hits++;
+  qcache_unlink(cache, entry);
+  qcache_pushNewest(cache, entry);
+  if (size != NULL) {
+    *size = entry->size;
+  }
+  return entry->data;
+}
+
+/*
+ * Caches a copy of the data, evicting old entries to stay in the limit.
+ *
+ * Returns:
+ *   true if cached, false if too large or out of memory
+ */
+bool qcache_insert(qcache_t* cache, const char* key, const void* data,
+                   const size_t size) {
+  if (cache == NULL || key == NULL || (data == NULL && size > 0)) {
+    return false;
+  }
+
+  size_t keyLen = strlen(key) + 1;
+  size_t bytes = sizeof(qentry_t) + keyLen + size;
+  if (bytes > cache->maxBytes) {
+    return false;
+  }
+
+  qentry_t* entry = malloc(bytes);
+  if (entry == NULL) {
+    return false;
+  }
+  //the data (aligned as the entry is) and then the key follow the entry
+  //in the same allocation
+  entry->data = entry + 1;
+  if (size > 0) {
+    memcpy(entry->data, data, size);
+  }
+  entry->key = (char*)entry->data + size;
+  memcpy(entry->key, key, keyLen);
+  entry->size = size;
+  entry->bytes = bytes;
+
+  qentry_t** slot = qcache_slot(cache, key);
+  if (*slot != NULL) {
+    qcache_remove(cache, *slot);
+    slot = qcache_slot(cache, key);
+  }
+  entry->next = NULL;
+  *slot = entry;
+  qcache_pushNewest(cache, entry);
+  cache->stats.entries++;
+  cache->stats.bytes += bytes;
+
+  while (cache->stats.bytes > cache->maxBytes) {
+    qcache_remove(cache, cache->oldest);
+    cache->stats.evictions++;
+  }
+  if (cache->stats.entries > cache->numBuckets) {
+    qcache_grow(cache);
+  }
+  return true;
+}
+
+/*
+ * Removes every entry and counts an invalidation.
+ */
+void qcache_clear(qcache_t* cache) {
+  if (cache == NULL) {
+    return;
+  }
+  while (cache->oldest != NULL) {
+    qcache_remove(cache, cache->oldest);
+  }
+  cache->stats.invalidations++;
+}
+
+/*
+ * Returns a copy of the cache's counters.
+ */
+qcache_stats_t qcache_stats(const qcache_t* cache) {
+  qcache_stats_t none = { 0, 0, 0, 0, 0, 0 };
+  return (cache == NULL) ? none : cache->stats;
+}
+
+/*
+ * Frees the cache and all its entries.
+ */
+void qcache_delete(qcache_t* cache) {
+  if (cache == NULL) {
+    return;
+  }
+  while (cache->oldest != NULL) {
+    qcache_remove(cache, cache->oldest);
+  }
+  free(cache->buckets);
+  free(cache);
+}
+
+/*
+ * HELPER FUNCTION
+ * Returns the link that points (or would point) to key's entry in its
+ * bucket's chain
+ */
+static qentry_t** qcache_slot(const qcache_t* cache, const char* key) {
+  qentry_t** slot = &cache->buckets[hash_jenkins(key, cache->numBuckets)];
+  while (*slot != NULL && strcmp((*slot)->key, key) != 0) {
+    slot = &(*slot)->next;
+  }
+  return slot;
+}
+
+/*
+ * HELPER FUNCTION
+ * Takes an entry out of the recency list
+ */
+static void qcache_unlink(qcache_t* cache, qentry_t* entry) {
+  if (entry->newer != NULL) {
+    entry->newer->older = entry->older;
+  } else {
+    cache->newest = entry->older;
+  }
+  if (entry->older != NULL) {
+    entry->older->newer = entry->newer;
+  } else {
+    cache->oldest = entry->newer;
+  }
+}
+
+/*
+ * HELPER FUNCTION
+ * Puts an entry at the front of the recency list
+ */
+static void qcache_pushNewest(qcache_t* cache, qentry_t* entry) {
+  entry->newer = NULL;
+  entry->older = cache->newest;
+  if (cache->newest != NULL) {
+    cache->newest->newer = entry;
+  } else {
+    cache->oldest = entry;
+  }
+  cache->newest = entry;
+}
+
+/*
+ * HELPER FUNCTION
+ * Unlinks an entry from its bucket and the recency list, and frees it
+ */
+static void qcache_remove(qcache_t* cache, qentry_t* entry) {
+  qentry_t** slot = qcache_slot(cache, entry->key);
+  *slot = entry->next;
+  qcache_unlink(cache, entry);
+  cache->stats.entries--;
+  cache->stats.bytes -= entry->bytes;
+  free(entry);
+}
+
+/*
+ * HELPER FUNCTION
+ * Doubles the number of buckets and rehashes the entries; if out of
+ * memory, the cache keeps its buckets and just has longer chains
+ */
+static void qcache_grow(qcache_t* cache) {
+  int numBuckets = 2 * cache->numBuckets;
+  qentry_t** buckets = calloc(numBuckets, sizeof(qentry_t*));
+  if (buckets == NULL) {
+    return;
+  }
+
+  for (qentry_t* entry = cache->newest; entry != NULL; entry = entry->older) {
+    unsigned long b = hash_jenkins(entry->key, numBuckets);
+    entry->next = buckets[b];
+    buckets[b] = entry;
+  }
+  free(cache->buckets);
+  cache->buckets = buckets;
+  cache->numBuckets = numBuckets;
+}
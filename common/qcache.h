@@ -0,0 +1,93 @@
+/*
+ * qcache.h    Gretchen Kerfoot    Spring 2025
+ *
+ * This is the header file for the qcache module.
+ * A qcache is a least-recently-used cache of query results for the
+ * querier: it maps a string key (a canonical form of the query) to a
+ * block of bytes (the query's ranked results), and keeps the total size
+ * of its entries below a limit by evicting the entries used longest ago.
+ * It counts its hits, misses, evictions, and invalidations.
+ *
+ * A qcache is not safe to use from more than one thread at once.
+ */
+
+#ifndef __QCACHE_H
+#define __QCACHE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+//global types
+typedef struct qcache qcache_t;
+
+//the cache's counters, as returned by qcache_stats
+typedef struct qcache_stats {
+  long hits;            //qcache_find calls that found their key
+  long misses;          //qcache_find calls that did not
+  long evictions;       //entries removed to make room
+  long invalidations;   //qcache_clear calls
+  int entries;          //entries now in the cache
+  size_t bytes;         //memory now used by the entries
+} qcache_stats_t;
+
+/*
+ * Creates a new, empty cache.
+ *
+ * Caller provides:
+ *   maxBytes - most memory the entries may use, counting their keys,
+ *              data, and bookkeeping
+ * Returns:
+ *   pointer to a new qcache_t, or NULL if out of memory
+ * Caller is responsible for:
+ *   later calling qcache_delete
+ */
+qcache_t* qcache_new(const size_t maxBytes);
+
+/*
+ * Looks up a key, counting a hit or a miss; a hit becomes the most
+ * recently used entry.
+ *
+ * Caller provides:
+ *   cache - valid cache
+ *   key - the key to look up
+ *   size - where to store the size of the data (may be NULL)
+ * Returns:
+ *   the entry's data, owned by the cache and valid until the cache is
+ *   next changed, or NULL if the key is not cached
+ */
+const void* qcache_find(qcache_t* cache, const char* key, size_t* size);
+
+/*
+ * Caches a copy of data under a copy of key, replacing any entry with
+ * the same key, then evicts the least recently used entries until the
+ * cache is within its limit.
+ *
+ * Caller provides:
+ *   cache - valid cache
+ *   key - the key
+ *   data, size - the bytes to cache (data may be NULL if size is 0)
+ * Returns:
+ *   true if the entry was cached, false if it alone exceeds the limit or
+ *   out of memory
+ */
+bool qcache_insert(qcache_t* cache, const char* key, const void* data,
+                   const size_t size);
+
+/*
+ * Removes every entry, as when the index the results came from has
+ * changed, and counts an invalidation.
+ */
+void qcache_clear(qcache_t* cache);
+
+/*
+ * Returns the cache's counters (all zero if cache is NULL).
+ */
+qcache_stats_t qcache_stats(const qcache_t* cache);
+
+/*
+ * Frees all memory used by the cache; ignores NULL.
+ */
+void qcache_delete(qcache_t* cache);
+
+#endif // __QCACHE_H
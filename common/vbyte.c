@@ -0,0 +1,55 @@
+/*
+ * vbyte.c    Gretchen Kerfoot    Spring 2025
+ *
+ * Implementation of the vbyte module: reading and writing
+ * variable-byte encoded integers on a FILE stream.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "vbyte.h"
+
+
+/*
+ * Writes value to fp in variable-byte encoding.
+ *
+ * Returns:
+ *   true if successful, false on write error
+ */
+bool vbyte_write(FILE* fp, unsigned int value) {
+  if (fp == NULL) {
+    return false;
+  }
+
+  unsigned char buf[VBYTE_MAXLEN];
+  int len = vbyte_encode(buf, value);
+  return fwrite(buf, 1, len, fp) == (size_t)len;
+}
+
+
+/*
+ * Reads one variable-byte encoded value from fp.
+ *
+ * Returns:
+ *   true if a complete value was read, false on EOF or malformed input
+ */
+bool vbyte_read(FILE* fp, unsigned int* value) {
+  if (fp == NULL || value == NULL) {
+    return false;
+  }
+
+  unsigned int result = 0;
+  for (int i = 0; i < VBYTE_MAXLEN; i++) {
+    int c = getc(fp);
+    if (c == EOF) {
+      return false;
+    }
+    result |= (unsigned int)(c & 0x7f) << (7 * i);
+    if ((c & 0x80) == 0) {
+      *value = result;
+      return true;
+    }
+  }
+
+  return false;  //too many continuation bytes
+}
@@ -0,0 +1,97 @@
+/*
+ * vbyte.h    Gretchen Kerfoot    Spring 2025
+ *
+ * This is the header file for the vbyte module.
+ * It provides variable-byte ("varint") encoding of unsigned integers:
+ * seven bits per byte, low-order group first, with the high bit of each
+ * byte set when more bytes follow. Small values take a single byte.
+ *
+ * The buffer encode/decode functions are defined here as static inline
+ * because they sit in the innermost loop of postings decoding.
+ */
+
+#ifndef __VBYTE_H
+#define __VBYTE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+//maximum number of bytes needed to encode an unsigned int
+#define VBYTE_MAXLEN 5
+
+/*
+ * Encodes value into buf.
+ *
+ * Caller provides:
+ *   buf - buffer with room for at least VBYTE_MAXLEN bytes
+ *   value - value to encode
+ * Returns:
+ *   number of bytes written
+ */
+static inline int vbyte_encode(unsigned char* buf, unsigned int value) {
+  int len = 0;
+  while (value >= 0x80) {
+    buf[len++] = (unsigned char)(value | 0x80);
+    value >>= 7;
+  }
+  buf[len++] = (unsigned char)value;
+  return len;
+}
+
+/*
+ * Decodes one value starting at *pos, and advances *pos past it.
+ *
+ * Caller provides:
+ *   pos - pointer into a buffer, before end
+ *   end - end of the buffer; no byte at or past it is read
+ * Returns:
+ *   the decoded value
+ * Notes:
+ *   A value is cut short at end, or after VBYTE_MAXLEN bytes, even if
+ *   its last byte has the high bit set. So a buffer of values, decoded
+ *   one after another, is complete only if its last byte has the high
+ *   bit clear (see vbyte_complete).
+ */
+static inline unsigned int vbyte_decode(const unsigned char** pos,
+                                        const unsigned char* end) {
+  const unsigned char* p = *pos;
+  unsigned int value = 0;
+  int shift = 0;
+  unsigned char byte;
+  do {
+    byte = *p++;
+    value |= (unsigned int)(byte & 0x7f) << shift;
+    shift += 7;
+  } while ((byte & 0x80) && p < end && shift < 7 * VBYTE_MAXLEN);
+  *pos = p;
+  return value;
+}
+
+/*
+ * Returns true if the len bytes at buf end with the last byte of a value,
+ * as every buffer written by vbyte_encode does; true if len is 0.
+ */
+static inline bool vbyte_complete(const unsigned char* buf, const size_t len) {
+  return len == 0 || (buf[len - 1] & 0x80) == 0;
+}
+
+/*
+ * Writes value to fp in variable-byte encoding.
+ *
+ * Returns:
+ *   true if successful, false on write error
+ */
+bool vbyte_write(FILE* fp, unsigned int value);
+
+/*
+ * Reads one variable-byte encoded value from fp.
+ *
+ * Caller provides:
+ *   fp - file open for reading
+ *   value - where to store the decoded value
+ * Returns:
+ *   true if a complete value was read, false on EOF or malformed input
+ */
+bool vbyte_read(FILE* fp, unsigned int* value);
+
+#endif // __VBYTE_H
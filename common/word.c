@@ -44,3 +44,28 @@ char* normalizeWord(const char* word) {
 
   return norm;
 }
+
+
+/*
+ * Converts word to lowercase in place if alphabetic, so a caller that
+ * owns the word need not copy it.
+ *
+ * Caller provides:
+ *   word - non-null, writable string to normalize
+ * Returns:
+ *   the word's length, or -1 if word contains non-alpha characters
+ */
+int normalizeWordInPlace(char* word) {
+  if (word == NULL) {
+    return -1;
+  }
+
+  int length = 0;
+  for (; word[length] != '\0'; length++) {
+    if (!isalpha((unsigned char)word[length])) {
+      return -1; //rejects words with non-alphabetic characters
+    }
+    word[length] = tolower((unsigned char)word[length]);
+  }
+  return length;
+}
@@ -21,4 +21,15 @@
  */
 char* normalizeWord(const char* word);
 
+/*
+ * Converts word to lowercase in place, if alphabetic.
+ *
+ * Caller provides:
+ *   word - non-null, writable string to normalize
+ * Returns:
+ *   the word's length, or -1 if word contains non-alpha characters (in 
+ *   which case it may be partly lowercased)
+ */
+int normalizeWordInPlace(char* word);
+
 #endif // __WORD_H
@@ -0,0 +1,228 @@
+/*
+ * workpool.c    Gretchen Kerfoot    Spring 2025
+ *
+ * Implementation of the workpool module.
+ * Queued tasks form a linked list guarded by one mutex. Workers sleep on
+ * a condition variable until a task arrives; a task someone is waiting
+ * for (workpool_run) lives on the waiter's stack and is marked done,
+ * other tasks are freed by the worker that ran them.
+ */
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "workpool.h"
+
+//one queued task
+typedef struct work {
+  workpool_task_t task;
+  void* arg;
+  bool waited;              //someone is waiting in workpool_run
+  bool done;                //set once a waited task has run
+  struct work* next;
+} work_t;
+
+//private type for the pool
+typedef struct workpool {
+  pthread_t* threads;
+  int numThreads;
+  void* (*scratchNew)(void);
+  void (*scratchDelete)(void* scratch);
+  pthread_mutex_t lock;     //held while the fields below change
+  pthread_cond_t ready;     //signaled when a task is queued or on stop
+  pthread_cond_t finished;  //broadcast when a task finishes
+  work_t* head;             //next task to run
+  work_t* tail;
+  int pending;              //tasks queued or running
+  bool stopping;
+} workpool_t;
+
+//function prototypes
+static void* workpool_worker(void* arg);
+static void workpool_push(workpool_t* pool, work_t* work);
+
+
+/*
+ * Creates a pool and starts its workers.
+ *
+ * Returns:
+ *   pointer to new pool, or NULL if out of memory or no worker started
+ */
+workpool_t* workpool_new(const int numThreads, void* (*scratchNew)(void),
+                         void (*scratchDelete)(void* scratch)) {
+  if (numThreads < 1) {
+    return NULL;
+  }
+  workpool_t* pool = calloc(1, sizeof(workpool_t));
+  if (pool == NULL) {
+    return NULL;
+  }
+  pool->threads = malloc(numThreads * sizeof(pthread_t));
+  if (pool->threads == NULL) {
+    free(pool);
+    return NULL;
+  }
+  pool->scratchNew = scratchNew;
+  pool->scratchDelete = scratchDelete;
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->ready, NULL);
+  pthread_cond_init(&pool->finished, NULL);
+
+  while (pool->numThreads < numThreads &&
+         pthread_create(&pool->threads[pool->numThreads], NULL,
+                        workpool_worker, pool) == 0) {
+    pool->numThreads++;
+  }
+  if (pool->numThreads == 0) {
+    workpool_delete(pool);
+    return NULL;
+  }
+  return pool;
+}
+
+/*
+ * Queues a task to be run by the next free worker.
+ *
+ * Returns:
+ *   true if queued, false if arguments are invalid or out of memory
+ */
+bool workpool_submit(workpool_t* pool, workpool_task_t task, void* arg) {
+  if (pool == NULL || task == NULL) {
+    return false;
+  }
+  work_t* work = malloc(sizeof(work_t));
+  if (work == NULL) {
+    return false;
+  }
+  work->task = task;
+  work->arg = arg;
+  work->waited = false;
+  work->done = false;
+
+  pthread_mutex_lock(&pool->lock);
+  workpool_push(pool, work);
+  pthread_mutex_unlock(&pool->lock);
+  return true;
+}
+
+/*
+ * Queues a task and waits until it has run.
+ *
+ * Returns:
+ *   true once it has run, false if arguments are invalid
+ */
+bool workpool_run(workpool_t* pool, workpool_task_t task, void* arg) {
+  if (pool == NULL || task == NULL) {
+    return false;
+  }
+  work_t work = { task, arg, true, false, NULL };
+
+  pthread_mutex_lock(&pool->lock);
+  workpool_push(pool, &work);
+  while (!work.done) {
+    pthread_cond_wait(&pool->finished, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return true;
+}
+
+/*
+ * Waits until no task is queued or running.
+ */
+void workpool_wait(workpool_t* pool) {
+  if (pool == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&pool->lock);
+  while (pool->pending > 0) {
+    pthread_cond_wait(&pool->finished, &pool->lock);
+  }
+  pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+ * Returns the number of workers.
+ */
+int workpool_size(const workpool_t* pool) {
+  return (pool == NULL) ? 0 : pool->numThreads;
+}
+
+/*
+ * Lets the workers finish the queue, joins them, and frees the pool.
+ */
+void workpool_delete(workpool_t* pool) {
+  if (pool == NULL) {
+    return;
+  }
+  pthread_mutex_lock(&pool->lock);
+  pool->stopping = true;
+  pthread_cond_broadcast(&pool->ready);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (int i = 0; i < pool->numThreads; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+  pthread_cond_destroy(&pool->finished);
+  pthread_cond_destroy(&pool->ready);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool->threads);
+  free(pool);
+}
+
+/*
+ * HELPER FUNCTION
+ * Thread that makes its scratch, then runs tasks from the queue until
+ * the pool stops and the queue is empty
+ */
+static void* workpool_worker(void* arg) {
+  workpool_t* pool = arg;
+  void* scratch = (pool->scratchNew != NULL) ? (*pool->scratchNew)() : NULL;
+
+  pthread_mutex_lock(&pool->lock);
+  while (true) {
+    while (pool->head == NULL && !pool->stopping) {
+      pthread_cond_wait(&pool->ready, &pool->lock);
+    }
+    work_t* work = pool->head;
+    if (work == NULL) {
+      break;
+    }
+    pool->head = work->next;
+    if (pool->head == NULL) {
+      pool->tail = NULL;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    (*work->task)(work->arg, scratch);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->pending--;
+    if (work->waited) {
+      work->done = true;
+    } else {
+      free(work);
+    }
+    pthread_cond_broadcast(&pool->finished);
+  }
+  pthread_mutex_unlock(&pool->lock);
+
+  if (pool->scratchDelete != NULL && scratch != NULL) {
+    (*pool->scratchDelete)(scratch);
+  }
+  return NULL;
+}
+
+/*
+ * HELPER FUNCTION
+ * Appends a task to the queue and wakes a worker; caller holds the lock
+ */
+static void workpool_push(workpool_t* pool, work_t* work) {
+  work->next = NULL;
+  if (pool->tail != NULL) {
+    pool->tail->next = work;
+  } else {
+    pool->head = work;
+  }
+  pool->tail = work;
+  pool->pending++;
+  pthread_cond_signal(&pool->ready);
+}
@@ -0,0 +1,74 @@
+/*
+ * workpool.h    Gretchen Kerfoot    Spring 2025
+ *
+ * This is the header file for the workpool module.
+ * A workpool is a fixed set of worker threads that run tasks from a
+ * first-in, first-out queue. Each worker owns a scratch object, made
+ * when the worker starts and passed to every task it runs, so tasks can
+ * reuse buffers from one run to the next without sharing them. The
+ * querier uses one to answer independent queries in parallel against
+ * the same read-only index.
+ *
+ * Tasks may be submitted from any number of threads.
+ */
+
+#ifndef __WORKPOOL_H
+#define __WORKPOOL_H
+
+#include <stdbool.h>
+
+//global types
+typedef struct workpool workpool_t;
+
+//a task, run with its argument and the running worker's scratch
+typedef void (*workpool_task_t)(void* arg, void* scratch);
+
+/*
+ * Creates a pool and starts its workers.
+ *
+ * Caller provides:
+ *   numThreads - number of workers, at least 1
+ *   scratchNew - makes a worker's scratch (may be NULL for none)
+ *   scratchDelete - frees a worker's scratch when it stops (may be NULL)
+ * Returns:
+ *   pointer to a new workpool_t, or NULL if out of memory or no worker
+ *   could be started
+ * Caller is responsible for:
+ *   later calling workpool_delete
+ */
+workpool_t* workpool_new(const int numThreads, void* (*scratchNew)(void),
+                         void (*scratchDelete)(void* scratch));
+
+/*
+ * Queues a task to be run by the next free worker, and returns at once.
+ *
+ * Returns:
+ *   true if queued, false if any argument is NULL or out of memory
+ */
+bool workpool_submit(workpool_t* pool, workpool_task_t task, void* arg);
+
+/*
+ * Queues a task and waits for a worker to finish running it.
+ *
+ * Returns:
+ *   true once it has run, false if any argument is NULL
+ */
+bool workpool_run(workpool_t* pool, workpool_task_t task, void* arg);
+
+/*
+ * Waits until every task submitted so far has finished.
+ */
+void workpool_wait(workpool_t* pool);
+
+/*
+ * Returns the number of workers (0 if pool is NULL).
+ */
+int workpool_size(const workpool_t* pool);
+
+/*
+ * Runs the tasks still queued, then stops the workers, frees their
+ * scratch, and frees the pool; ignores NULL.
+ */
+void workpool_delete(workpool_t* pool);
+
+#endif // __WORKPOOL_H
@@ -0,0 +1,406 @@
+/*
+ * corpusgen.c    Gretchen Kerfoot    Spring 2025
+ *
+ * Generates a synthetic crawler pageDirectory of any size, for testing
+ * the indexer and querier at scale without crawling. The directory is
+ * marked with '.crawler' and holds page files 1 .. numDocs in the
+ * crawler's format (URL, depth, HTML), with the crawler's manifest, so
+ * every program that reads a crawl reads it the same way.
+ *
+ * The text of the pages is drawn from a vocabulary with a Zipfian
+ * distribution: the word of rank r appears with probability proportional
+ * to 1 / r^s, as in natural text, so a few words are in nearly every
+ * page and most words are rare. The pages are linked as a tree rooted at
+ * page 1, with the pages numbered in breadth-first order as the crawler
+ * would number them, plus random links between any pages. The same
+ * options and seed always give the same pages.
+ *
+ * Usage: ./corpusgen [--vocab V] [--zipf S] [--words L] [--fanout F]
+ *                    [--links K] [--seed N] pageDirectory numDocs
+ *
+ * Functions:
+ *  main - parses arguments and writes the pages
+ *  parseArgs - parses and validates command-line arguments
+ *  vocabNew - makes the vocabulary and its sampling tables
+ *  vocabSample - draws a word from the vocabulary
+ *  writePage - writes one page file
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <math.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include "webpage.h"
+#include "pagedir.h"
+#include "manifest.h"
+
+#define SITE "http://cs50tse.cs.dartmouth.edu/tse/synthetic/"
+#define PARAGRAPH 60            //words per paragraph, after which links go
+
+//the options that shape the corpus
+typedef struct corpus {
+  const char* pageDirectory;
+  int numDocs;
+  int vocabSize;        //distinct words
+  double zipf;          //exponent s of the word distribution
+  int words;            //average words per page
+  int fanout;           //children of each page in the link tree
+  int links;            //random links per page
+  uint64_t seed;
+} corpus_t;
+
+//a Zipfian vocabulary, sampled in constant time by Walker's alias method:
+//pick a rank uniformly, then keep it with probability prob[rank] or
+//take alias[rank] instead
+typedef struct vocab {
+  char** words;         //by rank, most frequent first
+  double* prob;
+  int* alias;
+  int size;
+} vocab_t;
+
+//local function prototypes
+static void parseArgs(const int argc, char* argv[], corpus_t* corpus);
+static vocab_t* vocabNew(const int size, const double zipf);
+static const char* vocabSample(const vocab_t* vocab, uint64_t* rng);
+static void vocabDelete(vocab_t* vocab);
+static long writePage(const corpus_t* corpus, const vocab_t* vocab,
+                      const int docID, uint64_t* rng);
+static int pageDepth(const int docID, const int fanout);
+static uint64_t nextRandom(uint64_t* rng);
+static double uniform(uint64_t* rng);
+
+
+/*
+ * Parses the arguments, makes the vocabulary, and writes every page.
+ *
+ * Caller provides:
+ *   argc, argv from the command line
+ * Return:
+ *   exit status 0 if successful, nonzero if error
+ */
+int main(const int argc, char* argv[]) {
+  corpus_t corpus = { NULL, 0, 50000, 1.0, 300, 8, 4, 1 };
+  parseArgs(argc, argv, &corpus);
+
+  if (mkdir(corpus.pageDirectory, 0755) != 0 && errno != EEXIST) {
+    fprintf(stderr, "Error: could not create directory '%s'\n", corpus.pageDirectory);
+    exit(2);
+  }
+  if (!pagedir_init(corpus.pageDirectory)) {
+    fprintf(stderr, "Error: could not write to directory '%s'\n", corpus.pageDirectory);
+    exit(2);
+  }
+
+  uint64_t rng = corpus.seed;
+  vocab_t* vocab = vocabNew(corpus.vocabSize, corpus.zipf);
+  manifest_t* manifest = manifest_new();
+  if (vocab == NULL || manifest == NULL) {
+    fprintf(stderr, "Error: out of memory\n");
+    exit(3);
+  }
+
+  for (int docID = 1; docID <= corpus.numDocs; docID++) {
+    long bytes = writePage(&corpus, vocab, docID, &rng);
+    if (bytes < 0 || !manifest_add(manifest, docID, bytes)) {
+      fprintf(stderr, "Error: could not write page %d\n", docID);
+      vocabDelete(vocab);
+      manifest_delete(manifest);
+      exit(3);
+    }
+  }
+  if (!manifest_save(manifest, corpus.pageDirectory)) {
+    fprintf(stderr, "Error: could not write manifest in '%s'\n", corpus.pageDirectory);
+    vocabDelete(vocab);
+    manifest_delete(manifest);
+    exit(3);
+  }
+
+  vocabDelete(vocab);
+  manifest_delete(manifest);
+  return 0;
+}
+
+/*
+ * Parses and validates the command-line arguments.
+ *
+ * Caller provides:
+ *   argc and argv from the command line, and the corpus with its
+ *   default options
+ * Notes:
+ *   Exits with error if arguments are invalid
+ */
+static void parseArgs(const int argc, char* argv[], corpus_t* corpus) {
+  int arg = 1;
+  while (arg + 1 < argc && strncmp(argv[arg], "--", 2) == 0) {
+    const char* option = argv[arg++];
+    const char* value = argv[arg++];
+    char excess;
+    int n = 0;
+    bool ok = (strcmp(option, "--zipf") == 0)
+              ? sscanf(value, "%lf%c", &corpus->zipf, &excess) == 1 && corpus->zipf >= 0
+              : (strcmp(option, "--seed") == 0)
+              ? sscanf(value, "%" SCNu64 "%c", &corpus->seed, &excess) == 1
+              : sscanf(value, "%d%c", &n, &excess) == 1;
+
+    if (strcmp(option, "--vocab") == 0) {
+      corpus->vocabSize = n;
+      ok = ok && n >= 1;
+    } else if (strcmp(option, "--words") == 0) {
+      corpus->words = n;
+      ok = ok && n >= 1;
+    } else if (strcmp(option, "--fanout") == 0) {
+      corpus->fanout = n;
+      ok = ok && n >= 1;
+    } else if (strcmp(option, "--links") == 0) {
+      corpus->links = n;
+      ok = ok && n >= 0;
+    } else if (strcmp(option, "--zipf") != 0 && strcmp(option, "--seed") != 0) {
+      fprintf(stderr, "Unknown option: %s\n", option);
+      exit(1);
+    }
+    if (!ok) {
+      fprintf(stderr, "Invalid value for %s: %s\n", option, value);
+      exit(1);
+    }
+  }
+
+  char excess;
+  if (argc - arg != 2 || sscanf(argv[arg + 1], "%d%c", &corpus->numDocs, &excess) != 1
+      || corpus->numDocs < 1) {
+    fprintf(stderr, "Usage: ./corpusgen [--vocab V] [--zipf S] [--words L] [--fanout F] "
+                    "[--links K] [--seed N] pageDirectory numDocs\n");
+    exit(1);
+  }
+  corpus->pageDirectory = argv[arg];
+}
+
+/*
+ * Makes a vocabulary of size distinct words and the alias tables for
+ * drawing them with probability proportional to 1 / rank^zipf. The word
+ * of each rank is its own string of letters: the rank is scrambled by a
+ * multiplication that is invertible modulo 26^k, then written in base
+ * 26, so distinct ranks give distinct words of k >= 3 letters, and the
+ * common words are not alphabetically clustered.
+ *
+ * Return:
+ *   new vocabulary, or NULL if out of memory
+ */
+static vocab_t* vocabNew(const int size, const double zipf) {
+  vocab_t* vocab = calloc(1, sizeof(vocab_t));
+  double* weight = malloc(size * sizeof(double));
+  int* small = malloc(size * sizeof(int));
+  int* large = malloc(size * sizeof(int));
+  if (vocab != NULL) {
+    vocab->size = size;
+    vocab->words = calloc(size, sizeof(char*));
+    vocab->prob = malloc(size * sizeof(double));
+    vocab->alias = malloc(size * sizeof(int));
+  }
+  if (vocab == NULL || vocab->words == NULL || vocab->prob == NULL ||
+      vocab->alias == NULL || weight == NULL || small == NULL || large == NULL) {
+    vocabDelete(vocab);
+    free(weight);
+    free(small);
+    free(large);
+    return NULL;
+  }
+
+  int length = 3;
+  uint64_t space = 26 * 26 * 26;
+  while (space < (uint64_t)size) {
+    length++;
+    space *= 26;
+  }
+  uint64_t scramble = 1000003 % space;    //odd and not a multiple of 13
+  for (int r = 0; r < size; r++) {
+    char* word = malloc(length + 1);
+    if (word == NULL) {
+      vocabDelete(vocab);
+      free(weight);
+      free(small);
+      free(large);
+      return NULL;
+    }
+    uint64_t code = ((uint64_t)r * scramble + 12345) % space;
+    for (int i = length - 1; i >= 0; i--) {
+      word[i] = 'a' + code % 26;
+      code /= 26;
+    }
+    word[length] = '\0';
+    vocab->words[r] = word;
+  }
+
+  //weights scaled so they average 1; ranks below 1 are topped up from
+  //ranks above 1 (Vose's version of the alias method)
+  double total = 0;
+  for (int r = 0; r < size; r++) {
+    weight[r] = 1 / pow(r + 1, zipf);
+    total += weight[r];
+  }
+  int numSmall = 0;
+  int numLarge = 0;
+  for (int r = 0; r < size; r++) {
+    weight[r] *= size / total;
+    if (weight[r] < 1) {
+      small[numSmall++] = r;
+    } else {
+      large[numLarge++] = r;
+    }
+  }
+  while (numSmall > 0 && numLarge > 0) {
+    int s = small[--numSmall];
+    int l = large[numLarge - 1];
+    vocab->prob[s] = weight[s];
+    vocab->alias[s] = l;
+    weight[l] -= 1 - weight[s];
+    if (weight[l] < 1) {
+      numLarge--;
+      small[numSmall++] = l;
+    }
+  }
+  while (numLarge > 0) {
+    int l = large[--numLarge];
+    vocab->prob[l] = 1;
+    vocab->alias[l] = l;
+  }
+  while (numSmall > 0) {
+    int s = small[--numSmall];
+    vocab->prob[s] = 1;
+    vocab->alias[s] = s;
+  }
+
+  free(weight);
+  free(small);
+  free(large);
+  return vocab;
+}
+
+/*
+ * Draws a word from the vocabulary
+ */
+static const char* vocabSample(const vocab_t* vocab, uint64_t* rng) {
+  int r = nextRandom(rng) % vocab->size;
+  return vocab->words[(uniform(rng) < vocab->prob[r]) ? r : vocab->alias[r]];
+}
+
+/*
+ * Frees the vocabulary; ignores NULL
+ */
+static void vocabDelete(vocab_t* vocab) {
+  if (vocab == NULL) {
+    return;
+  }
+  for (int r = 0; vocab->words != NULL && r < vocab->size; r++) {
+    free(vocab->words[r]);
+  }
+  free(vocab->words);
+  free(vocab->prob);
+  free(vocab->alias);
+  free(vocab);
+}
+
+/*
+ * Writes page docID: between half and one and a half times the average
+ * number of words, in paragraphs, each followed by some of the page's
+ * links to its children in the link tree and to random pages.
+ *
+ * Return:
+ *   the size of the page file, or -1 if out of memory or it could not
+ *   be written
+ */
+static long writePage(const corpus_t* corpus, const vocab_t* vocab,
+                      const int docID, uint64_t* rng) {
+  char* url = NULL;
+  char* html = NULL;
+  size_t htmlLen = 0;
+  FILE* fp = open_memstream(&html, &htmlLen);
+  if (fp == NULL || asprintf(&url, SITE "%d.html", docID) == -1) {
+    if (fp != NULL) {
+      fclose(fp);
+    }
+    free(html);
+    return -1;
+  }
+
+  int numWords = corpus->words / 2 + nextRandom(rng) % (corpus->words + 1);
+  fprintf(fp, "<html>\n<head><title>%s %s</title></head>\n<body>\n",
+          vocabSample(vocab, rng), vocabSample(vocab, rng));
+
+  //the tree numbers children breadth first: page d's are fanout*(d-1)+2 ...
+  long firstChild = (long)corpus->fanout * (docID - 1) + 2;
+  long lastChild = firstChild + corpus->fanout - 1;
+  if (lastChild > corpus->numDocs) {
+    lastChild = corpus->numDocs;
+  }
+  long child = firstChild;
+  int numLinks = corpus->links;
+
+  fprintf(fp, "<p>");
+  for (int w = 0; w < numWords || child <= lastChild || numLinks > 0; w++) {
+    if (w < numWords) {
+      fprintf(fp, "%s%s", (w % PARAGRAPH == 0) ? "" : " ", vocabSample(vocab, rng));
+    }
+    if ((w + 1) % PARAGRAPH == 0 || w + 1 >= numWords) {
+      fprintf(fp, "</p>\n");
+      if (child <= lastChild) {
+        fprintf(fp, "<a href=\"" SITE "%ld.html\">%s</a>\n", child++,
+                vocabSample(vocab, rng));
+      }
+      if (numLinks > 0) {
+        numLinks--;
+        fprintf(fp, "<a href=\"" SITE "%d.html\">%s</a>\n",
+                1 + (int)(nextRandom(rng) % corpus->numDocs), vocabSample(vocab, rng));
+      }
+      fprintf(fp, "<p>");
+    }
+  }
+  fprintf(fp, "</p>\n</body>\n</html>\n");
+  fclose(fp);
+
+  webpage_t* page = webpage_new(url, pageDepth(docID, corpus->fanout), html);
+  if (page == NULL) {
+    free(url);
+    free(html);
+    return -1;
+  }
+  long bytes = pagedir_save(page, corpus->pageDirectory, docID);
+  webpage_delete(page);
+  return bytes;
+}
+
+/*
+ * Returns a page's depth in the link tree rooted at page 1, in which
+ * page d's parent is (d - 2) / fanout + 1
+ */
+static int pageDepth(const int docID, const int fanout) {
+  int depth = 0;
+  for (long d = docID; d > 1; d = (d - 2) / fanout + 1) {
+    depth++;
+  }
+  return depth;
+}
+
+/*
+ * Returns the next number from a splitmix64 generator
+ */
+static uint64_t nextRandom(uint64_t* rng) {
+  uint64_t z = (*rng += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/*
+ * Returns a uniformly random double in [0, 1)
+ */
+static double uniform(uint64_t* rng) {
+  return (nextRandom(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
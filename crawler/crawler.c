@@ -3,7 +3,8 @@
  *
  * This file implements the crawler component of the Tiny Search Engine.
  * The crawler starts from a given seed URL, crawls up to a specific depth,
- * and saves all fetched webpages into the given page directory.
+ * and saves all fetched webpages into the given page directory, with a
+ * manifest of the pages saved (see manifest.h) for the indexer.
  *
  * Functions:
  *  main - parses arguments and intiates crawling
@@ -19,6 +20,7 @@
 #include "bag.h"
 #include "hashtable.h"
 #include "pagedir.h"
+#include "manifest.h"
 
 //local function prototypes
 static void parseArgs(const int argc, char *argv[], char **seedURL, char **pageDirectory, int *maxDepth);
@@ -118,9 +120,12 @@ static void crawl(char *seedURL, char *pageDirectory, const int maxDepth) {
   //initializes hashtable to record seen URLs
   hashtable_t *pagesSeen = hashtable_new(200);
 
+  //initializes manifest to list the pages saved
+  manifest_t *manifest = manifest_new();
+
   //checks initialization success
-  if (pagesToCrawl == NULL || pagesSeen == NULL) {
-    fprintf(stderr, "Error: unable to initialize bag or hashtable\n");
+  if (pagesToCrawl == NULL || pagesSeen == NULL || manifest == NULL) {
+    fprintf(stderr, "Error: unable to initialize bag, hashtable, or manifest\n");
     exit(6);
   }
 
@@ -137,8 +142,11 @@ static void crawl(char *seedURL, char *pageDirectory, const int maxDepth) {
   //main crawling loop: extracts and processes each page
   while ((currPage = bag_extract(pagesToCrawl)) != NULL) {
     if (webpage_fetch(currPage)) {
-      //saves fetched page to pageDirectory
-      pagedir_save(currPage, pageDirectory, docID);
+      //saves fetched page to pageDirectory, listing it if saved
+      long bytes = pagedir_save(currPage, pageDirectory, docID);
+      if (bytes >= 0) {
+        manifest_add(manifest, docID, bytes);
+      }
       docID++;
 
       //if depth < maxDepth, scans page for more links
@@ -150,9 +158,15 @@ static void crawl(char *seedURL, char *pageDirectory, const int maxDepth) {
     webpage_delete(currPage);
   }
 
+  //saves the manifest beside .crawler; the indexer can do without it
+  if (!manifest_save(manifest, pageDirectory)) {
+    fprintf(stderr, "Error: unable to save manifest in %s\n", pageDirectory);
+  }
+
   //frees all allocated structures
   bag_delete(pagesToCrawl, webpage_delete);
   hashtable_delete(pagesSeen, NULL);
+  manifest_delete(manifest);
 }
 
 /*
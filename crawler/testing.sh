@@ -8,6 +8,7 @@
 #   Tests for invalid maxDepth values
 #   Tests for small valid crawls at different depths
 #   Tests crawler under valgrind for memory leaks
+#   Tests corpusgen arguments, output, and repeatability
 
 #Invalid Argument Testing
 echo ""
@@ -71,4 +72,26 @@ echo "Valgrind test - small crawl"
 #runs valgrind on a small crawl
 valgrind --leak-check=full --show-leak-kinds=all ./crawler http://cs50tse.cs.dartmouth.edu/tse/letters/index.html ../data/letters 0
 
+#Synthetic Corpus Testing
+echo ""
+echo "Testing corpusgen"
+
+#bad arguments
+./corpusgen
+./corpusgen --zipf -1 ../data/synthetic 10
+./corpusgen ../data/synthetic 0
+
+#the same seed gives the same corpus
+rm -rf ../data/synthetic ../data/synthetic2
+./corpusgen --vocab 1000 --seed 7 ../data/synthetic 50
+./corpusgen --vocab 1000 --seed 7 ../data/synthetic2 50
+if [ -f ../data/synthetic/.crawler ] && [ -f ../data/synthetic/50 ] &&
+   [ -f ../data/synthetic/.manifest ] &&
+   [ ! -f ../data/synthetic/51 ] && diff -r ../data/synthetic ../data/synthetic2; then
+    echo "corpusgen repeatable with 50 pages"
+else
+    echo "corpusgen output differs"
+fi
+rm -rf ../data/synthetic2
+
 echo "All tests completed!"
@@ -4,30 +4,173 @@
  * This program reads files from a crawler-produced pageDirectory,
  * builds an inverted index mapping words to (docID, count) pairs,
  * and writes that index to a file.
+ *
+ * Usage: indexer [--text] [--mem-limit SIZE] [--update] [--shards N] 
+ *                [--read-ahead N [--read-threads]] pageDirectory indexFilename
+ *   --text       write the original text format instead of the compressed one
+ *   --mem-limit  keep the in-memory index below about SIZE bytes (K, M, or G
+ *                suffix allowed) by flushing sorted partial indexes ("runs")
+ *                to temporary files and merging them at the end
+ *   --update     update an existing (compressed) index file in place with 
+ *                pages added beyond its last docID, or changed or removed 
+ *                since it was built, instead of re-reading every page
+ *   --shards     split the index into N shard files by docID range 
+ *                (indexFilename.0 ... indexFilename.N-1), built in parallel;
+ *                the querier loads and searches the shards concurrently
+ *   --read-ahead keep N page reads in flight while indexing, with io_uring
+ *                where the kernel allows it and with N threads otherwise
+ *                (see pageloader.h), for page files not already in memory
+ *   --read-threads  read ahead with threads even where io_uring works
+ *
+ * Beside each index file it writes, the indexer saves a table of the 
+ * documents' URLs, depths, and lengths (indexFilename.docs; see 
+ * doctable.h), so that the querier can print results without reading 
+ * any page files.
+ *
+ * If the crawler left a manifest in pageDirectory (see manifest.h), the 
+ * indexer sizes its tables from it, gives each shard an equal share of 
+ * the corpus by bytes, and reads past docIDs with no page; otherwise it
+ * reads pages until one is missing.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
 #include "webpage.h"
 #include "pagedir.h"
+#include "manifest.h"
+#include "pageloader.h"
 #include "index.h"
+#include "doctable.h"
 #include "word.h"
 #include "file.h"
+#include "hash.h"
+
+//maximum number of shards
+#define MAX_SHARDS 64
+
+//maximum page reads in flight, per thread that indexes
+#define MAX_READ_AHEAD 256
+
+//bytes of pages per distinct word, for sizing an index from a manifest;
+//a little under what corpora of 300 to 5000 pages show, so the index's
+//table rarely has to grow
+#define BYTES_PER_WORD 128
+#define MIN_SLOTS 500
+#define MAX_SLOTS (1 << 22)
+
+//one shard to build, in its own thread
+typedef struct shard {
+  const char* pageDirectory;
+  const manifest_t* manifest;  //shared by all shards, or NULL
+  pageloader_method_t method;  //how to read its pages
+  int readAhead;
+  const char* filename;  //the shard's index file
+  bool textFormat;
+  int firstDoc;          //the docIDs it covers
+  int lastDoc;
+  bool ok;               //set by the thread
+} shard_t;
 
 //function prototypes
-static index_t* indexBuild(const char* pageDirectory);
-static void indexPage(webpage_t* page, const int docID, index_t* index);
+static index_t* indexBuild(const char* pageDirectory, const manifest_t* manifest,
+                           const int firstDoc, const int lastDoc, doctable_t* docs,
+                           const pageloader_method_t method, const int readAhead);
+static bool indexBuildShards(const char* pageDirectory, const char* indexFilename,
+                             const int numShards, const bool textFormat,
+                             const pageloader_method_t method, const int readAhead);
+static int shardStart(const manifest_t* manifest, const int numDocs,
+                      const int shard, const int numShards);
+static void* buildShard(void* arg);
+static bool indexBuildRuns(const char* pageDirectory, const char* indexFilename,
+                           const size_t memLimit, const pageloader_method_t method,
+                           const int readAhead);
+static bool flushRun(index_t* index, const char* indexFilename,
+                     char*** runs, int* numRuns);
+static bool indexUpdate(const char* pageDirectory, const char* indexFilename,
+                        const pageloader_method_t method, const int readAhead);
+static int indexSlots(const manifest_t* manifest, const int firstDoc,
+                      const int lastDoc);
+static int indexPage(webpage_t* page, const int docID, index_t* index);
+static void recordPage(webpage_t* page, const int docID, const int length,
+                       doctable_t* docs);
+static bool saveDocs(doctable_t* docs, const char* indexFilename);
+static void removeIndexFile(const char* filename);
+static size_t parseSize(const char* arg);
 
 int main(const int argc, char* argv[]) {
+  //reads options, which come before the positional arguments
+  bool textFormat = false;
+  bool update = false;
+  size_t memLimit = 0;
+  int numShards = 0;
+  int readAhead = 0;
+  bool readThreads = false;
+  int arg = 1;
+  while (arg < argc && strncmp(argv[arg], "--", 2) == 0) {
+    if (strcmp(argv[arg], "--text") == 0) {
+      textFormat = true;
+    } else if (strcmp(argv[arg], "--update") == 0) {
+      update = true;
+    } else if (strcmp(argv[arg], "--mem-limit") == 0 && arg + 1 < argc) {
+      memLimit = parseSize(argv[++arg]);
+      if (memLimit == 0) {
+        fprintf(stderr, "Invalid memory limit: %s\n", argv[arg]);
+        return 1;
+      }
+    } else if (strcmp(argv[arg], "--shards") == 0 && arg + 1 < argc) {
+      char excess;
+      if (sscanf(argv[++arg], "%d%c", &numShards, &excess) != 1 ||
+          numShards < 1 || numShards > MAX_SHARDS) {
+        fprintf(stderr, "Invalid number of shards: %s\n", argv[arg]);
+        return 1;
+      }
+    } else if (strcmp(argv[arg], "--read-ahead") == 0 && arg + 1 < argc) {
+      char excess;
+      if (sscanf(argv[++arg], "%d%c", &readAhead, &excess) != 1 ||
+          readAhead < 1 || readAhead > MAX_READ_AHEAD) {
+        fprintf(stderr, "Invalid read-ahead: %s\n", argv[arg]);
+        return 1;
+      }
+    } else if (strcmp(argv[arg], "--read-threads") == 0) {
+      readThreads = true;
+    } else {
+      fprintf(stderr, "Unknown option: %s\n", argv[arg]);
+      return 1;
+    }
+    arg++;
+  }
+
   //checks number of arguments
-  if (argc != 3) {
-    fprintf(stderr, "Usage: %s pageDirectory indexFilename\n", argv[0]);
+  if (argc - arg != 2) {
+    fprintf(stderr, "Usage: %s [--text] [--mem-limit SIZE] [--update] "
+            "[--shards N] [--read-ahead N [--read-threads]] "
+            "pageDirectory indexFilename\n", argv[0]);
+    return 1;
+  }
+  if (readThreads && readAhead == 0) {
+    fprintf(stderr, "--read-threads requires --read-ahead\n");
+    return 1;
+  }
+  if (numShards > 0 && (memLimit > 0 || update)) {
+    fprintf(stderr, "--shards cannot be combined with --mem-limit or --update\n");
+    return 1;
+  }
+  if (textFormat && (memLimit > 0 || update)) {
+    fprintf(stderr, "--text cannot be combined with --mem-limit or --update\n");
     return 1;
   }
 
-  const char* pageDirectory = argv[1];
-  const char* indexFilename = argv[2];
+  const char* pageDirectory = argv[arg];
+  const char* indexFilename = argv[arg + 1];
+
+  //reads pages as they are needed, unless asked to read ahead
+  pageloader_method_t method = (readAhead == 0) ? PAGELOADER_SYNC
+                               : readThreads ? PAGELOADER_THREADS : PAGELOADER_URING;
 
   //validates the pageDirectory
   if (!pagedir_validate(pageDirectory)) {
@@ -35,84 +178,626 @@ int main(const int argc, char* argv[]) {
     return 2;
   }
 
-  //checks indexFilename is writable
-  FILE* fp = fopen(indexFilename, "w");
+  //updates the existing index, which must not be truncated
+  if (update) {
+    if (!indexUpdate(pageDirectory, indexFilename, method, readAhead)) {
+      fprintf(stderr, "Failed to update index file: %s\n", indexFilename);
+      return 4;
+    }
+    return 0;
+  }
+
+  //builds the shards, each checked for writability as it is saved
+  if (numShards > 0) {
+    if (!indexBuildShards(pageDirectory, indexFilename, numShards, textFormat,
+                          method, readAhead)) {
+      fprintf(stderr, "Failed to build index shards: %s.*\n", indexFilename);
+      return 4;
+    }
+    return 0;
+  }
+
+  //checks indexFilename is writable, without truncating an existing index
+  FILE* fp = fopen(indexFilename, "a");
   if (fp == NULL) {
     fprintf(stderr, "Cannot write to file: %s\n", indexFilename);
     return 3;
   }
   fclose(fp);  //just testing access
 
-  //builds the index
-  index_t* index = indexBuild(pageDirectory);
+  //builds the index in bounded memory, if asked
+  if (memLimit > 0) {
+    if (!indexBuildRuns(pageDirectory, indexFilename, memLimit, method, readAhead)) {
+      fprintf(stderr, "Failed to build index in file: %s\n", indexFilename);
+      return 4;
+    }
+    return 0;
+  }
+
+  //builds the index, guided by the crawl's manifest if it has one
+  manifest_t* manifest = manifest_load(pageDirectory);
+  doctable_t* docs = doctable_new();
+  index_t* index = (docs != NULL) ? indexBuild(pageDirectory, manifest, 1, 0, docs,
+                                               method, readAhead)
+                                  : NULL;
+  manifest_delete(manifest);
   if (index == NULL) {
     fprintf(stderr, "Failed to build index\n");
+    doctable_delete(docs);
     return 4;
   }
 
-  //saves the index to the given file
-  if (!index_save(index, indexFilename)) {
+  //saves the index to the given file, and the document table beside it
+  bool saved = textFormat ? index_saveText(index, indexFilename)
+                          : index_save(index, indexFilename);
+  saved = saved && saveDocs(docs, indexFilename);
+  if (!saved) {
     fprintf(stderr, "Failed to save index to file: %s\n", indexFilename);
     index_delete(index);
+    doctable_delete(docs);
     return 5;
   }
 
   //clean up
   index_delete(index);
+  doctable_delete(docs);
   return 0;
 }
 
-/* Builds an index from all pages in the given pageDirectory
+/* Builds an index from the pages in the given pageDirectory
  *
  * Caller provides:
  *   pageDirectory - path to a valid crawler directory
+ *   manifest - the crawl's manifest, or NULL if it has none
+ *   firstDoc - first docID to read
+ *   lastDoc - last docID to read, or 0 for no limit
+ *   docs - table in which to record each page read
+ *   method, readAhead - how to read the pages (see pageloader.h)
  * Returns:
  *   pointer to a fully populated index, or NULL on error
  * Notes:
- *   Starts from document ID 1 and reads until a page cannot be loaded
+ *   Reads from firstDoc until there are no more pages (see pageloader.h)
+ *   or lastDoc is done
  */
-static index_t* indexBuild(const char* pageDirectory) {
-  index_t* index = index_new(500);  //reasonable starting size
-  if (index == NULL) {
+static index_t* indexBuild(const char* pageDirectory, const manifest_t* manifest,
+                           const int firstDoc, const int lastDoc, doctable_t* docs,
+                           const pageloader_method_t method, const int readAhead) {
+  pageloader_t* loader = pageloader_new(pageDirectory, manifest, firstDoc, lastDoc,
+                                        method, readAhead > 0 ? readAhead : 1);
+  index_t* index = index_new(indexSlots(manifest, firstDoc, lastDoc));
+  if (loader == NULL || index == NULL) {
+    pageloader_delete(loader);
+    index_delete(index);
     return NULL;
   }
+  index_setTime(index, time(NULL));
 
-  int docID = 1;
+  //makes room in the document table for the pages the manifest lists
+  if (manifest != NULL) {
+    int last = manifest_lastDoc(manifest);
+    doctable_reserve(docs, (lastDoc != 0 && lastDoc < last) ? lastDoc : last);
+  }
+
+  int docID = firstDoc;
   webpage_t* page;
 
-  //loops through pages until one fails to load
-  while ((page = pagedir_load(pageDirectory, docID)) != NULL) {
-    indexPage(page, docID, index);
+  //loops through pages, in docID order, until there are no more
+  while ((page = pageloader_next(loader, &docID)) != NULL) {
+    recordPage(page, docID, indexPage(page, docID, index), docs);
     webpage_delete(page);
     docID++;
   }
+  pageloader_delete(loader);
 
+  //records which pages the index covers
+  if (docID > firstDoc) {
+    index_cover(index, firstDoc, docID - 1);
+  }
   return index;
 }
 
 
+/* Builds the index as numShards shard files, indexFilename.0 through
+ * indexFilename.N-1, each covering a range of docIDs with an equal share
+ * of the pages: of their bytes if the crawl has a manifest, or else of
+ * their number. The shards are built and saved in parallel, one thread
+ * each.
+ *
+ * Caller provides:
+ *   pageDirectory - path to a valid crawler directory
+ *   indexFilename - base path of the shard files
+ *   numShards - number of shards, 1 to MAX_SHARDS
+ *   textFormat - true to save the shards in the text format
+ *   method, readAhead - how each shard's thread reads its pages
+ * Returns:
+ *   true if every shard was saved, false on error
+ * Notes:
+ *   The pages are counted first, from the manifest and then by checking
+ *   which page files exist past its end; a stale unsharded index at 
+ *   indexFilename and any stale shards beyond the last one are removed, 
+ *   since the querier would find them.
+ */
+static bool indexBuildShards(const char* pageDirectory, const char* indexFilename,
+                             const int numShards, const bool textFormat,
+                             const pageloader_method_t method, const int readAhead) {
+  //counts the pages: those listed, then any added since, until one is missing
+  manifest_t* manifest = manifest_load(pageDirectory);
+  int numDocs = manifest_lastDoc(manifest);
+  time_t modified;
+  while ((modified = pagedir_mtime(pageDirectory, numDocs + 1)) > 0) {
+    numDocs++;
+  }
+
+  shard_t shards[MAX_SHARDS];
+  pthread_t threads[MAX_SHARDS];
+  bool ok = (modified == 0);
+  int started = 0;
+
+  for (int i = 0; ok && i < numShards; i++) {
+    char* filename = malloc(strlen(indexFilename) + 12);
+    if (filename == NULL) {
+      ok = false;
+      break;
+    }
+    sprintf(filename, "%s.%d", indexFilename, i);
+
+    shards[i].pageDirectory = pageDirectory;
+    shards[i].manifest = manifest;
+    shards[i].method = method;
+    shards[i].readAhead = readAhead;
+    shards[i].filename = filename;
+    shards[i].textFormat = textFormat;
+    shards[i].firstDoc = shardStart(manifest, numDocs, i, numShards);
+    shards[i].lastDoc = shardStart(manifest, numDocs, i + 1, numShards) - 1;
+    shards[i].ok = false;
+
+    if (pthread_create(&threads[i], NULL, buildShard, &shards[i]) != 0) {
+      free(filename);
+      ok = false;
+      break;
+    }
+    started++;
+  }
+
+  //waits for every shard that was started
+  for (int i = 0; i < started; i++) {
+    pthread_join(threads[i], NULL);
+    ok = ok && shards[i].ok;
+    free((char*)shards[i].filename);
+  }
+  manifest_delete(manifest);
+
+  //removes stale index files that would shadow or extend this one
+  if (ok) {
+    removeIndexFile(indexFilename);
+    char* stale = malloc(strlen(indexFilename) + 12);
+    for (int i = numShards; stale != NULL; i++) {
+      sprintf(stale, "%s.%d", indexFilename, i);
+      if (access(stale, F_OK) != 0) {
+        break;
+      }
+      removeIndexFile(stale);
+    }
+    free(stale);
+  }
+  return ok;
+}
+
+
+/* Returns the first docID of a shard: docIDs 1 .. numDocs are split
+ * into numShards ranges at equal shares of the manifest's bytes, or at 
+ * equal numbers of docIDs if manifest is NULL. Shard numShards starts 
+ * just past the end, at numDocs + 1; pages past the manifest's end go
+ * to the last shard.
+ */
+static int shardStart(const manifest_t* manifest, const int numDocs,
+                      const int shard, const int numShards) {
+  if (shard == 0) {
+    return 1;
+  }
+  if (shard == numShards) {
+    return numDocs + 1;
+  }
+  if (manifest == NULL) {
+    return (int)((long)numDocs * shard / numShards) + 1;
+  }
+  return manifest_docAtOffset(manifest,
+                              manifest_totalBytes(manifest) * shard / numShards);
+}
+
+
+/* Builds and saves one shard; runs in its own thread.
+ *
+ * Caller provides:
+ *   arg - pointer to the shard_t describing the shard; its ok field is
+ *         set to whether the shard was saved
+ */
+static void* buildShard(void* arg) {
+  shard_t* shard = arg;
+
+  //an empty range (more shards than pages) still gets an empty shard
+  doctable_t* docs = doctable_new();
+  index_t* index = NULL;
+  if (docs != NULL) {
+    index = (shard->firstDoc <= shard->lastDoc)
+            ? indexBuild(shard->pageDirectory, shard->manifest, shard->firstDoc,
+                         shard->lastDoc, docs, shard->method, shard->readAhead)
+            : index_new(1);
+  }
+  if (index != NULL) {
+    shard->ok = shard->textFormat ? index_saveText(index, shard->filename)
+                                  : index_save(index, shard->filename);
+    shard->ok = shard->ok && saveDocs(docs, shard->filename);
+  }
+  index_delete(index);
+  doctable_delete(docs);
+  return NULL;
+}
+
+
+/* Builds an index from all pages in the given pageDirectory without ever
+ * holding more than about memLimit bytes of index in memory.
+ * Whenever the in-memory index reaches the limit, it is saved as a sorted
+ * run file next to indexFilename and started afresh; at the end, the runs 
+ * are streamed through a k-way merge into indexFilename and removed.
+ * The document table is streamed to disk the same way, through a 
+ * docwriter, so it does not grow in memory either.
+ *
+ * Caller provides:
+ *   pageDirectory - path to a valid crawler directory
+ *   indexFilename - path to the output index file
+ *   memLimit - memory budget for the in-memory index, in bytes
+ *   method, readAhead - how to read the pages (see pageloader.h)
+ * Returns:
+ *   true if the index was written, false on error
+ * Notes:
+ *   Runs cover increasing docID ranges, so the merge simply concatenates
+ *   each word's postings from successive runs.
+ */
+static bool indexBuildRuns(const char* pageDirectory, const char* indexFilename,
+                           const size_t memLimit, const pageloader_method_t method,
+                           const int readAhead) {
+  time_t start = time(NULL);
+  manifest_t* manifest = manifest_load(pageDirectory);
+  pageloader_t* loader = pageloader_new(pageDirectory, manifest, 1, 0, method,
+                                        readAhead > 0 ? readAhead : 1);
+  char* docsFile = malloc(strlen(indexFilename) + 6);
+  if (docsFile != NULL) {
+    sprintf(docsFile, "%s.docs", indexFilename);
+  }
+  docwriter_t* docs = (docsFile != NULL) ? docwriter_new(docsFile) : NULL;
+  free(docsFile);
+  index_t* index = index_new(500);
+  if (loader == NULL || docs == NULL || index == NULL) {
+    pageloader_delete(loader);
+    manifest_delete(manifest);
+    docwriter_delete(docs);
+    index_delete(index);
+    return false;
+  }
+  index_setTime(index, start);
+
+  char** runs = NULL;
+  int numRuns = 0;
+  int firstDoc = 1;  //first docID not yet in a run
+  bool ok = true;
+
+  int docID = 1;
+  webpage_t* page;
+
+  //loops through pages, in docID order, until there are no more
+  while (ok && (page = pageloader_next(loader, &docID)) != NULL) {
+    ok = docwriter_add(docs, docID, webpage_getURL(page), webpage_getDepth(page),
+                       indexPage(page, docID, index));
+    webpage_delete(page);
+    docID++;
+
+    if (ok && index_memory(index) >= memLimit) {
+      index_cover(index, firstDoc, docID - 1);
+      ok = flushRun(index, indexFilename, &runs, &numRuns);
+      index_delete(index);
+      index = ok ? index_new(500) : NULL;
+      ok = ok && (index != NULL);
+      index_setTime(index, start);
+      firstDoc = docID;
+    }
+  }
+
+  if (ok) {
+    if (docID > firstDoc) {
+      index_cover(index, firstDoc, docID - 1);
+    }
+    if (numRuns == 0) {
+      //everything fit in memory
+      ok = index_save(index, indexFilename);
+    } else {
+      if (docID > firstDoc) {
+        ok = flushRun(index, indexFilename, &runs, &numRuns);
+      }
+      ok = ok && index_merge(runs, numRuns, indexFilename);
+    }
+    ok = ok && docwriter_finish(docs);
+  }
+
+  //removes the run files
+  for (int i = 0; i < numRuns; i++) {
+    remove(runs[i]);
+    free(runs[i]);
+  }
+  free(runs);
+  index_delete(index);
+  docwriter_delete(docs);
+  pageloader_delete(loader);
+  manifest_delete(manifest);
+  return ok;
+}
+
+
+/* Saves the in-memory index as the next run, indexFilename.runN,
+ * and appends its path to the runs array.
+ *
+ * Caller provides:
+ *   index - partial index to save
+ *   indexFilename - path to the final index; the run is saved beside it
+ *   runs - pointer to the growable array of run paths
+ *   numRuns - pointer to the number of runs so far
+ * Returns:
+ *   true if the run was saved, false on error
+ */
+static bool flushRun(index_t* index, const char* indexFilename,
+                     char*** runs, int* numRuns) {
+  char** bigger = realloc(*runs, (*numRuns + 1) * sizeof(char*));
+  if (bigger == NULL) {
+    return false;
+  }
+  *runs = bigger;
+
+  char* runFile = malloc(strlen(indexFilename) + 20);
+  if (runFile == NULL) {
+    return false;
+  }
+  sprintf(runFile, "%s.run%d", indexFilename, *numRuns);
+
+  if (!index_save(index, runFile)) {
+    remove(runFile);
+    free(runFile);
+    return false;
+  }
+
+  (*runs)[(*numRuns)++] = runFile;
+  return true;
+}
+
+
+/* Updates an existing index file with pages that are new or have changed.
+ * The index's metadata gives its high-water mark (the last docID it 
+ * covers) and the time its pages were read. Pages up to the high-water 
+ * mark are re-read only if their file was modified since then, or 
+ * dropped if their file is gone; pages beyond it are read until there
+ * are no more (see pageloader.h). The resulting delta is merged into the index file, 
+ * which is replaced atomically, and the same pages are updated in the
+ * document table beside it (which is started afresh if missing).
+ *
+ * Caller provides:
+ *   pageDirectory - path to a valid crawler directory
+ *   indexFilename - path to an existing compressed index file
+ *   method, readAhead - how to read the new pages (see pageloader.h)
+ * Returns:
+ *   true if the index file was updated, false on error
+ * Notes:
+ *   Timestamps have one-second resolution, so a page modified in the 
+ *   same second the index was built is treated as changed.
+ */
+static bool indexUpdate(const char* pageDirectory, const char* indexFilename,
+                        const pageloader_method_t method, const int readAhead) {
+  int lastDoc;
+  time_t built;
+  if (!index_info(indexFilename, &lastDoc, &built)) {
+    fprintf(stderr, "Not a compressed index file: %s\n", indexFilename);
+    return false;
+  }
+
+  char* docsFile = malloc(strlen(indexFilename) + 6);
+  if (docsFile == NULL) {
+    return false;
+  }
+  sprintf(docsFile, "%s.docs", indexFilename);
+  doctable_t* docs = doctable_load(docsFile);
+  free(docsFile);
+  if (docs == NULL) {
+    docs = doctable_new();
+  }
+
+  index_t* delta = index_new(500);
+  if (docs == NULL || delta == NULL) {
+    doctable_delete(docs);
+    index_delete(delta);
+    return false;
+  }
+  index_setTime(delta, time(NULL));
+
+  int* replaced = NULL;
+  int numReplaced = 0;
+  bool ok = true;
+
+  //re-reads covered pages that changed since the build, drops missing ones
+  for (int docID = 1; ok && docID <= lastDoc; docID++) {
+    time_t modified = pagedir_mtime(pageDirectory, docID);
+    if (modified < 0) {
+      ok = false;  //not known to be gone, so not dropped
+      break;
+    }
+    if (modified != 0 && modified < built) {
+      continue;  //unchanged
+    }
+
+    int* bigger = realloc(replaced, (numReplaced + 1) * sizeof(int));
+    if (bigger == NULL) {
+      ok = false;
+      break;
+    }
+    replaced = bigger;
+    replaced[numReplaced++] = docID;
+
+    webpage_t* page = (modified != 0) ? pagedir_load(pageDirectory, docID) : NULL;
+    if (page != NULL) {
+      recordPage(page, docID, indexPage(page, docID, delta), docs);
+      webpage_delete(page);
+    } else {
+      ok = doctable_remove(docs, docID);
+    }
+  }
+  if (ok && lastDoc > 0) {
+    index_cover(delta, 1, lastDoc);
+  }
+
+  //reads new pages beyond the high-water mark
+  manifest_t* manifest = manifest_load(pageDirectory);
+  pageloader_t* loader = ok ? pageloader_new(pageDirectory, manifest, lastDoc + 1, 0,
+                                             method, readAhead > 0 ? readAhead : 1)
+                            : NULL;
+  ok = ok && (loader != NULL);
+  int docID = lastDoc + 1;
+  webpage_t* page;
+  while (ok && (page = pageloader_next(loader, &docID)) != NULL) {
+    recordPage(page, docID, indexPage(page, docID, delta), docs);
+    webpage_delete(page);
+    docID++;
+  }
+  if (ok && docID > lastDoc + 1) {
+    index_cover(delta, lastDoc + 1, docID - 1);
+  }
+
+  pageloader_delete(loader);
+  manifest_delete(manifest);
+
+  ok = ok && index_update(indexFilename, delta, replaced, numReplaced);
+  ok = ok && saveDocs(docs, indexFilename);
+
+  free(replaced);
+  index_delete(delta);
+  doctable_delete(docs);
+  return ok;
+}
+
+
+/* Returns the number of slots to give a new index of docIDs firstDoc
+ * through lastDoc (0 for no limit): enough for the words expected in 
+ * the bytes the manifest lists for them, or a small default without one.
+ */
+static int indexSlots(const manifest_t* manifest, const int firstDoc,
+                      const int lastDoc) {
+  long bytes = (lastDoc == 0) ? manifest_totalBytes(manifest)
+                              : manifest_offset(manifest, lastDoc + 1);
+  bytes -= manifest_offset(manifest, firstDoc);
+
+  long slots = bytes / BYTES_PER_WORD;
+  if (slots < MIN_SLOTS) {
+    return MIN_SLOTS;
+  }
+  return (slots > MAX_SLOTS) ? MAX_SLOTS : (int)slots;
+}
+
+
 /* Scans a webpage and adds its words to the index.
  *
  * Caller provides:
  *   page - pointer to webpage
  *   docID - integer ID for the page
  *   index - pointer to index being built
+ * Returns:
+ *   the number of words added, which is the page's length
  * Notes:
  *   Ignores words shorter than 3 characters, normalizes all words
  */
-static void indexPage(webpage_t* page, const int docID, index_t* index) {
+static int indexPage(webpage_t* page, const int docID, index_t* index) {
   int pos = 0;
+  int length = 0;
   char* word;
 
-  //extracts each word and add to index
+  //extracts each word and add to index, hashing it once for both the
+  //lookup and, if new, the insert
   while ((word = webpage_getNextWord(page, &pos)) != NULL) {
-    if (strlen(word) >= 3) {
-      char* norm = normalizeWord(word);
-      if (norm != NULL) {
-        index_insert(index, norm, docID);
-        free(norm);
-      }
+    int len = normalizeWordInPlace(word);
+    if (len >= 3) {
+      index_insertHashed(index, word, hash_bytes(word, len), docID);
+      length++;
     }
     free(word);
   }
+  return length;
+}
+
+
+/* Records a page's URL, depth, and length in the document table.
+ *
+ * Caller provides:
+ *   page - pointer to webpage
+ *   docID - integer ID for the page
+ *   length - number of words indexed from the page
+ *   docs - table to record it in
+ */
+static void recordPage(webpage_t* page, const int docID, const int length,
+                       doctable_t* docs) {
+  doctable_set(docs, docID, webpage_getURL(page), webpage_getDepth(page), length);
+}
+
+
+/* Saves the document table beside an index file, as indexFilename.docs.
+ *
+ * Returns:
+ *   true if saved, false on error
+ */
+static bool saveDocs(doctable_t* docs, const char* indexFilename) {
+  char* docsFile = malloc(strlen(indexFilename) + 6);
+  if (docsFile == NULL) {
+    return false;
+  }
+  sprintf(docsFile, "%s.docs", indexFilename);
+  bool ok = doctable_save(docs, docsFile);
+  free(docsFile);
+  return ok;
+}
+
+
+/* Removes an index file and the files kept beside it (its document 
+ * table and tombstones), ignoring any that do not exist.
+ */
+static void removeIndexFile(const char* filename) {
+  char* sidecar = malloc(strlen(filename) + 10);
+  if (sidecar != NULL) {
+    sprintf(sidecar, "%s.docs", filename);
+    remove(sidecar);
+    sprintf(sidecar, "%s.deleted", filename);
+    remove(sidecar);
+    free(sidecar);
+  }
+  remove(filename);
+}
+
+
+/* Parses a size such as 4096, 64K, 512M, or 2G into a number of bytes.
+ *
+ * Caller provides:
+ *   arg - the size string
+ * Returns:
+ *   the size in bytes, or 0 if arg is not a valid positive size
+ */
+static size_t parseSize(const char* arg) {
+  char* end;
+  unsigned long long size = strtoull(arg, &end, 10);
+  if (end == arg || arg[0] == '-') {
+    return 0;
+  }
+
+  switch (*end) {
+    case 'G': case 'g': size <<= 10; //falls through
+    case 'M': case 'm': size <<= 10; //falls through
+    case 'K': case 'k': size <<= 10; end++; break;
+    default: break;
+  }
+  if (*end != '\0') {
+    return 0;
+  }
+  return (size_t)size;
 }
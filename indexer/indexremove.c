@@ -0,0 +1,70 @@
+/*
+ * indexremove.c    Gretchen Kerfoot    Spring 2025
+ *
+ * This program removes documents from an index file. Removal only records
+ * tombstones beside the index (indexFilename.deleted), which the querier
+ * consults, so it is immediate however large the index is. Compaction
+ * later rewrites the index without the removed documents.
+ *
+ * Usage: indexremove indexFilename docID [docID]...
+ *        indexremove --compact indexFilename
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "index.h"
+
+
+int main(const int argc, char* argv[]) {
+  //compacts the index instead of removing documents
+  if (argc == 3 && strcmp(argv[1], "--compact") == 0) {
+    if (!index_compact(argv[2])) {
+      fprintf(stderr, "Failed to compact index file: %s\n", argv[2]);
+      return 3;
+    }
+    return 0;
+  }
+
+  //checks number of arguments
+  if (argc < 3) {
+    fprintf(stderr, "Usage: %s indexFilename docID [docID]...\n", argv[0]);
+    fprintf(stderr, "       %s --compact indexFilename\n", argv[0]);
+    return 1;
+  }
+
+  const char* indexFilename = argv[1];
+  int numDocs = argc - 2;
+  int* docIDs = malloc(numDocs * sizeof(int));
+  if (docIDs == NULL) {
+    fprintf(stderr, "Out of memory\n");
+    return 3;
+  }
+
+  //parses the docIDs
+  for (int i = 0; i < numDocs; i++) {
+    char excess;
+    if (sscanf(argv[i + 2], "%d%c", &docIDs[i], &excess) != 1 || docIDs[i] <= 0) {
+      fprintf(stderr, "Invalid docID: %s\n", argv[i + 2]);
+      free(docIDs);
+      return 1;
+    }
+  }
+
+  //checks that the index exists before recording tombstones for it
+  if (!index_info(indexFilename, NULL, NULL)) {
+    fprintf(stderr, "Not a compressed index file: %s\n", indexFilename);
+    free(docIDs);
+    return 2;
+  }
+
+  if (!index_remove(indexFilename, docIDs, numDocs)) {
+    fprintf(stderr, "Failed to remove documents from index file: %s\n", indexFilename);
+    free(docIDs);
+    return 3;
+  }
+
+  free(docIDs);
+  return 0;
+}
@@ -4,22 +4,33 @@
  * This program tests the index module by loading an index file,
  * then saving it to a new output file. It ensures that reading and writing
  * the index are consistent and memory-safe.
+ *
+ * Usage: indextest [--text] oldIndexFilename newIndexFilename
+ *   The old index may be in either format; the new index is written in
+ *   the compressed format, or in the text format (for indexcmp) if --text
+ *   is given.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
 #include "index.h"
 
 
 int main(const int argc, char* argv[]) {
+  //checks for the optional --text flag
+  bool textFormat = (argc > 1 && strcmp(argv[1], "--text") == 0);
+  int arg = textFormat ? 2 : 1;
+
   //checks number of arguments
-  if (argc != 3) {
-    fprintf(stderr, "Usage: %s oldIndexFilename newIndexFilename\n", argv[0]);
+  if (argc - arg != 2) {
+    fprintf(stderr, "Usage: %s [--text] oldIndexFilename newIndexFilename\n", argv[0]);
     return 1;
   }
 
-  const char* oldIndexFilename = argv[1];
-  const char* newIndexFilename = argv[2];
+  const char* oldIndexFilename = argv[arg];
+  const char* newIndexFilename = argv[arg + 1];
 
   //loads the old index from file
   index_t* index = index_load(oldIndexFilename);
@@ -29,7 +40,9 @@ int main(const int argc, char* argv[]) {
   }
 
   //saves the index to new file
-  if (!index_save(index, newIndexFilename)) {
+  bool saved = textFormat ? index_saveText(index, newIndexFilename)
+                          : index_save(index, newIndexFilename);
+  if (!saved) {
     fprintf(stderr, "Failed to save index to file: %s\n", newIndexFilename);
     index_delete(index);
     return 3;
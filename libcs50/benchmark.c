@@ -0,0 +1,541 @@
+/*
+ * benchmark.c - micro-benchmarks for the CS50 data-structure modules
+ *
+ * Times each operation of hashtable, set, counters, bag, and hash in
+ * isolation, at several sizes and with several key distributions, and
+ * reports for each:
+ *   ns/op     - mean wall-clock time per operation
+ *   allocs/op - calls to malloc, calloc, and realloc per operation
+ *   memory    - bytes held by the structure once built, in total and
+ *               per entry (as reported by malloc_usable_size, so
+ *               including allocator rounding)
+ * The program uses only the modules' headers, so the Makefile links it
+ * both with our modules and with libcs50-given.a to compare the two.
+ *
+ * Allocations are counted by defining malloc, calloc, realloc, and free
+ * here, over glibc's __libc_malloc and friends; this catches every
+ * allocation a module makes, whether through mem_malloc, malloc, or a
+ * library call like strdup. The counters are not atomic, so the
+ * benchmarks must stay single-threaded.
+ *
+ * Key distributions, for a structure of n entries:
+ *   seq     - each key once, in the order they were inserted
+ *   uniform - keys drawn uniformly at random (each once, for inserts)
+ *   zipf    - keys drawn with probability proportional to 1/rank
+ *   miss    - keys that are not in the structure
+ *
+ * usage: benchmark [name]
+ *   Runs only the benchmarks whose name contains 'name', if given.
+ *
+ * Each configuration is repeated until it has run for MIN_SECONDS.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <malloc.h>
+#include "hashtable.h"
+#include "set.h"
+#include "counters.h"
+#include "bag.h"
+#include "hash.h"
+
+/**************** file-local constants ****************/
+#define MIN_SECONDS 0.2         // minimum time spent on each configuration
+#define SLOTS 500               // hashtable size, as in index_new(500)
+#define KEYLEN 16               // room for any generated key
+
+/**************** local types ****************/
+typedef enum dist { SEQ, UNIFORM, ZIPF, MISS } dist_t;
+static const char* distNames[] = { "seq", "uniform", "zipf", "miss" };
+
+// one configuration of one benchmark, and what it measured
+typedef struct run {
+  int n;                        // entries in the structure
+  dist_t dist;                  // distribution of the operations' keys
+  char** keys;                  // 2n distinct keys; n..2n-1 are misses
+  int* stream;                  // n indexes into keys, drawn from dist
+  double start;                 // time the timed section started
+  long startAllocs;             // allocs when the timed section started
+  long base;                    // live bytes before the structure was built
+  double seconds;               // total time in timed sections
+  long allocs;                  // total allocations in timed sections
+  long ops;                     // total operations in timed sections
+  long bytes;                   // live bytes of the structure, at the end
+} run_t;
+
+typedef struct benchmark {
+  const char* name;
+  void (*func)(run_t* run);
+  int sizes[5];                 // terminated by 0
+  bool dists[4];                // which distributions apply
+} benchmark_t;
+
+/**************** allocation counts ****************/
+static long allocs = 0;         // calls to malloc, calloc, and realloc
+static long live = 0;           // bytes allocated and not yet freed
+
+/**************** glibc's allocator ****************/
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t nmemb, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void __libc_free(void* ptr);
+
+/**************** local functions ****************/
+static void bench_hash(run_t* run);
+static void bench_hashtable_insert(run_t* run);
+static void bench_hashtable_find(run_t* run);
+static void bench_set_insert(run_t* run);
+static void bench_set_find(run_t* run);
+static void bench_counters_add(run_t* run);
+static void bench_counters_get(run_t* run);
+static void bench_bag_insert(run_t* run);
+static void bench_bag_extract(run_t* run);
+static void run_start(run_t* run);
+static void run_stop(run_t* run, const long ops);
+static void run_measure(const benchmark_t* bench, run_t* run);
+static char** keys_new(const int n);
+static int* stream_new(const int n, const dist_t dist);
+static uint64_t rng_next(void);
+static double now(void);
+
+/**************** the benchmarks ****************/
+static const benchmark_t benchmarks[] = {
+  { "hash_jenkins",     bench_hash,             {1000, 100000, 1000000},
+    {true, true, true, false} },
+  { "hashtable_insert", bench_hashtable_insert, {1000, 10000, 100000},
+    {true, true, false, false} },
+  { "hashtable_find",   bench_hashtable_find,   {1000, 10000, 100000},
+    {false, true, true, true} },
+  { "set_insert",       bench_set_insert,       {100, 1000, 10000},
+    {true, true, false, false} },
+  { "set_find",         bench_set_find,         {100, 1000, 10000},
+    {false, true, true, true} },
+  { "counters_add",     bench_counters_add,     {100, 1000, 10000},
+    {true, true, true, false} },
+  { "counters_get",     bench_counters_get,     {100, 1000, 10000},
+    {false, true, true, true} },
+  { "bag_insert",       bench_bag_insert,       {1000, 100000, 1000000},
+    {true, false, false, false} },
+  { "bag_extract",      bench_bag_extract,      {1000, 100000, 1000000},
+    {true, false, false, false} },
+};
+
+// any non-NULL item will do
+static int present = 1;
+
+// results of operations whose value is otherwise unused
+static volatile unsigned long sink;
+
+int
+main(const int argc, char* argv[])
+{
+  if (argc > 2) {
+    fprintf(stderr, "usage: %s [name]\n", argv[0]);
+    return 1;
+  }
+  const char* filter = (argc == 2) ? argv[1] : "";
+
+  printf("%s\n", argv[0]);
+  printf("%-17s %8s %-8s %10s %10s %12s %10s\n",
+         "benchmark", "n", "keys", "ns/op", "allocs/op", "memory", "B/entry");
+
+  for (int b = 0; b < sizeof(benchmarks) / sizeof(benchmarks[0]); b++) {
+    const benchmark_t* bench = &benchmarks[b];
+    if (strstr(bench->name, filter) == NULL) {
+      continue;
+    }
+    for (int s = 0; bench->sizes[s] != 0; s++) {
+      const int n = bench->sizes[s];
+      char** keys = keys_new(n);
+      for (dist_t dist = SEQ; dist <= MISS; dist++) {
+        if (!bench->dists[dist]) {
+          continue;
+        }
+        run_t run = { .n = n, .dist = dist, .keys = keys };
+        run.stream = stream_new(n, dist);
+        run_measure(bench, &run);
+        free(run.stream);
+
+        printf("%-17s %8d %-8s %10.1f %10.2f %10.1f KB %10.1f\n",
+               bench->name, n, distNames[dist],
+               run.seconds * 1e9 / run.ops,
+               (double)run.allocs / run.ops,
+               run.bytes / 1024.0, (double)run.bytes / n);
+        fflush(stdout);
+      }
+      free(keys[0]);
+      free(keys);
+    }
+  }
+  return 0;
+}
+
+/**************** bench_hash() ****************/
+/* Hash each key of the stream.
+ */
+static void
+bench_hash(run_t* run)
+{
+  unsigned long sum = 0;
+  run_start(run);
+  for (int i = 0; i < run->n; i++) {
+    sum += hash_jenkins(run->keys[run->stream[i]], SLOTS);
+  }
+  run_stop(run, run->n);
+  sink = sum;
+}
+
+/**************** bench_hashtable_insert() ****************/
+/* Insert n distinct keys into a new table.
+ */
+static void
+bench_hashtable_insert(run_t* run)
+{
+  run_start(run);
+  hashtable_t* ht = hashtable_new(SLOTS);
+  for (int i = 0; i < run->n; i++) {
+    hashtable_insert(ht, run->keys[run->stream[i]], &present);
+  }
+  run_stop(run, run->n);
+  hashtable_delete(ht, NULL);
+}
+
+/**************** bench_hashtable_find() ****************/
+/* Find each key of the stream in a table of n keys.
+ */
+static void
+bench_hashtable_find(run_t* run)
+{
+  hashtable_t* ht = hashtable_new(SLOTS);
+  for (int i = 0; i < run->n; i++) {
+    hashtable_insert(ht, run->keys[i], &present);
+  }
+  unsigned long found = 0;
+  run_start(run);
+  for (int i = 0; i < run->n; i++) {
+    found += (hashtable_find(ht, run->keys[run->stream[i]]) != NULL);
+  }
+  run_stop(run, run->n);
+  sink = found;
+  hashtable_delete(ht, NULL);
+}
+
+/**************** bench_set_insert() ****************/
+/* Insert n distinct keys into a new set.
+ */
+static void
+bench_set_insert(run_t* run)
+{
+  run_start(run);
+  set_t* set = set_new();
+  for (int i = 0; i < run->n; i++) {
+    set_insert(set, run->keys[run->stream[i]], &present);
+  }
+  run_stop(run, run->n);
+  set_delete(set, NULL);
+}
+
+/**************** bench_set_find() ****************/
+/* Find each key of the stream in a set of n keys.
+ */
+static void
+bench_set_find(run_t* run)
+{
+  set_t* set = set_new();
+  for (int i = 0; i < run->n; i++) {
+    set_insert(set, run->keys[i], &present);
+  }
+  unsigned long found = 0;
+  run_start(run);
+  for (int i = 0; i < run->n; i++) {
+    found += (set_find(set, run->keys[run->stream[i]]) != NULL);
+  }
+  run_stop(run, run->n);
+  sink = found;
+  set_delete(set, NULL);
+}
+
+/**************** bench_counters_add() ****************/
+/* Add each key of the stream to new counters; keys that repeat in the
+ * stream are incremented.
+ */
+static void
+bench_counters_add(run_t* run)
+{
+  run_start(run);
+  counters_t* ctrs = counters_new();
+  for (int i = 0; i < run->n; i++) {
+    counters_add(ctrs, run->stream[i]);
+  }
+  run_stop(run, run->n);
+  counters_delete(ctrs);
+}
+
+/**************** bench_counters_get() ****************/
+/* Get each key of the stream from counters holding keys 0..n-1.
+ */
+static void
+bench_counters_get(run_t* run)
+{
+  counters_t* ctrs = counters_new();
+  for (int i = 0; i < run->n; i++) {
+    counters_add(ctrs, i);
+  }
+  unsigned long total = 0;
+  run_start(run);
+  for (int i = 0; i < run->n; i++) {
+    total += counters_get(ctrs, run->stream[i]);
+  }
+  run_stop(run, run->n);
+  sink = total;
+  counters_delete(ctrs);
+}
+
+/**************** bench_bag_insert() ****************/
+/* Insert n items into a new bag.
+ */
+static void
+bench_bag_insert(run_t* run)
+{
+  run_start(run);
+  bag_t* bag = bag_new();
+  for (int i = 0; i < run->n; i++) {
+    bag_insert(bag, run->keys[i]);
+  }
+  run_stop(run, run->n);
+  bag_delete(bag, NULL);
+}
+
+/**************** bench_bag_extract() ****************/
+/* Extract every item from a bag of n items.
+ */
+static void
+bench_bag_extract(run_t* run)
+{
+  bag_t* bag = bag_new();
+  for (int i = 0; i < run->n; i++) {
+    bag_insert(bag, run->keys[i]);
+  }
+  // the structure's size is taken before it is emptied
+  const long bytes = live - run->base;
+  unsigned long extracted = 0;
+  run_start(run);
+  for (int i = 0; i < run->n; i++) {
+    extracted += (bag_extract(bag) != NULL);
+  }
+  run_stop(run, run->n);
+  run->bytes = bytes;
+  sink = extracted;
+  bag_delete(bag, NULL);
+}
+
+/**************** run_start() ****************/
+/* Mark the start of a benchmark's timed section.
+ */
+static void
+run_start(run_t* run)
+{
+  run->startAllocs = allocs;
+  run->start = now();
+}
+
+/**************** run_stop() ****************/
+/* Mark the end of a benchmark's timed section, in which it did 'ops'
+ * operations, and take the size of the structure it has built.
+ */
+static void
+run_stop(run_t* run, const long ops)
+{
+  run->seconds += now() - run->start;
+  run->allocs += allocs - run->startAllocs;
+  run->ops += ops;
+  run->bytes = live - run->base;
+}
+
+/**************** run_measure() ****************/
+/* Run a benchmark until it has been timed for MIN_SECONDS.
+ */
+static void
+run_measure(const benchmark_t* bench, run_t* run)
+{
+  do {
+    run->base = live;
+    (*bench->func)(run);
+  } while (run->seconds < MIN_SECONDS);
+}
+
+/**************** keys_new() ****************/
+/* Make 2n distinct keys of 2 to 8 lowercase letters, in one block;
+ * the block is keys[0]. Exits if out of memory.
+ */
+static char**
+keys_new(const int n)
+{
+  char** keys = malloc(2 * n * sizeof(char*));
+  char* text = malloc(2 * (size_t)n * KEYLEN);
+  if (keys == NULL || text == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(3);
+  }
+  for (int i = 0; i < 2 * n; i++) {
+    // an odd multiplier permutes 32-bit values, so the keys are distinct
+    uint32_t value = (uint32_t)i * 2654435761u;
+    char* key = text + (size_t)i * KEYLEN;
+    int len = 0;
+    key[len++] = 'k';
+    do {
+      key[len++] = 'a' + value % 26;
+      value /= 26;
+    } while (value > 0);
+    key[len] = '\0';
+    keys[i] = key;
+  }
+  return keys;
+}
+
+/**************** stream_new() ****************/
+/* Make a stream of n indexes into the keys, drawn from dist.
+ * Exits if out of memory.
+ */
+static int*
+stream_new(const int n, const dist_t dist)
+{
+  int* stream = malloc(n * sizeof(int));
+  int* rank = malloc(n * sizeof(int));
+  double* cumulative = malloc(n * sizeof(double));
+  if (stream == NULL || rank == NULL || cumulative == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(3);
+  }
+
+  // a random order of the keys: the insert order for 'uniform', and
+  // which key has which rank for 'zipf'
+  for (int i = 0; i < n; i++) {
+    rank[i] = i;
+  }
+  for (int i = n - 1; i > 0; i--) {
+    int j = rng_next() % (i + 1);
+    int swap = rank[i];
+    rank[i] = rank[j];
+    rank[j] = swap;
+  }
+  double total = 0;
+  for (int r = 0; r < n; r++) {
+    total += 1.0 / (r + 1);
+    cumulative[r] = total;
+  }
+
+  for (int i = 0; i < n; i++) {
+    switch (dist) {
+    case SEQ:
+      stream[i] = i;
+      break;
+    case UNIFORM:
+      stream[i] = rank[i];
+      break;
+    case ZIPF: {
+      double u = (double)(rng_next() >> 11) / (double)(1ULL << 53) * total;
+      int lo = 0;
+      int hi = n - 1;
+      while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (cumulative[mid] < u) {
+          lo = mid + 1;
+        } else {
+          hi = mid;
+        }
+      }
+      stream[i] = rank[lo];
+      break;
+    }
+    case MISS:
+      stream[i] = n + rng_next() % n;
+      break;
+    }
+  }
+  free(cumulative);
+  free(rank);
+  return stream;
+}
+
+/**************** rng_next() ****************/
+/* Return the next value of a fixed-seed splitmix64 sequence.
+ */
+static uint64_t
+rng_next(void)
+{
+  static uint64_t state = 42;
+  uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/**************** now() ****************/
+/* Return a monotonic time in seconds.
+ */
+static double
+now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**************** malloc() ****************/
+/* The allocator functions below count every allocation made by the
+ * program, then pass it on to glibc.
+ */
+void*
+malloc(size_t size)
+{
+  void* ptr = __libc_malloc(size);
+  if (ptr != NULL) {
+    allocs++;
+    live += malloc_usable_size(ptr);
+  }
+  return ptr;
+}
+
+/**************** calloc() ****************/
+void*
+calloc(size_t nmemb, size_t size)
+{
+  void* ptr = __libc_calloc(nmemb, size);
+  if (ptr != NULL) {
+    allocs++;
+    live += malloc_usable_size(ptr);
+  }
+  return ptr;
+}
+
+/**************** realloc() ****************/
+void*
+realloc(void* ptr, size_t size)
+{
+  const size_t old = (ptr != NULL) ? malloc_usable_size(ptr) : 0;
+  void* newPtr = __libc_realloc(ptr, size);
+  if (newPtr != NULL) {
+    allocs++;
+    live += malloc_usable_size(newPtr) - old;
+  } else if (size == 0) {
+    live -= old;
+  }
+  return newPtr;
+}
+
+/**************** free() ****************/
+void
+free(void* ptr)
+{
+  if (ptr != NULL) {
+    live -= malloc_usable_size(ptr);
+    __libc_free(ptr);
+  }
+}
@@ -0,0 +1,939 @@
+/*
+ * bitmap.c - CS50 'bitmap' module
+ *
+ * see bitmap.h for more information.
+ *
+ * A bitmap is an array of containers sorted by key (docID >> 16).  A
+ * container in array form keeps its members' low bits in a sorted array;
+ * in bitmap form it keeps one bit per docID in 64-bit words, running
+ * only as far as its last member, and ranks[w] is the number of members
+ * in the words before w, so a member's position (and count) is found
+ * with one popcount.  A container is in bitmap form exactly when it has
+ * at least MEMBERS_PER_WORD members per word it would need.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "bitmap.h"
+#include "mem.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**************** file-local constants ****************/
+#define CHUNK_BITS 16           // a container holds 1 << CHUNK_BITS docIDs
+#define LOW_MASK 0xFFFF         // a docID's bits within its container
+
+// A word and its rank take 10 bytes and an array member's low bits take
+// 2, so a container at least this dense is smaller as bits.
+#define MEMBERS_PER_WORD 5
+
+/**************** file-local types ****************/
+typedef struct container {
+  int key;                    // docID >> CHUNK_BITS, for every member
+  int size;                   // number of members
+  int capacity;               // members that counts (and values) can hold
+  int* counts;                // the members' counts, in docID order
+  uint16_t* values;           // array form: members' low bits; else NULL
+  uint64_t* words;            // bitmap form: one bit per docID; else NULL
+  uint16_t* ranks;            // bitmap form: members before each word
+  int numWords;               // bitmap form: words in use
+  int wordCap;                // bitmap form: words allocated
+} container_t;
+
+typedef struct print_args {
+  FILE* fp;
+  bool first;                 // no docID printed yet
+} print_args_t;
+
+/**************** global types ****************/
+typedef struct bitmap {
+  container_t* containers;    // sorted by key, none empty
+  int numContainers;
+  int capacity;               // containers allocated
+  int size;                   // number of docIDs
+} bitmap_t;
+
+/**************** local functions ****************/
+/* not visible outside this file */
+static container_t* bitmap_push(bitmap_t* bitmap, const int key);
+static void bitmap_pop(bitmap_t* bitmap);
+static void bitmap_print_helper(void* arg, const int docID, const int count);
+static void container_init(container_t* c, const int key);
+static void container_free(container_t* c);
+static bool container_reserve(container_t* c, const int n);
+static bool container_growWords(container_t* c, const int numWords);
+static int container_last(const container_t* c);
+static int container_find(const container_t* c, const int low);
+static int container_take(const container_t* c, int* pos, const int low);
+static bool container_append(container_t* c, const int low, const int count);
+static bool container_toBitmap(container_t* c);
+static bool container_toArray(container_t* c);
+static void container_rank(container_t* c);
+static void container_settle(container_t* c);
+static void container_setBits(container_t* out, const container_t* c);
+static bool container_copy(const container_t* src, container_t* out);
+static bool container_and(const container_t* a, const container_t* b,
+                          container_t* out);
+static bool container_or(const container_t* a, const container_t* b,
+                         container_t* out);
+static void words_and(uint64_t* out, const uint64_t* a, const uint64_t* b,
+                      const int n);
+static void words_or(uint64_t* out, const uint64_t* a, const uint64_t* b,
+                     const int n);
+
+/**************** bitmap_new() ****************/
+/* see bitmap.h for description */
+bitmap_t*
+bitmap_new(void)
+{
+  bitmap_t* bitmap = mem_malloc(sizeof(bitmap_t));
+  if (bitmap == NULL) {
+    return NULL;              // error allocating bitmap
+  }
+  bitmap->containers = NULL;
+  bitmap->numContainers = 0;
+  bitmap->capacity = 0;
+  bitmap->size = 0;
+  return bitmap;
+}
+
+/**************** bitmap_add() ****************/
+/* see bitmap.h for description */
+bool
+bitmap_add(bitmap_t* bitmap, const int docID, const int count)
+{
+  if (bitmap == NULL || docID < 0 || count <= 0) {
+    return false;
+  }
+
+  int key = docID >> CHUNK_BITS;
+  int low = docID & LOW_MASK;
+  container_t* c = NULL;
+  if (bitmap->numContainers > 0) {
+    c = &bitmap->containers[bitmap->numContainers - 1];
+  }
+  if (c != NULL && c->key > key) {
+    return false;             // out of order
+  }
+
+  if (c == NULL || c->key < key) {
+    if ((c = bitmap_push(bitmap, key)) == NULL) {
+      return false;
+    }
+  } else {
+    int last = container_last(c);
+    if (low < last) {
+      return false;           // out of order
+    }
+    if (low == last) {
+      c->counts[c->size - 1] += count;        // same document again
+      return true;
+    }
+  }
+
+  if (!container_append(c, low, count)) {
+    if (c->size == 0) {
+      bitmap_pop(bitmap);
+    }
+    return false;
+  }
+  bitmap->size++;
+  return true;
+}
+
+/**************** bitmap_size() ****************/
+/* see bitmap.h for description */
+int
+bitmap_size(const bitmap_t* bitmap)
+{
+  return (bitmap == NULL) ? 0 : bitmap->size;
+}
+
+/**************** bitmap_get() ****************/
+/* see bitmap.h for description */
+int
+bitmap_get(const bitmap_t* bitmap, const int docID)
+{
+  if (bitmap == NULL || docID < 0) {
+    return 0;
+  }
+
+  int key = docID >> CHUNK_BITS;
+  int lo = 0;
+  int hi = bitmap->numContainers;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (bitmap->containers[mid].key < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo == bitmap->numContainers || bitmap->containers[lo].key != key) {
+    return 0;
+  }
+
+  const container_t* c = &bitmap->containers[lo];
+  int k = container_find(c, docID & LOW_MASK);
+  return (k < 0) ? 0 : c->counts[k];
+}
+
+/**************** bitmap_and() ****************/
+/* see bitmap.h for description */
+bitmap_t*
+bitmap_and(const bitmap_t* a, const bitmap_t* b)
+{
+  if (a == NULL || b == NULL) {
+    return NULL;
+  }
+  bitmap_t* result = bitmap_new();
+  if (result == NULL) {
+    return NULL;
+  }
+
+  int i = 0;
+  int j = 0;
+  while (i < a->numContainers && j < b->numContainers) {
+    const container_t* ca = &a->containers[i];
+    const container_t* cb = &b->containers[j];
+    if (ca->key < cb->key) {
+      i++;
+    } else if (cb->key < ca->key) {
+      j++;
+    } else {
+      container_t* out = bitmap_push(result, ca->key);
+      if (out == NULL || !container_and(ca, cb, out)) {
+        bitmap_delete(result);
+        return NULL;
+      }
+      if (out->size == 0) {
+        bitmap_pop(result);
+      } else {
+        result->size += out->size;
+      }
+      i++;
+      j++;
+    }
+  }
+  return result;
+}
+
+/**************** bitmap_or() ****************/
+/* see bitmap.h for description */
+bitmap_t*
+bitmap_or(const bitmap_t* a, const bitmap_t* b)
+{
+  if (a == NULL || b == NULL) {
+    return NULL;
+  }
+  bitmap_t* result = bitmap_new();
+  if (result == NULL) {
+    return NULL;
+  }
+
+  int i = 0;
+  int j = 0;
+  while (i < a->numContainers || j < b->numContainers) {
+    const container_t* ca = (i < a->numContainers) ? &a->containers[i] : NULL;
+    const container_t* cb = (j < b->numContainers) ? &b->containers[j] : NULL;
+    container_t* out;
+    bool ok;
+    if (cb == NULL || (ca != NULL && ca->key < cb->key)) {
+      ok = (out = bitmap_push(result, ca->key)) != NULL
+           && container_copy(ca, out);
+      i++;
+    } else if (ca == NULL || cb->key < ca->key) {
+      ok = (out = bitmap_push(result, cb->key)) != NULL
+           && container_copy(cb, out);
+      j++;
+    } else {
+      ok = (out = bitmap_push(result, ca->key)) != NULL
+           && container_or(ca, cb, out);
+      i++;
+      j++;
+    }
+    if (!ok) {
+      bitmap_delete(result);
+      return NULL;
+    }
+    result->size += out->size;
+  }
+  return result;
+}
+
+/**************** bitmap_andPostings() ****************/
+/* see bitmap.h for description */
+postings_t*
+bitmap_andPostings(const bitmap_t* bitmap, const postings_t* postings)
+{
+  if (bitmap == NULL || postings == NULL) {
+    return NULL;
+  }
+  postings_t* result = postings_new();
+  if (result == NULL) {
+    return NULL;
+  }
+  int size = postings_size(postings);
+  postings_reserve(result, (size < bitmap->size) ? size : bitmap->size);
+
+  // the list's docIDs increase, so the containers are visited in order
+  postings_iter_t iter;
+  postings_iter_init(&iter, postings);
+  int docID, count;
+  int i = 0;
+  while (postings_iter_next(&iter, &docID, &count)) {
+    int key = docID >> CHUNK_BITS;
+    while (i < bitmap->numContainers && bitmap->containers[i].key < key) {
+      i++;
+    }
+    if (i == bitmap->numContainers) {
+      break;
+    }
+
+    const container_t* c = &bitmap->containers[i];
+    int k = (c->key == key) ? container_find(c, docID & LOW_MASK) : -1;
+    if (k >= 0) {
+      int other = c->counts[k];
+      if (!postings_add(result, docID, (count < other) ? count : other)) {
+        postings_delete(result);
+        return NULL;
+      }
+    }
+  }
+  return result;
+}
+
+/**************** bitmap_orPostings() ****************/
+/* see bitmap.h for description */
+bitmap_t*
+bitmap_orPostings(const bitmap_t* bitmap, const postings_t* postings)
+{
+  if (bitmap == NULL || postings == NULL) {
+    return NULL;
+  }
+  bitmap_t* other = bitmap_new();
+  if (other == NULL) {
+    return NULL;
+  }
+
+  postings_iter_t iter;
+  postings_iter_init(&iter, postings);
+  int docID, count;
+  while (postings_iter_next(&iter, &docID, &count)) {
+    if (!bitmap_add(other, docID, count)) {
+      bitmap_delete(other);
+      return NULL;
+    }
+  }
+
+  bitmap_t* result = bitmap_or(bitmap, other);
+  bitmap_delete(other);
+  return result;
+}
+
+/**************** bitmap_iterate() ****************/
+/* see bitmap.h for description */
+void
+bitmap_iterate(const bitmap_t* bitmap, void* arg,
+               void (*itemfunc)(void* arg, const int docID, const int count))
+{
+  if (bitmap == NULL || itemfunc == NULL) {
+    return;
+  }
+  for (int i = 0; i < bitmap->numContainers; i++) {
+    const container_t* c = &bitmap->containers[i];
+    int base = c->key << CHUNK_BITS;
+    if (c->words == NULL) {
+      for (int k = 0; k < c->size; k++) {
+        (*itemfunc)(arg, base + c->values[k], c->counts[k]);
+      }
+      continue;
+    }
+    int k = 0;
+    for (int w = 0; w < c->numWords; w++) {
+      for (uint64_t bits = c->words[w]; bits != 0; bits &= bits - 1) {
+        (*itemfunc)(arg, base + w * 64 + __builtin_ctzll(bits), c->counts[k++]);
+      }
+    }
+  }
+}
+
+/**************** bitmap_print() ****************/
+/* see bitmap.h for description */
+void
+bitmap_print(const bitmap_t* bitmap, FILE* fp)
+{
+  if (fp == NULL) {
+    return;
+  }
+  if (bitmap == NULL) {
+    fputs("(null)", fp);
+    return;
+  }
+
+  fputc('{', fp);
+  print_args_t args = { fp, true };
+  bitmap_iterate(bitmap, &args, bitmap_print_helper);
+  fputc('}', fp);
+}
+
+/**************** bitmap_delete() ****************/
+/* see bitmap.h for description */
+void
+bitmap_delete(bitmap_t* bitmap)
+{
+  if (bitmap == NULL) {
+    return;
+  }
+  for (int i = 0; i < bitmap->numContainers; i++) {
+    container_free(&bitmap->containers[i]);
+  }
+  if (bitmap->containers != NULL) {
+    mem_free(bitmap->containers);
+  }
+  mem_free(bitmap);
+}
+
+/**************** bitmap_push() ****************/
+/* Append a new, empty container with the given key, which must be
+ * larger than any key in the bitmap.  Returns NULL if out of memory.
+ * The pointer is good until the next push.
+ */
+static container_t*
+bitmap_push(bitmap_t* bitmap, const int key)
+{
+  if (bitmap->numContainers == bitmap->capacity) {
+    int capacity = (bitmap->capacity == 0) ? 1 : 2 * bitmap->capacity;
+    container_t* containers = mem_malloc(capacity * sizeof(container_t));
+    if (containers == NULL) {
+      return NULL;
+    }
+    if (bitmap->containers != NULL) {
+      memcpy(containers, bitmap->containers,
+             bitmap->numContainers * sizeof(container_t));
+      mem_free(bitmap->containers);
+    }
+    bitmap->containers = containers;
+    bitmap->capacity = capacity;
+  }
+
+  container_t* c = &bitmap->containers[bitmap->numContainers++];
+  container_init(c, key);
+  return c;
+}
+
+/**************** bitmap_pop() ****************/
+/* Free and remove the bitmap's last container.
+ */
+static void
+bitmap_pop(bitmap_t* bitmap)
+{
+  container_free(&bitmap->containers[--bitmap->numContainers]);
+}
+
+/**************** bitmap_print_helper() ****************/
+/* Print one docID=count for bitmap_print, after a comma unless first.
+ */
+static void
+bitmap_print_helper(void* arg, const int docID, const int count)
+{
+  print_args_t* args = arg;
+  if (!args->first) {
+    fputc(',', args->fp);
+  }
+  fprintf(args->fp, "%d=%d", docID, count);
+  args->first = false;
+}
+
+/**************** container_init() ****************/
+/* Make c an empty container, in array form, with the given key.
+ */
+static void
+container_init(container_t* c, const int key)
+{
+  memset(c, 0, sizeof(container_t));
+  c->key = key;
+}
+
+/**************** container_free() ****************/
+/* Free the arrays of c (but not c itself).
+ */
+static void
+container_free(container_t* c)
+{
+  if (c->counts != NULL) {
+    mem_free(c->counts);
+  }
+  if (c->values != NULL) {
+    mem_free(c->values);
+  }
+  if (c->words != NULL) {
+    mem_free(c->words);
+    mem_free(c->ranks);
+  }
+}
+
+/**************** container_reserve() ****************/
+/* Make room for at least n members: counts, and values if c is in array
+ * form.  Returns false if out of memory, leaving c unchanged.
+ */
+static bool
+container_reserve(container_t* c, const int n)
+{
+  if (n <= c->capacity) {
+    return true;
+  }
+  int capacity = (c->capacity == 0) ? 4 : c->capacity;
+  while (capacity < n) {
+    capacity *= 2;
+  }
+
+  int* counts = mem_malloc(capacity * sizeof(int));
+  if (counts == NULL) {
+    return false;
+  }
+  if (c->words == NULL) {
+    uint16_t* values = mem_malloc(capacity * sizeof(uint16_t));
+    if (values == NULL) {
+      mem_free(counts);
+      return false;
+    }
+    if (c->values != NULL) {
+      memcpy(values, c->values, c->size * sizeof(uint16_t));
+      mem_free(c->values);
+    }
+    c->values = values;
+  }
+  if (c->counts != NULL) {
+    memcpy(counts, c->counts, c->size * sizeof(int));
+    mem_free(c->counts);
+  }
+  c->counts = counts;
+  c->capacity = capacity;
+  return true;
+}
+
+/**************** container_growWords() ****************/
+/* Extend c's words to numWords (no fewer than it has), with the new
+ * words empty; this puts c in bitmap form.  Returns false if out of
+ * memory, leaving c unchanged.
+ */
+static bool
+container_growWords(container_t* c, const int numWords)
+{
+  if (numWords > c->wordCap) {
+    int wordCap = (c->wordCap == 0) ? 1 : c->wordCap;
+    while (wordCap < numWords) {
+      wordCap *= 2;
+    }
+    uint64_t* words = mem_malloc(wordCap * sizeof(uint64_t));
+    uint16_t* ranks = mem_malloc(wordCap * sizeof(uint16_t));
+    if (words == NULL || ranks == NULL) {
+      if (words != NULL) {
+        mem_free(words);
+      }
+      if (ranks != NULL) {
+        mem_free(ranks);
+      }
+      return false;
+    }
+    if (c->words != NULL) {
+      memcpy(words, c->words, c->numWords * sizeof(uint64_t));
+      memcpy(ranks, c->ranks, c->numWords * sizeof(uint16_t));
+      mem_free(c->words);
+      mem_free(c->ranks);
+    }
+    c->words = words;
+    c->ranks = ranks;
+    c->wordCap = wordCap;
+  }
+
+  for (int w = c->numWords; w < numWords; w++) {
+    c->words[w] = 0;
+    c->ranks[w] = c->size;    // every member comes before w
+  }
+  c->numWords = numWords;
+  return true;
+}
+
+/**************** container_last() ****************/
+/* Return the low bits of c's last member; c must not be empty.
+ */
+static int
+container_last(const container_t* c)
+{
+  if (c->words == NULL) {
+    return c->values[c->size - 1];
+  }
+  int w = c->numWords - 1;
+  return w * 64 + 63 - __builtin_clzll(c->words[w]);
+}
+
+/**************** container_find() ****************/
+/* Return the position of the member with the given low bits among c's
+ * members, or -1 if there is none.
+ */
+static int
+container_find(const container_t* c, const int low)
+{
+  if (c->words != NULL) {
+    int w = low >> 6;
+    uint64_t bit = (uint64_t)1 << (low & 63);
+    if (w >= c->numWords || (c->words[w] & bit) == 0) {
+      return -1;
+    }
+    return c->ranks[w] + __builtin_popcountll(c->words[w] & (bit - 1));
+  }
+
+  int lo = 0;
+  int hi = c->size;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (c->values[mid] < low) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return (lo < c->size && c->values[lo] == low) ? lo : -1;
+}
+
+/**************** container_take() ****************/
+/* For walking c's members in order alongside another container: if low
+ * is c's member at position *pos, advance *pos and return its count;
+ * otherwise return 0.
+ */
+static int
+container_take(const container_t* c, int* pos, const int low)
+{
+  bool member;
+  if (c->words != NULL) {
+    int w = low >> 6;
+    member = w < c->numWords && ((c->words[w] >> (low & 63)) & 1);
+  } else {
+    member = *pos < c->size && c->values[*pos] == low;
+  }
+  return member ? c->counts[(*pos)++] : 0;
+}
+
+/**************** container_append() ****************/
+/* Add a member larger than all of c's members.  Switches c to bitmap
+ * form once it is dense enough.  Returns false if out of memory.
+ */
+static bool
+container_append(container_t* c, const int low, const int count)
+{
+  if (!container_reserve(c, c->size + 1)) {
+    return false;
+  }
+
+  if (c->words != NULL) {
+    int w = low >> 6;
+    if (w >= c->numWords && !container_growWords(c, w + 1)) {
+      return false;
+    }
+    c->words[w] |= (uint64_t)1 << (low & 63);
+    c->counts[c->size++] = count;
+    return true;
+  }
+
+  c->values[c->size] = low;
+  c->counts[c->size++] = count;
+  if (c->size >= MEMBERS_PER_WORD * (low / 64 + 1)) {
+    container_toBitmap(c);    // if out of memory, it stays an array
+  }
+  return true;
+}
+
+/**************** container_toBitmap() ****************/
+/* Convert a nonempty container from array form to bitmap form.
+ * Returns false if out of memory, leaving c unchanged.
+ */
+static bool
+container_toBitmap(container_t* c)
+{
+  if (!container_growWords(c, container_last(c) / 64 + 1)) {
+    return false;
+  }
+  for (int k = 0; k < c->size; k++) {
+    c->words[c->values[k] >> 6] |= (uint64_t)1 << (c->values[k] & 63);
+  }
+  container_rank(c);
+  mem_free(c->values);
+  c->values = NULL;
+  return true;
+}
+
+/**************** container_toArray() ****************/
+/* Convert a container from bitmap form to array form.
+ * Returns false if out of memory, leaving c unchanged.
+ */
+static bool
+container_toArray(container_t* c)
+{
+  uint16_t* values = mem_malloc((c->capacity > 0 ? c->capacity : 1)
+                                * sizeof(uint16_t));
+  if (values == NULL) {
+    return false;
+  }
+  int k = 0;
+  for (int w = 0; w < c->numWords; w++) {
+    for (uint64_t bits = c->words[w]; bits != 0; bits &= bits - 1) {
+      values[k++] = w * 64 + __builtin_ctzll(bits);
+    }
+  }
+  mem_free(c->words);
+  mem_free(c->ranks);
+  c->words = NULL;
+  c->ranks = NULL;
+  c->numWords = 0;
+  c->wordCap = 0;
+  c->values = values;
+  return true;
+}
+
+/**************** container_rank() ****************/
+/* Recompute the ranks of a container in bitmap form from its words.
+ */
+static void
+container_rank(container_t* c)
+{
+  int rank = 0;
+  for (int w = 0; w < c->numWords; w++) {
+    c->ranks[w] = rank;
+    rank += __builtin_popcountll(c->words[w]);
+  }
+}
+
+/**************** container_settle() ****************/
+/* Put a newly computed container into the form its density calls for,
+ * dropping empty words from the end of a bitmap.  If out of memory, c
+ * keeps its form, which is still correct.
+ */
+static void
+container_settle(container_t* c)
+{
+  if (c->words == NULL) {
+    if (c->size > 0
+        && c->size >= MEMBERS_PER_WORD * (container_last(c) / 64 + 1)) {
+      container_toBitmap(c);
+    }
+    return;
+  }
+  while (c->numWords > 0 && c->words[c->numWords - 1] == 0) {
+    c->numWords--;
+  }
+  if (c->size < MEMBERS_PER_WORD * c->numWords) {
+    container_toArray(c);
+  }
+}
+
+/**************** container_setBits() ****************/
+/* Set the bits of c's members in out, which is in bitmap form and has
+ * words enough for them.
+ */
+static void
+container_setBits(container_t* out, const container_t* c)
+{
+  if (c->words != NULL) {
+    words_or(out->words, out->words, c->words, c->numWords);
+    return;
+  }
+  for (int k = 0; k < c->size; k++) {
+    out->words[c->values[k] >> 6] |= (uint64_t)1 << (c->values[k] & 63);
+  }
+}
+
+/**************** container_copy() ****************/
+/* Copy src into out, an empty container with the same key.
+ * Returns false if out of memory.
+ */
+static bool
+container_copy(const container_t* src, container_t* out)
+{
+  if (src->words != NULL) {
+    if (!container_growWords(out, src->numWords)) {
+      return false;
+    }
+    memcpy(out->words, src->words, src->numWords * sizeof(uint64_t));
+    memcpy(out->ranks, src->ranks, src->numWords * sizeof(uint16_t));
+  }
+  if (!container_reserve(out, src->size)) {
+    return false;
+  }
+  if (src->words == NULL) {
+    memcpy(out->values, src->values, src->size * sizeof(uint16_t));
+  }
+  memcpy(out->counts, src->counts, src->size * sizeof(int));
+  out->size = src->size;
+  return true;
+}
+
+/**************** container_and() ****************/
+/* Compute the members of both a and b into out, an empty container with
+ * their key, each with the smaller count.  Returns false if out of memory.
+ */
+static bool
+container_and(const container_t* a, const container_t* b, container_t* out)
+{
+  int smaller = (a->size < b->size) ? a->size : b->size;
+
+  if (a->words == NULL && b->words == NULL) {
+    // two arrays: merge them
+    if (!container_reserve(out, smaller)) {
+      return false;
+    }
+    int i = 0;
+    int j = 0;
+    while (i < a->size && j < b->size) {
+      if (a->values[i] < b->values[j]) {
+        i++;
+      } else if (b->values[j] < a->values[i]) {
+        j++;
+      } else {
+        out->values[out->size] = a->values[i];
+        out->counts[out->size++] = (a->counts[i] < b->counts[j])
+                                   ? a->counts[i] : b->counts[j];
+        i++;
+        j++;
+      }
+    }
+
+  } else if (a->words == NULL || b->words == NULL) {
+    // an array and a bitmap: look each array member up in the bitmap
+    const container_t* array = (a->words == NULL) ? a : b;
+    const container_t* bits = (a->words == NULL) ? b : a;
+    if (!container_reserve(out, array->size)) {
+      return false;
+    }
+    for (int i = 0; i < array->size; i++) {
+      int k = container_find(bits, array->values[i]);
+      if (k >= 0) {
+        out->values[out->size] = array->values[i];
+        out->counts[out->size++] = (array->counts[i] < bits->counts[k])
+                                   ? array->counts[i] : bits->counts[k];
+      }
+    }
+
+  } else {
+    // two bitmaps: AND the words, then look up the counts of the result
+    int numWords = (a->numWords < b->numWords) ? a->numWords : b->numWords;
+    if (!container_growWords(out, numWords)
+        || !container_reserve(out, smaller)) {
+      return false;
+    }
+    words_and(out->words, a->words, b->words, numWords);
+    for (int w = 0; w < numWords; w++) {
+      out->ranks[w] = out->size;
+      for (uint64_t bits = out->words[w]; bits != 0; bits &= bits - 1) {
+        uint64_t below = (bits & -bits) - 1;
+        int countA = a->counts[a->ranks[w]
+                               + __builtin_popcountll(a->words[w] & below)];
+        int countB = b->counts[b->ranks[w]
+                               + __builtin_popcountll(b->words[w] & below)];
+        out->counts[out->size++] = (countA < countB) ? countA : countB;
+      }
+    }
+  }
+
+  container_settle(out);
+  return true;
+}
+
+/**************** container_or() ****************/
+/* Compute the members of either a or b into out, an empty container with
+ * their key, each with the sum of its counts.  Returns false if out of
+ * memory.
+ */
+static bool
+container_or(const container_t* a, const container_t* b, container_t* out)
+{
+  if (a->words == NULL && b->words == NULL) {
+    // two arrays: merge them
+    if (!container_reserve(out, a->size + b->size)) {
+      return false;
+    }
+    int i = 0;
+    int j = 0;
+    while (i < a->size || j < b->size) {
+      if (j == b->size || (i < a->size && a->values[i] < b->values[j])) {
+        out->values[out->size] = a->values[i];
+        out->counts[out->size++] = a->counts[i++];
+      } else if (i == a->size || b->values[j] < a->values[i]) {
+        out->values[out->size] = b->values[j];
+        out->counts[out->size++] = b->counts[j++];
+      } else {
+        out->values[out->size] = a->values[i];
+        out->counts[out->size++] = a->counts[i++] + b->counts[j++];
+      }
+    }
+
+  } else {
+    // at least one bitmap: OR the words, then walk the result's members
+    // alongside both inputs' members to add up the counts
+    int wordsA = (a->words != NULL) ? a->numWords : container_last(a) / 64 + 1;
+    int wordsB = (b->words != NULL) ? b->numWords : container_last(b) / 64 + 1;
+    if (!container_growWords(out, (wordsA > wordsB) ? wordsA : wordsB)
+        || !container_reserve(out, a->size + b->size)) {
+      return false;
+    }
+    container_setBits(out, a);
+    container_setBits(out, b);
+
+    int i = 0;
+    int j = 0;
+    for (int w = 0; w < out->numWords; w++) {
+      out->ranks[w] = out->size;
+      for (uint64_t bits = out->words[w]; bits != 0; bits &= bits - 1) {
+        int low = w * 64 + __builtin_ctzll(bits);
+        out->counts[out->size++] = container_take(a, &i, low)
+                                   + container_take(b, &j, low);
+      }
+    }
+  }
+
+  container_settle(out);
+  return true;
+}
+
+/**************** words_and() ****************/
+/* out[i] = a[i] & b[i] for i in 0..n-1, 128 bits at a time with SSE2.
+ */
+static void
+words_and(uint64_t* out, const uint64_t* a, const uint64_t* b, const int n)
+{
+  int i = 0;
+#ifdef __SSE2__
+  for (; i + 2 <= n; i += 2) {
+    __m128i x = _mm_loadu_si128((const __m128i*)&a[i]);
+    __m128i y = _mm_loadu_si128((const __m128i*)&b[i]);
+    _mm_storeu_si128((__m128i*)&out[i], _mm_and_si128(x, y));
+  }
+#endif
+  for (; i < n; i++) {
+    out[i] = a[i] & b[i];
+  }
+}
+
+/**************** words_or() ****************/
+/* out[i] = a[i] | b[i] for i in 0..n-1, 128 bits at a time with SSE2.
+ */
+static void
+words_or(uint64_t* out, const uint64_t* a, const uint64_t* b, const int n)
+{
+  int i = 0;
+#ifdef __SSE2__
+  for (; i + 2 <= n; i += 2) {
+    __m128i x = _mm_loadu_si128((const __m128i*)&a[i]);
+    __m128i y = _mm_loadu_si128((const __m128i*)&b[i]);
+    _mm_storeu_si128((__m128i*)&out[i], _mm_or_si128(x, y));
+  }
+#endif
+  for (; i < n; i++) {
+    out[i] = a[i] | b[i];
+  }
+}
@@ -0,0 +1,132 @@
+/*
+ * bitmap.h - header file for CS50 bitmap module
+ *
+ * A "bitmap" is a compressed set of docIDs, each with a count, for the
+ * postings of common words.  It is built like a Roaring bitmap: the
+ * docIDs are split into chunks of 65536 by their high bits, and each
+ * chunk that has members is a "container" holding the members' low 16
+ * bits either as a sorted array or as one bit per docID, whichever takes
+ * less memory.  The counts are kept in docID order beside the members.
+ *
+ * Intersecting or uniting two bitmap containers is a word-at-a-time AND
+ * or OR, done 128 bits at a time with SSE2 where available, followed by a
+ * pass over the set bits to combine the counts.  So a bitmap suits words
+ * found in a large fraction of the documents; a postings list (see
+ * postings.h) remains the better form for rare words, and the functions
+ * below also combine a bitmap with a postings list.
+ */
+
+#ifndef __BITMAP_H
+#define __BITMAP_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "postings.h"
+
+/**************** global types ****************/
+typedef struct bitmap bitmap_t;  // opaque to users of the module
+
+/**************** functions ****************/
+
+/**************** bitmap_new ****************/
+/* Create a new (empty) bitmap.
+ *
+ * We return:
+ *   pointer to a new bitmap; NULL if error (out of memory).
+ * Caller is responsible for:
+ *   later calling bitmap_delete();
+ */
+bitmap_t* bitmap_new(void);
+
+/**************** bitmap_add ****************/
+/* Add count to the counter of docID, which must be no smaller than any
+ * docID already in the bitmap.
+ *
+ * Caller provides:
+ *   valid pointer to bitmap, docID >= 0, count > 0.
+ * We return:
+ *   true on success; false if any argument is invalid, docID is out of
+ *   order, or out of memory.
+ */
+bool bitmap_add(bitmap_t* bitmap, const int docID, const int count);
+
+/**************** bitmap_size ****************/
+/* Return the number of docIDs in the bitmap; 0 if bitmap is NULL.
+ */
+int bitmap_size(const bitmap_t* bitmap);
+
+/**************** bitmap_get ****************/
+/* Return the counter of docID; 0 if bitmap is NULL or docID is absent.
+ */
+int bitmap_get(const bitmap_t* bitmap, const int docID);
+
+/**************** bitmap_and ****************/
+/* Intersect two bitmaps.
+ *
+ * We return:
+ *   a new bitmap of the docIDs in both, each with the smaller of its two
+ *   counts; NULL if either is NULL or out of memory.
+ * Caller is responsible for:
+ *   later calling bitmap_delete();
+ */
+bitmap_t* bitmap_and(const bitmap_t* a, const bitmap_t* b);
+
+/**************** bitmap_or ****************/
+/* Unite two bitmaps.
+ *
+ * We return:
+ *   a new bitmap of the docIDs in either, each with the sum of its
+ *   counts; NULL if either is NULL or out of memory.
+ * Caller is responsible for:
+ *   later calling bitmap_delete();
+ */
+bitmap_t* bitmap_or(const bitmap_t* a, const bitmap_t* b);
+
+/**************** bitmap_andPostings ****************/
+/* Intersect a bitmap with a postings list, looking each of the list's
+ * docIDs up in the bitmap.
+ *
+ * We return:
+ *   a new postings list of the docIDs in both, each with the smaller of
+ *   its two counts; NULL if either is NULL or out of memory.
+ * Caller is responsible for:
+ *   later calling postings_delete();
+ */
+postings_t* bitmap_andPostings(const bitmap_t* bitmap,
+                               const postings_t* postings);
+
+/**************** bitmap_orPostings ****************/
+/* Unite a bitmap with a postings list.
+ *
+ * We return:
+ *   a new bitmap of the docIDs in either, each with the sum of its
+ *   counts; NULL if either is NULL or out of memory.
+ * Caller is responsible for:
+ *   later calling bitmap_delete();
+ */
+bitmap_t* bitmap_orPostings(const bitmap_t* bitmap,
+                            const postings_t* postings);
+
+/**************** bitmap_iterate ****************/
+/* Call itemfunc once for each docID, with (arg, docID, count), in
+ * increasing docID order.
+ *
+ * We do:
+ *   nothing, if bitmap==NULL or itemfunc==NULL.
+ */
+void bitmap_iterate(const bitmap_t* bitmap, void* arg,
+                    void (*itemfunc)(void* arg,
+                                     const int docID, const int count));
+
+/**************** bitmap_print ****************/
+/* Print the bitmap as {docID=count,...}; "(null)" if bitmap is NULL;
+ * nothing if fp is NULL.
+ */
+void bitmap_print(const bitmap_t* bitmap, FILE* fp);
+
+/**************** bitmap_delete ****************/
+/* Delete the bitmap; we ignore NULL.
+ */
+void bitmap_delete(bitmap_t* bitmap);
+
+#endif // __BITMAP_H
@@ -0,0 +1,285 @@
+/*
+ * chashtable.c - CS50 'chashtable' module
+ *
+ * see chashtable.h for more information.
+ *
+ * The table is an array of stripes, each one of our hashtables guarded
+ * by a pthread readers-writer lock.  A key is hashed once with
+ * hash_bytes; the top bits of the hash pick the stripe, and the whole
+ * hash is handed to the stripe's hashtable, whose probing uses the low
+ * bits, so the two choices are independent.
+ *
+ * Finds take the stripe's read lock; inserts first look under the read
+ * lock, since the key is often present already, and only then take the
+ * write lock and look again.  A snapshot read-locks every stripe, in
+ * order, so it sees the table at one instant; writers never hold more
+ * than one lock, so this cannot deadlock.
+ *
+ * Stripes are aligned to cache lines, so threads locking neighboring
+ * stripes do not contend for the same line.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "chashtable.h"
+#include "hashtable.h"
+#include "hash.h"
+#include "mem.h"
+
+/**************** file-local constants ****************/
+#define CACHE_LINE 64           // bytes per cache line
+#define MAX_STRIPES 1024        // upper limit on stripes
+
+/**************** local types ****************/
+typedef struct stripe {
+  _Alignas(CACHE_LINE) pthread_rwlock_t lock;
+  hashtable_t* table;           // keys whose hashes select this stripe
+  size_t size;                  // number of keys in table
+} stripe_t;
+
+// one (key, item) pair of a snapshot
+typedef struct pair {
+  const char* key;
+  void* item;
+} pair_t;
+
+// where a snapshot is being copied to
+typedef struct snapshot {
+  pair_t* pairs;
+  size_t count;
+} snapshot_t;
+
+/**************** global types ****************/
+typedef struct chashtable {
+  stripe_t* stripes;            // numStripes stripes
+  int numStripes;               // a power of two
+  int stripeShift;              // hash >> stripeShift is the stripe
+} chashtable_t;
+
+/**************** local functions ****************/
+/* not visible outside this file */
+static stripe_t* chashtable_stripe(chashtable_t* ht, const uint64_t hash);
+static void chashtable_copy(void* arg, const char* key, void* item);
+
+/**************** chashtable_new() ****************/
+/* see chashtable.h for description */
+chashtable_t*
+chashtable_new(const int num_keys, const int num_stripes)
+{
+  if (num_keys <= 0 || num_stripes <= 0) {
+    return NULL;
+  }
+
+  chashtable_t* ht = mem_malloc(sizeof(chashtable_t));
+  if (ht == NULL) {
+    return NULL;
+  }
+  int bits = 0;
+  while ((1 << bits) < num_stripes && (1 << bits) < MAX_STRIPES) {
+    bits++;
+  }
+  ht->numStripes = 1 << bits;
+  // with one stripe, shifting by 64 would be undefined; 63 leaves one bit
+  ht->stripeShift = (bits == 0) ? 63 : 64 - bits;
+
+  // aligned_alloc needs a size that is a multiple of the alignment,
+  // which sizeof(stripe_t) is
+  ht->stripes = aligned_alloc(CACHE_LINE, ht->numStripes * sizeof(stripe_t));
+  if (ht->stripes == NULL) {
+    mem_free(ht);
+    return NULL;
+  }
+
+  const int slots = num_keys / ht->numStripes + 1;
+  for (int i = 0; i < ht->numStripes; i++) {
+    stripe_t* stripe = &ht->stripes[i];
+    stripe->table = hashtable_new(slots);
+    stripe->size = 0;
+    if (stripe->table == NULL) {
+      for (int j = 0; j < i; j++) {
+        hashtable_delete(ht->stripes[j].table, NULL);
+        pthread_rwlock_destroy(&ht->stripes[j].lock);
+      }
+      free(ht->stripes);
+      mem_free(ht);
+      return NULL;
+    }
+    pthread_rwlock_init(&stripe->lock, NULL);
+  }
+  return ht;
+}
+
+/**************** chashtable_insert() ****************/
+/* see chashtable.h for description */
+bool
+chashtable_insert(chashtable_t* ht, const char* key, void* item)
+{
+  if (ht == NULL || key == NULL || item == NULL) {
+    return false;
+  }
+
+  const uint64_t hash = hash_bytes(key, strlen(key));
+  stripe_t* stripe = chashtable_stripe(ht, hash);
+
+  pthread_rwlock_rdlock(&stripe->lock);
+  bool present = (hashtable_findHashed(stripe->table, key, hash) != NULL);
+  pthread_rwlock_unlock(&stripe->lock);
+  if (present) {
+    return false;
+  }
+
+  pthread_rwlock_wrlock(&stripe->lock);
+  bool inserted = hashtable_insertHashed(stripe->table, key, hash, item);
+  if (inserted) {
+    stripe->size++;
+  }
+  pthread_rwlock_unlock(&stripe->lock);
+  return inserted;
+}
+
+/**************** chashtable_findOrInsert() ****************/
+/* see chashtable.h for description */
+void*
+chashtable_findOrInsert(chashtable_t* ht, const char* key, void* item)
+{
+  if (ht == NULL || key == NULL || item == NULL) {
+    return NULL;
+  }
+
+  const uint64_t hash = hash_bytes(key, strlen(key));
+  stripe_t* stripe = chashtable_stripe(ht, hash);
+
+  pthread_rwlock_rdlock(&stripe->lock);
+  void* found = hashtable_findHashed(stripe->table, key, hash);
+  pthread_rwlock_unlock(&stripe->lock);
+  if (found != NULL) {
+    return found;
+  }
+
+  // another thread may have inserted the key since we looked
+  pthread_rwlock_wrlock(&stripe->lock);
+  found = hashtable_findHashed(stripe->table, key, hash);
+  if (found == NULL) {
+    if (hashtable_insertHashed(stripe->table, key, hash, item)) {
+      stripe->size++;
+      found = item;
+    }
+  }
+  pthread_rwlock_unlock(&stripe->lock);
+  return found;
+}
+
+/**************** chashtable_find() ****************/
+/* see chashtable.h for description */
+void*
+chashtable_find(chashtable_t* ht, const char* key)
+{
+  if (ht == NULL || key == NULL) {
+    return NULL;
+  }
+
+  const uint64_t hash = hash_bytes(key, strlen(key));
+  stripe_t* stripe = chashtable_stripe(ht, hash);
+
+  pthread_rwlock_rdlock(&stripe->lock);
+  void* found = hashtable_findHashed(stripe->table, key, hash);
+  pthread_rwlock_unlock(&stripe->lock);
+  return found;
+}
+
+/**************** chashtable_size() ****************/
+/* see chashtable.h for description */
+size_t
+chashtable_size(chashtable_t* ht)
+{
+  if (ht == NULL) {
+    return 0;
+  }
+
+  size_t size = 0;
+  for (int i = 0; i < ht->numStripes; i++) {
+    pthread_rwlock_rdlock(&ht->stripes[i].lock);
+    size += ht->stripes[i].size;
+    pthread_rwlock_unlock(&ht->stripes[i].lock);
+  }
+  return size;
+}
+
+/**************** chashtable_iterate() ****************/
+/* see chashtable.h for description */
+size_t
+chashtable_iterate(chashtable_t* ht, void* arg,
+                   void (*itemfunc)(void* arg, const char* key, void* item) )
+{
+  if (ht == NULL || itemfunc == NULL) {
+    return 0;
+  }
+
+  size_t size = 0;
+  for (int i = 0; i < ht->numStripes; i++) {
+    pthread_rwlock_rdlock(&ht->stripes[i].lock);
+    size += ht->stripes[i].size;
+  }
+
+  // keys are never removed, so the pointers stay valid after unlocking;
+  // one spare pair keeps an empty table from asking for 0 bytes
+  snapshot_t snapshot = { mem_malloc((size + 1) * sizeof(pair_t)), 0 };
+  for (int i = 0; i < ht->numStripes; i++) {
+    if (snapshot.pairs != NULL) {
+      hashtable_iterate(ht->stripes[i].table, &snapshot, chashtable_copy);
+    }
+    pthread_rwlock_unlock(&ht->stripes[i].lock);
+  }
+  if (snapshot.pairs == NULL) {
+    return 0;
+  }
+
+  for (size_t i = 0; i < snapshot.count; i++) {
+    (*itemfunc)(arg, snapshot.pairs[i].key, snapshot.pairs[i].item);
+  }
+  mem_free(snapshot.pairs);
+  return snapshot.count;
+}
+
+/**************** chashtable_delete() ****************/
+/* see chashtable.h for description */
+void
+chashtable_delete(chashtable_t* ht, void (*itemdelete)(void* item) )
+{
+  if (ht == NULL) {
+    return;
+  }
+
+  for (int i = 0; i < ht->numStripes; i++) {
+    hashtable_delete(ht->stripes[i].table, itemdelete);
+    pthread_rwlock_destroy(&ht->stripes[i].lock);
+  }
+  free(ht->stripes);
+  mem_free(ht);
+}
+
+/**************** chashtable_stripe() ****************/
+/* Return the stripe for a key with the given hash.
+ */
+static stripe_t*
+chashtable_stripe(chashtable_t* ht, const uint64_t hash)
+{
+  return &ht->stripes[(hash >> ht->stripeShift) & (ht->numStripes - 1)];
+}
+
+/**************** chashtable_copy() ****************/
+/* Append one (key, item) pair to a snapshot.
+ */
+static void
+chashtable_copy(void* arg, const char* key, void* item)
+{
+  snapshot_t* snapshot = arg;
+  snapshot->pairs[snapshot->count].key = key;
+  snapshot->pairs[snapshot->count].item = item;
+  snapshot->count++;
+}
@@ -0,0 +1,127 @@
+/*
+ * chashtable.h - header file for CS50 concurrent hashtable module
+ *
+ * A *chashtable* is a hashtable (a set of (key,item) pairs) that any
+ * number of threads may use at once.  Keys are only ever added, never
+ * removed, which fits its uses: a crawler's set of seen URLs, or the
+ * words of an index built by several threads.
+ *
+ * The table is split into stripes, each a hashtable with its own
+ * readers-writer lock; a key's stripe is chosen by the top bits of its
+ * hash, so threads working on different keys rarely wait for each other,
+ * and finds in the same stripe run side by side.
+ *
+ * Items are not locked: once a thread has found an item, any changes it
+ * makes to that item must be synchronized by the caller.
+ */
+
+#ifndef __CHASHTABLE_H
+#define __CHASHTABLE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/**************** global types ****************/
+typedef struct chashtable chashtable_t;  // opaque to users of the module
+
+/**************** functions ****************/
+
+/**************** chashtable_new ****************/
+/* Create a new (empty) concurrent hashtable.
+ *
+ * Caller provides:
+ *   expected number of keys (must be > 0); the table grows past it,
+ *   number of stripes (must be > 0; rounded up to a power of two, at
+ *   most 1024); a few times the number of threads is plenty.
+ * We return:
+ *   pointer to the new table; return NULL if error.
+ * We guarantee:
+ *   table is initialized empty.
+ * Caller is responsible for:
+ *   later calling chashtable_delete, when no other thread is using it.
+ */
+chashtable_t* chashtable_new(const int num_keys, const int num_stripes);
+
+/**************** chashtable_insert ****************/
+/* Insert item, identified by key (string), if key is not already present.
+ *
+ * Caller provides:
+ *   valid pointer to table, valid string for key, valid pointer for item.
+ * We return:
+ *   false if key exists in the table, any parameter is NULL, or error;
+ *   true iff new item was inserted.
+ * Notes:
+ *   The key string is copied for use by the table.  When several
+ *   threads insert the same key at once, exactly one of them succeeds.
+ */
+bool chashtable_insert(chashtable_t* ht, const char* key, void* item);
+
+/**************** chashtable_findOrInsert ****************/
+/* Return the item for key, inserting the given item if key is absent.
+ *
+ * Caller provides:
+ *   valid pointer to table, valid string for key, valid pointer for item.
+ * We return:
+ *   the item now associated with key: the given item if it was inserted,
+ *   otherwise the item that was already there; NULL if any parameter is
+ *   NULL or error.
+ * Notes:
+ *   A caller that made item only to insert it may free it when another
+ *   item is returned; that is, when another thread got there first.
+ */
+void* chashtable_findOrInsert(chashtable_t* ht, const char* key, void* item);
+
+/**************** chashtable_find ****************/
+/* Return the item associated with the given key.
+ *
+ * Caller provides:
+ *   valid pointer to table, valid string for key.
+ * We return:
+ *   pointer to the item corresponding to the given key, if found;
+ *   NULL if table is NULL, key is NULL, or key is not found.
+ */
+void* chashtable_find(chashtable_t* ht, const char* key);
+
+/**************** chashtable_size ****************/
+/* Return the number of keys in the table (0 if ht is NULL).
+ * Keys inserted by other threads during the call may or may not count.
+ */
+size_t chashtable_size(chashtable_t* ht);
+
+/**************** chashtable_iterate ****************/
+/* Iterate over a snapshot of all items in the table; in undefined order.
+ *
+ * Caller provides:
+ *   valid pointer to table,
+ *   arbitrary void*arg pointer,
+ *   itemfunc that can handle a single (key, item) pair.
+ * We do:
+ *   nothing, if ht==NULL or itemfunc==NULL.
+ *   otherwise, take a snapshot of the (key, item) pairs in the table at
+ *   one instant, then call the itemfunc once for each, with (arg, key,
+ *   item), holding no locks.
+ * We return:
+ *   the number of items visited, or 0 if out of memory.
+ * Notes:
+ *   Other threads may keep inserting while itemfunc runs, and itemfunc
+ *   may itself use the table; keys inserted after the snapshot are not
+ *   visited.
+ */
+size_t chashtable_iterate(chashtable_t* ht, void* arg,
+                          void (*itemfunc)(void* arg, const char* key, void* item) );
+
+/**************** chashtable_delete ****************/
+/* Delete the table, calling a delete function on each item.
+ *
+ * Caller provides:
+ *   valid table pointer, used by no other thread,
+ *   valid pointer to function that handles one item (may be NULL).
+ * We do:
+ *   if table==NULL, do nothing.
+ *   otherwise, unless itemfunc==NULL, call the itemfunc on each item.
+ *   free all the key strings, and the table itself.
+ */
+void chashtable_delete(chashtable_t* ht, void (*itemdelete)(void* item) );
+
+#endif // __CHASHTABLE_H
@@ -0,0 +1,192 @@
+/*
+ * chashtablebench.c - scaling benchmark for the CS50 'chashtable' module
+ *
+ * Times a shared table on 1, 2, 4, ... up to N threads, for two
+ * workloads:
+ *   insert - the threads together insert numKeys distinct keys, each
+ *            key offered by two threads, as a crawler's seen-set would
+ *            see URLs found on several pages,
+ *   find   - the threads each look up numKeys keys at random, 90% of
+ *            them present, in the full table.
+ * Each is run with one stripe, which is a single lock around one
+ * hashtable, and with 4 stripes per thread, so the gain of striping
+ * shows beside the gain of threads.  Throughput is in millions of
+ * operations per second, with the speedup over one thread.
+ *
+ * usage: chashtablebench [maxThreads [numKeys]]
+ *   maxThreads defaults to the number of processors; numKeys to 1000000.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "chashtable.h"
+
+/**************** file-local constants ****************/
+#define KEYS 1000000            // default number of keys
+#define KEYLEN 32               // room for any generated key
+
+/**************** local types ****************/
+typedef enum workload { INSERT, FIND } workload_t;
+
+// what one thread of a run does
+typedef struct worker {
+  pthread_t thread;
+  workload_t workload;
+  chashtable_t* ht;
+  int id;
+  int numThreads;
+  long ops;                     // operations done
+} worker_t;
+
+/**************** global variables ****************/
+static char (*keys)[KEYLEN];    // numKeys present keys, then numKeys misses
+static int numKeys;
+static int present = 1;         // any non-NULL item will do
+
+/**************** local functions ****************/
+static double run(chashtable_t* ht, const workload_t workload,
+                  const int numThreads, long* ops);
+static void* work(void* arg);
+static double now(void);
+
+int
+main(const int argc, char* argv[])
+{
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  int maxThreads = (argc > 1) ? atoi(argv[1]) : (cpus > 0 ? cpus : 1);
+  numKeys = (argc > 2) ? atoi(argv[2]) : KEYS;
+  if (argc > 3 || maxThreads < 1 || numKeys < 1) {
+    fprintf(stderr, "usage: %s [maxThreads [numKeys]]\n", argv[0]);
+    return 1;
+  }
+
+  keys = malloc(2 * (size_t)numKeys * KEYLEN);
+  if (keys == NULL) {
+    fprintf(stderr, "out of memory\n");
+    return 2;
+  }
+  for (int i = 0; i < 2 * numKeys; i++) {
+    snprintf(keys[i], KEYLEN, "http://x.org/%d.html", i);
+  }
+
+  printf("%s: %d keys, up to %d threads on %ld processors\n",
+         argv[0], numKeys, maxThreads, cpus);
+  printf("%-8s %7s %7s %10s %8s\n", "workload", "threads", "stripes",
+         "Mops/s", "speedup");
+
+  for (workload_t workload = INSERT; workload <= FIND; workload++) {
+    const char* name = (workload == INSERT) ? "insert" : "find";
+    for (int striped = 0; striped <= 1; striped++) {
+      double base = 0;
+      // 1, 2, 4, ..., and maxThreads itself
+      for (int t = 1; t <= maxThreads;
+           t = (t < maxThreads && 2 * t > maxThreads) ? maxThreads : 2 * t) {
+        const int stripes = striped ? 4 * t : 1;
+        chashtable_t* ht = chashtable_new(numKeys, stripes);
+        if (ht == NULL) {
+          fprintf(stderr, "out of memory\n");
+          return 2;
+        }
+        long ops;
+        if (workload == FIND) {
+          run(ht, INSERT, t, &ops);       // fill the table, untimed
+        }
+        double seconds = run(ht, workload, t, &ops);
+        double rate = ops / seconds / 1e6;
+        if (t == 1) {
+          base = rate;
+        }
+        printf("%-8s %7d %7d %10.2f %7.2fx\n", name, t, stripes, rate, rate / base);
+        fflush(stdout);
+        chashtable_delete(ht, NULL);
+      }
+    }
+  }
+
+  free(keys);
+  return 0;
+}
+
+/**************** run() ****************/
+/* Run a workload on numThreads threads, setting ops to the number of
+ * operations done; returns the seconds it took.
+ */
+static double
+run(chashtable_t* ht, const workload_t workload, const int numThreads, long* ops)
+{
+  worker_t* workers = calloc(numThreads, sizeof(worker_t));
+  if (workers == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(2);
+  }
+
+  double start = now();
+  for (int i = 0; i < numThreads; i++) {
+    workers[i] = (worker_t){ .workload = workload, .ht = ht, .id = i,
+                             .numThreads = numThreads };
+    if (pthread_create(&workers[i].thread, NULL, work, &workers[i]) != 0) {
+      fprintf(stderr, "cannot start thread %d\n", i);
+      exit(2);
+    }
+  }
+  *ops = 0;
+  for (int i = 0; i < numThreads; i++) {
+    pthread_join(workers[i].thread, NULL);
+    *ops += workers[i].ops;
+  }
+  double seconds = now() - start;
+
+  free(workers);
+  return seconds;
+}
+
+/**************** work() ****************/
+/* One thread of a run.  For inserts, thread t offers the keys of its
+ * share and of the next thread's share, so every key is offered twice
+ * (once, with one thread).
+ */
+static void*
+work(void* arg)
+{
+  worker_t* me = arg;
+  const int n = me->numThreads;
+
+  if (me->workload == INSERT) {
+    const int shares = (n == 1) ? 1 : 2;
+    for (int s = 0; s < shares; s++) {
+      const int share = (me->id + s) % n;
+      for (int i = share; i < numKeys; i += n) {
+        chashtable_insert(me->ht, keys[i], &present);
+        me->ops++;
+      }
+    }
+  } else {
+    uint64_t state = me->id + 1;
+    for (int i = 0; i < numKeys; i++) {
+      state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+      uint64_t r = state >> 33;
+      int k = (r % 10 == 0) ? numKeys + (r / 10) % numKeys : (r / 10) % numKeys;
+      chashtable_find(me->ht, keys[k]);
+      me->ops++;
+    }
+  }
+  return NULL;
+}
+
+/**************** now() ****************/
+/* Return a monotonic time in seconds.
+ */
+static double
+now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
@@ -0,0 +1,288 @@
+/*
+ * chashtabletest.c - test of the CS50 'chashtable' module under threads
+ *
+ * Several threads share one table at once:
+ *   - inserters each insert every key, in a different order, with
+ *     chashtable_insert; exactly one of them must win each key,
+ *   - claimers do the same with chashtable_findOrInsert, offering their
+ *     own items; each must get back the item of the thread that won,
+ *   - readers find keys while the others insert, and must only ever see
+ *     the item a key was inserted with,
+ *   - a snapshotter iterates repeatedly; each snapshot must hold only
+ *     keys of the test, once each, and never fewer than the last.
+ * Then the final table is checked key by key.
+ *
+ * The Makefile builds it with ThreadSanitizer ('make test-chashtable'),
+ * which reports any data race; the test itself exits non-zero if any
+ * check fails.
+ *
+ * usage: chashtabletest [numThreads [numKeys]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "chashtable.h"
+
+/**************** file-local constants ****************/
+#define THREADS 4               // default threads of each kind
+#define KEYS 20000              // default number of keys
+#define KEYLEN 16               // room for any generated key
+
+/**************** local types ****************/
+// one thread of the test
+typedef struct worker {
+  pthread_t thread;
+  int id;                       // 0 .. 3*numThreads, also the item
+  long won;                     // keys this thread inserted
+} worker_t;
+
+/**************** global variables ****************/
+static chashtable_t* ht;
+static char (*keys)[KEYLEN];
+static int numKeys;
+static int numThreads;
+static int* ids;                // ids[i] == i, the items of the threads
+static atomic_int* winners;     // id of the thread that inserted key i
+static atomic_int failures;
+
+/**************** local functions ****************/
+static void* inserter(void* arg);
+static void* claimer(void* arg);
+static void* reader(void* arg);
+static void* snapshotter(void* arg);
+static void check_pair(void* arg, const char* key, void* item);
+static int key_index(const char* key);
+static void fail(const char* message, const char* key);
+
+int
+main(const int argc, char* argv[])
+{
+  numThreads = (argc > 1) ? atoi(argv[1]) : THREADS;
+  numKeys = (argc > 2) ? atoi(argv[2]) : KEYS;
+  if (argc > 3 || numThreads < 1 || numKeys < 1) {
+    fprintf(stderr, "usage: %s [numThreads [numKeys]]\n", argv[0]);
+    return 1;
+  }
+
+  keys = malloc(numKeys * sizeof(*keys));
+  winners = malloc(numKeys * sizeof(atomic_int));
+  ids = malloc((3 * numThreads + 1) * sizeof(int));
+  ht = chashtable_new(numKeys / 8 + 1, 4 * numThreads);
+  if (keys == NULL || winners == NULL || ids == NULL || ht == NULL) {
+    fprintf(stderr, "out of memory\n");
+    return 2;
+  }
+  for (int i = 0; i < numKeys; i++) {
+    snprintf(keys[i], KEYLEN, "key%d", i);
+    atomic_init(&winners[i], -1);
+  }
+  for (int i = 0; i <= 3 * numThreads; i++) {
+    ids[i] = i;
+  }
+
+  // inserters, claimers, readers, and one snapshotter
+  const int numWorkers = 3 * numThreads + 1;
+  worker_t* workers = calloc(numWorkers, sizeof(worker_t));
+  if (workers == NULL) {
+    fprintf(stderr, "out of memory\n");
+    return 2;
+  }
+  for (int i = 0; i < numWorkers; i++) {
+    void* (*func)(void*) = (i < numThreads) ? inserter
+                           : (i < 2 * numThreads) ? claimer
+                           : (i < 3 * numThreads) ? reader : snapshotter;
+    workers[i].id = i;
+    if (pthread_create(&workers[i].thread, NULL, func, &workers[i]) != 0) {
+      fprintf(stderr, "cannot start thread %d\n", i);
+      return 2;
+    }
+  }
+  long won = 0;
+  for (int i = 0; i < numWorkers; i++) {
+    pthread_join(workers[i].thread, NULL);
+    won += workers[i].won;
+  }
+
+  // every key was won exactly once, and is there with its winner's item
+  if (won != numKeys) {
+    fprintf(stderr, "FAIL: %ld keys won, expected %d\n", won, numKeys);
+    atomic_fetch_add(&failures, 1);
+  }
+  if (chashtable_size(ht) != numKeys) {
+    fprintf(stderr, "FAIL: size %zu, expected %d\n", chashtable_size(ht), numKeys);
+    atomic_fetch_add(&failures, 1);
+  }
+  for (int i = 0; i < numKeys; i++) {
+    int* item = chashtable_find(ht, keys[i]);
+    if (item == NULL || *item != atomic_load(&winners[i])) {
+      fail("final item is not the winner's", keys[i]);
+    }
+  }
+  if (chashtable_find(ht, "nokey") != NULL) {
+    fail("found a key never inserted", "nokey");
+  }
+  if (chashtable_iterate(ht, NULL, check_pair) != numKeys) {
+    fail("final snapshot has the wrong number of keys", "");
+  }
+
+  chashtable_delete(ht, NULL);
+  free(workers);
+  free(ids);
+  free((void*)winners);
+  free(keys);
+
+  if (atomic_load(&failures) > 0) {
+    printf("%s: %d checks failed\n", argv[0], atomic_load(&failures));
+    return 3;
+  }
+  printf("%s: %d threads of each kind, %d keys: all checks passed\n",
+         argv[0], numThreads, numKeys);
+  return 0;
+}
+
+/**************** inserter() ****************/
+/* Insert every key, starting at a different place in each thread.
+ */
+static void*
+inserter(void* arg)
+{
+  worker_t* me = arg;
+  const int start = me->id * (numKeys / numThreads);
+  for (int n = 0; n < numKeys; n++) {
+    const int i = (start + n) % numKeys;
+    if (chashtable_insert(ht, keys[i], &ids[me->id])) {
+      int none = -1;
+      if (!atomic_compare_exchange_strong(&winners[i], &none, me->id)) {
+        fail("key inserted twice", keys[i]);
+      }
+      me->won++;
+    }
+  }
+  return NULL;
+}
+
+/**************** claimer() ****************/
+/* Find or insert every key, backwards, checking the item we get back.
+ */
+static void*
+claimer(void* arg)
+{
+  worker_t* me = arg;
+  for (int i = numKeys - 1; i >= 0; i--) {
+    int* item = chashtable_findOrInsert(ht, keys[i], &ids[me->id]);
+    if (item == &ids[me->id]) {
+      int none = -1;
+      if (!atomic_compare_exchange_strong(&winners[i], &none, me->id)) {
+        fail("key inserted twice", keys[i]);
+      }
+      me->won++;
+    } else if (item == NULL || *item == me->id) {
+      fail("findOrInsert returned a wrong item", keys[i]);
+    }
+  }
+  return NULL;
+}
+
+/**************** reader() ****************/
+/* Find keys while they are being inserted; an item, once seen, must be
+ * a thread's item, and must be the same on every later find.
+ */
+static void*
+reader(void* arg)
+{
+  worker_t* me = arg;
+  for (int pass = 0; pass < 3; pass++) {
+    for (int n = 0; n < numKeys; n++) {
+      const int i = (n * 7919 + me->id) % numKeys;
+      int* item = chashtable_find(ht, keys[i]);
+      if (item != NULL) {
+        if (*item < 0 || *item >= 2 * numThreads) {
+          fail("found an item nobody inserted", keys[i]);
+        }
+        int* again = chashtable_find(ht, keys[i]);
+        if (again != item) {
+          fail("a key's item changed", keys[i]);
+        }
+      }
+    }
+  }
+  return NULL;
+}
+
+/**************** snapshotter() ****************/
+/* Take snapshots while keys are inserted; each must hold each key at
+ * most once, and at least as many keys as the one before.
+ */
+static void*
+snapshotter(void* arg)
+{
+  char* seen = malloc(numKeys);
+  if (seen == NULL) {
+    fail("out of memory", "");
+    return NULL;
+  }
+  size_t last = 0;
+  for (int pass = 0; pass < 20; pass++) {
+    memset(seen, 0, numKeys);
+    size_t count = chashtable_iterate(ht, seen, check_pair);
+    if (count < last) {
+      fail("a snapshot shrank", "");
+    }
+    last = count;
+  }
+  free(seen);
+  return NULL;
+}
+
+/**************** check_pair() ****************/
+/* Check one (key, item) pair of a snapshot; if arg is not NULL, it is
+ * an array of flags for the keys already seen.
+ */
+static void
+check_pair(void* arg, const char* key, void* item)
+{
+  char* seen = arg;
+  int i = key_index(key);
+  if (i < 0) {
+    fail("snapshot has a key never inserted", key);
+    return;
+  }
+  if (seen != NULL) {
+    if (seen[i]) {
+      fail("snapshot has a key twice", key);
+    }
+    seen[i] = 1;
+  }
+  int id = *(int*)item;
+  if (id < 0 || id >= 2 * numThreads) {
+    fail("snapshot has an item nobody inserted", key);
+  }
+}
+
+/**************** key_index() ****************/
+/* Return the index of a key of the test, or -1 if it is not one.
+ */
+static int
+key_index(const char* key)
+{
+  int i;
+  char extra;
+  if (sscanf(key, "key%d%c", &i, &extra) != 1 || i < 0 || i >= numKeys) {
+    return -1;
+  }
+  return i;
+}
+
+/**************** fail() ****************/
+/* Report a failed check.
+ */
+static void
+fail(const char* message, const char* key)
+{
+  fprintf(stderr, "FAIL: %s: '%s'\n", message, key);
+  atomic_fetch_add(&failures, 1);
+}
@@ -1,14 +1,36 @@
 /* =========================================================================
- * hash.c - Jenkins' Hash, maps from string to integer
+ * hash.c - hash functions, map from string to integer
  *
- * Implementation details can be found at:
- *     http://www.burtleburtle.net/bob/hash/doobs.html
+ * see hash.h for details and references.
  * ========================================================================= 
  */
 
 #include <string.h>
 #include "hash.h" 
 
+// wyhash's default secret: four 64-bit constants with good bit mixing
+static const uint64_t wyp[4] = {
+  0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL,
+  0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+};
+
+// wymix(wyp[0], wyp[1]), the starting state for seed 0
+#define WYSEED 0xca813bf4c7abf0a9ULL
+
+// the helpers are inlined even in unoptimized builds, where a call per
+// 4 bytes would cost more than the hashing
+#ifdef __GNUC__
+#define WYINLINE static inline __attribute__((always_inline))
+#else
+#define WYINLINE static inline
+#endif
+
+WYINLINE void wymum(uint64_t* a, uint64_t* b);
+WYINLINE uint64_t wymix(uint64_t a, uint64_t b);
+WYINLINE uint64_t wyr8(const unsigned char* p);
+WYINLINE uint64_t wyr4(const unsigned char* p);
+WYINLINE uint64_t wyr3(const unsigned char* p, const size_t k);
+
 // hash_jenkins - see header file for usage
 unsigned long
 hash_jenkins(const char* str, const unsigned long mod)
@@ -32,3 +54,116 @@ hash_jenkins(const char* str, const unsigned long mod)
 
   return (hash % mod);
 }
+
+// hash_bytes - see header file for usage
+uint64_t
+hash_bytes(const void* ptr, const size_t len)
+{
+  const unsigned char* p = ptr;
+  uint64_t seed = WYSEED;
+  uint64_t a, b;
+
+  if (len <= 16) {
+    if (len >= 4) {
+      // two overlapping reads from each end cover 4..16 bytes
+      const size_t mid = (len >> 3) << 2;
+      a = (wyr4(p) << 32) | wyr4(p + mid);
+      b = (wyr4(p + len - 4) << 32) | wyr4(p + len - 4 - mid);
+    } else if (len > 0) {
+      a = wyr3(p, len);
+      b = 0;
+    } else {
+      a = b = 0;
+    }
+  } else {
+    size_t i = len;
+    if (i >= 48) {
+      // three independent lanes of 16 bytes each
+      uint64_t see1 = seed;
+      uint64_t see2 = seed;
+      do {
+        seed = wymix(wyr8(p) ^ wyp[1], wyr8(p + 8) ^ seed);
+        see1 = wymix(wyr8(p + 16) ^ wyp[2], wyr8(p + 24) ^ see1);
+        see2 = wymix(wyr8(p + 32) ^ wyp[3], wyr8(p + 40) ^ see2);
+        p += 48;
+        i -= 48;
+      } while (i >= 48);
+      seed ^= see1 ^ see2;
+    }
+    while (i > 16) {
+      seed = wymix(wyr8(p) ^ wyp[1], wyr8(p + 8) ^ seed);
+      p += 16;
+      i -= 16;
+    }
+    // the last 16 bytes, which may overlap those already mixed
+    a = wyr8(p + i - 16);
+    b = wyr8(p + i - 8);
+  }
+
+  a ^= wyp[1];
+  b ^= seed;
+  wymum(&a, &b);
+  return wymix(a ^ wyp[0] ^ len, b ^ wyp[1]);
+}
+
+/*
+ * wymum - the 128-bit product of *a and *b; low half to *a, high to *b
+ */
+WYINLINE void
+wymum(uint64_t* a, uint64_t* b)
+{
+#ifdef __SIZEOF_INT128__
+  __extension__ unsigned __int128 r = *a;
+  r *= *b;
+  *a = (uint64_t)r;
+  *b = (uint64_t)(r >> 64);
+#else
+  uint64_t ha = *a >> 32, hb = *b >> 32;
+  uint64_t la = (uint32_t)*a, lb = (uint32_t)*b;
+  uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+  uint64_t t = rl + (rm0 << 32);
+  uint64_t c = t < rl;
+  uint64_t lo = t + (rm1 << 32);
+  c += lo < t;
+  *a = lo;
+  *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+/*
+ * wymix - folds the 128-bit product of a and b to 64 bits
+ */
+WYINLINE uint64_t
+wymix(uint64_t a, uint64_t b)
+{
+  wymum(&a, &b);
+  return a ^ b;
+}
+
+/*
+ * wyr8, wyr4 - read 8 or 4 bytes at any alignment
+ */
+WYINLINE uint64_t
+wyr8(const unsigned char* p)
+{
+  uint64_t v;
+  memcpy(&v, p, 8);
+  return v;
+}
+
+WYINLINE uint64_t
+wyr4(const unsigned char* p)
+{
+  uint32_t v;
+  memcpy(&v, p, 4);
+  return v;
+}
+
+/*
+ * wyr3 - packs the first, middle, and last of k (1..3) bytes
+ */
+WYINLINE uint64_t
+wyr3(const unsigned char* p, const size_t k)
+{
+  return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+}
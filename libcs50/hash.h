@@ -1,14 +1,22 @@
 /* =========================================================================
- * hash.h - Jenkins' Hash, maps from string to integer
+ * hash.h - hash functions, map from string to integer
  *
- * Implementation details can be found at:
+ * hash_jenkins is Jenkins' one-at-a-time hash; details can be found at:
  *     http://www.burtleburtle.net/bob/hash/doobs.html
+ *
+ * hash_bytes is a word-at-a-time hash after Wang Yi's wyhash (final
+ * version 4), which reads 4 or 8 bytes at once and mixes them with
+ * 64x64->128-bit multiplies; details can be found at:
+ *     https://github.com/wangyi-fudan/wyhash
  * ========================================================================= 
  */
 
 #ifndef HASH_H
 #define HASH_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 /*
  * hash_jenkins - Bob Jenkins' one_at_a_time hash function
  * str: char buffer to hash (non-NULL)
@@ -18,4 +26,16 @@
  */
 unsigned long hash_jenkins(const char* str, const unsigned long mod);
 
+/*
+ * hash_bytes - wyhash-style hash of a byte buffer
+ * ptr: bytes to hash (may be NULL if len is 0)
+ * len: number of bytes
+ *
+ * Returns a 64-bit hash of the len bytes at ptr, every bit of which is
+ * well mixed, so any subset of the bits may be used.  The value depends
+ * on the machine's byte order, so it should not be saved to files.
+ * hash_bytes(str, strlen(str)) is the hash the hashtable module uses.
+ */
+uint64_t hash_bytes(const void* ptr, const size_t len);
+
 #endif // HASH_H
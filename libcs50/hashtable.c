@@ -0,0 +1,363 @@
+/*
+ * hashtable.c - CS50 'hashtable' module
+ *
+ * see hashtable.h for more information.
+ *
+ * This implementation replaces the fixed-size chained hashtable of
+ * libcs50-given.a with open addressing in the style of Google's
+ * SwissTable.  Slots live in one array, beside an array of one-byte
+ * "control" values: CTRL_EMPTY for an empty slot, or for a full slot the
+ * low 7 bits of its key's hash.  A lookup compares a whole group of 16
+ * control bytes against those 7 bits at once (with SSE2 where available),
+ * and only calls strcmp on slots whose bits match and whose stored full
+ * hash is equal.  The table doubles when it is 7/8 full; because every
+ * slot keeps its hash, resizing never rehashes a key.
+ *
+ * Keys are hashed with hash_bytes, which reads 8 bytes at a time; the
+ * *Hashed functions take a hash the caller has already computed, so a
+ * key can be hashed once for a find followed by an insert.
+ *
+ * The hashtable API has no removal, so slots never become deleted and
+ * no tombstones are needed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "hashtable.h"
+#include "hash.h"
+#include "mem.h"
+
+/**************** file-local constants ****************/
+#define GROUP 16                // number of slots probed together
+#define CTRL_EMPTY 0x80         // control byte of an empty slot
+#define H2_MASK 0x7f            // hash bits kept in a full slot's control
+
+/**************** local types ****************/
+typedef struct slot {
+  char* key;                    // copy of the key, NULL if empty
+  void* item;                   // the item for that key
+  uint64_t hash;                // full hash of the key
+} slot_t;
+
+/**************** global types ****************/
+typedef struct hashtable {
+  unsigned char* ctrl;          // capacity + GROUP control bytes; the
+                                // last GROUP mirror the first GROUP, so
+                                // a group can be read at any position
+  slot_t* slots;                // capacity slots
+  size_t capacity;              // a power of two, at least GROUP
+  size_t size;                  // number of full slots
+  size_t growAt;                // size at which to double the capacity
+} hashtable_t;
+
+/**************** local functions ****************/
+/* not visible outside this file */
+static unsigned int group_match(const unsigned char* ctrl, const unsigned char c);
+static bool hashtable_alloc(hashtable_t* ht, const size_t capacity);
+static long hashtable_lookup(hashtable_t* ht, const char* key,
+                             const uint64_t hash);
+static size_t hashtable_place(hashtable_t* ht, const uint64_t hash);
+static void hashtable_setctrl(hashtable_t* ht, const size_t i, const unsigned char c);
+static bool hashtable_grow(hashtable_t* ht);
+
+/**************** hashtable_new() ****************/
+/* see hashtable.h for description */
+hashtable_t*
+hashtable_new(const int num_slots)
+{
+  if (num_slots <= 0) {
+    return NULL;
+  }
+
+  hashtable_t* ht = mem_malloc(sizeof(hashtable_t));
+  if (ht == NULL) {
+    return NULL;
+  }
+
+  // room for num_slots items before the first resize
+  size_t capacity = GROUP;
+  while (capacity / 8 * 7 < (size_t)num_slots) {
+    capacity *= 2;
+  }
+
+  if (!hashtable_alloc(ht, capacity)) {
+    mem_free(ht);
+    return NULL;
+  }
+  return ht;
+}
+
+/**************** hashtable_insert() ****************/
+/* see hashtable.h for description */
+bool
+hashtable_insert(hashtable_t* ht, const char* key, void* item)
+{
+  if (ht == NULL || key == NULL || item == NULL) {
+    return false;
+  }
+  return hashtable_insertHashed(ht, key, hash_bytes(key, strlen(key)), item);
+}
+
+/**************** hashtable_insertHashed() ****************/
+/* see hashtable.h for description */
+bool
+hashtable_insertHashed(hashtable_t* ht, const char* key,
+                       const uint64_t hash, void* item)
+{
+  if (ht == NULL || key == NULL || item == NULL) {
+    return false;
+  }
+
+  if (hashtable_lookup(ht, key, hash) >= 0) {
+    return false;               // key already present
+  }
+  if (ht->size >= ht->growAt && !hashtable_grow(ht)) {
+    return false;
+  }
+
+  char* copy = mem_malloc(strlen(key) + 1);
+  if (copy == NULL) {
+    return false;
+  }
+  strcpy(copy, key);
+
+  size_t i = hashtable_place(ht, hash);
+  ht->slots[i].key = copy;
+  ht->slots[i].item = item;
+  ht->slots[i].hash = hash;
+  hashtable_setctrl(ht, i, hash & H2_MASK);
+  ht->size++;
+  return true;
+}
+
+/**************** hashtable_find() ****************/
+/* see hashtable.h for description */
+void*
+hashtable_find(hashtable_t* ht, const char* key)
+{
+  if (ht == NULL || key == NULL) {
+    return NULL;
+  }
+
+  return hashtable_findHashed(ht, key, hash_bytes(key, strlen(key)));
+}
+
+/**************** hashtable_findHashed() ****************/
+/* see hashtable.h for description */
+void*
+hashtable_findHashed(hashtable_t* ht, const char* key, const uint64_t hash)
+{
+  if (ht == NULL || key == NULL) {
+    return NULL;
+  }
+
+  long i = hashtable_lookup(ht, key, hash);
+  return (i < 0) ? NULL : ht->slots[i].item;
+}
+
+/**************** hashtable_print() ****************/
+/* see hashtable.h for description */
+void
+hashtable_print(hashtable_t* ht, FILE* fp,
+                void (*itemprint)(FILE* fp, const char* key, void* item))
+{
+  if (fp == NULL) {
+    return;
+  }
+  if (ht == NULL) {
+    fputs("(null)\n", fp);
+    return;
+  }
+
+  // one line per slot, holding its (key,item) pair if it is full
+  for (size_t i = 0; i < ht->capacity; i++) {
+    if (itemprint != NULL && ht->slots[i].key != NULL) {
+      (*itemprint)(fp, ht->slots[i].key, ht->slots[i].item);
+    }
+    fputc('\n', fp);
+  }
+}
+
+/**************** hashtable_iterate() ****************/
+/* see hashtable.h for description */
+void
+hashtable_iterate(hashtable_t* ht, void* arg,
+                  void (*itemfunc)(void* arg, const char* key, void* item) )
+{
+  if (ht == NULL || itemfunc == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < ht->capacity; i++) {
+    if (ht->slots[i].key != NULL) {
+      (*itemfunc)(arg, ht->slots[i].key, ht->slots[i].item);
+    }
+  }
+}
+
+/**************** hashtable_delete() ****************/
+/* see hashtable.h for description */
+void
+hashtable_delete(hashtable_t* ht, void (*itemdelete)(void* item) )
+{
+  if (ht == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < ht->capacity; i++) {
+    if (ht->slots[i].key != NULL) {
+      if (itemdelete != NULL) {
+        (*itemdelete)(ht->slots[i].item);
+      }
+      mem_free(ht->slots[i].key);
+    }
+  }
+  mem_free(ht->slots);
+  mem_free(ht->ctrl);
+  mem_free(ht);
+}
+
+/**************** group_match() ****************/
+/* Return a bitmask with bit k set if ctrl[k] == c, for k in 0..GROUP-1.
+ */
+static unsigned int
+group_match(const unsigned char* ctrl, const unsigned char c)
+{
+#ifdef __SSE2__
+  __m128i group = _mm_loadu_si128((const __m128i*)ctrl);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)c)));
+#else
+  unsigned int mask = 0;
+  for (int k = 0; k < GROUP; k++) {
+    if (ctrl[k] == c) {
+      mask |= 1u << k;
+    }
+  }
+  return mask;
+#endif
+}
+
+/**************** hashtable_alloc() ****************/
+/* Give ht empty arrays for the given capacity (a power of two).
+ * Returns false if out of memory, leaving ht unchanged.
+ */
+static bool
+hashtable_alloc(hashtable_t* ht, const size_t capacity)
+{
+  unsigned char* ctrl = mem_malloc(capacity + GROUP);
+  slot_t* slots = mem_malloc(capacity * sizeof(slot_t));
+  if (ctrl == NULL || slots == NULL) {
+    if (ctrl != NULL) {
+      mem_free(ctrl);
+    }
+    if (slots != NULL) {
+      mem_free(slots);
+    }
+    return false;
+  }
+
+  memset(ctrl, CTRL_EMPTY, capacity + GROUP);
+  for (size_t i = 0; i < capacity; i++) {
+    slots[i].key = NULL;
+  }
+  ht->ctrl = ctrl;
+  ht->slots = slots;
+  ht->capacity = capacity;
+  ht->size = 0;
+  ht->growAt = capacity / 8 * 7;
+  return true;
+}
+
+/**************** hashtable_lookup() ****************/
+/* Find the slot holding key, whose hash is given.
+ * Probes groups in a triangular sequence, which visits every group
+ * because the capacity is a power of two; the load limit guarantees
+ * an empty slot, which ends an unsuccessful search.
+ * Returns the slot index, or -1 if key is not in the table.
+ */
+static long
+hashtable_lookup(hashtable_t* ht, const char* key, const uint64_t hash)
+{
+  size_t mask = ht->capacity - 1;
+  size_t pos = (hash >> 7) & mask;
+  unsigned char h2 = hash & H2_MASK;
+
+  for (size_t step = GROUP; ; step += GROUP) {
+    const unsigned char* group = ht->ctrl + pos;
+    for (unsigned int m = group_match(group, h2); m != 0; m &= m - 1) {
+      size_t i = (pos + __builtin_ctz(m)) & mask;
+      if (ht->slots[i].hash == hash && strcmp(ht->slots[i].key, key) == 0) {
+        return (long)i;
+      }
+    }
+    if (group_match(group, CTRL_EMPTY) != 0) {
+      return -1;
+    }
+    pos = (pos + step) & mask;
+  }
+}
+
+/**************** hashtable_place() ****************/
+/* Find an empty slot for a new key with the given hash,
+ * following the same probe sequence as hashtable_lookup.
+ */
+static size_t
+hashtable_place(hashtable_t* ht, const uint64_t hash)
+{
+  size_t mask = ht->capacity - 1;
+  size_t pos = (hash >> 7) & mask;
+
+  for (size_t step = GROUP; ; step += GROUP) {
+    unsigned int m = group_match(ht->ctrl + pos, CTRL_EMPTY);
+    if (m != 0) {
+      return (pos + __builtin_ctz(m)) & mask;
+    }
+    pos = (pos + step) & mask;
+  }
+}
+
+/**************** hashtable_setctrl() ****************/
+/* Set the control byte of slot i, and its mirror past the end.
+ */
+static void
+hashtable_setctrl(hashtable_t* ht, const size_t i, const unsigned char c)
+{
+  ht->ctrl[i] = c;
+  if (i < GROUP) {
+    ht->ctrl[ht->capacity + i] = c;
+  }
+}
+
+/**************** hashtable_grow() ****************/
+/* Double the capacity, moving every slot by its stored hash.
+ * Returns false if out of memory, leaving ht unchanged.
+ */
+static bool
+hashtable_grow(hashtable_t* ht)
+{
+  unsigned char* oldCtrl = ht->ctrl;
+  slot_t* oldSlots = ht->slots;
+  size_t oldCapacity = ht->capacity;
+  size_t size = ht->size;
+
+  if (!hashtable_alloc(ht, oldCapacity * 2)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < oldCapacity; i++) {
+    if (oldSlots[i].key != NULL) {
+      size_t j = hashtable_place(ht, oldSlots[i].hash);
+      ht->slots[j] = oldSlots[i];
+      hashtable_setctrl(ht, j, oldSlots[i].hash & H2_MASK);
+    }
+  }
+  ht->size = size;
+
+  mem_free(oldCtrl);
+  mem_free(oldSlots);
+  return true;
+}
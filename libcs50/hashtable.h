@@ -13,6 +13,7 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /**************** global types ****************/
 typedef struct hashtable hashtable_t;  // opaque to users of the module
@@ -62,6 +63,33 @@ bool hashtable_insert(hashtable_t* ht, const char* key, void* item);
  */
 void* hashtable_find(hashtable_t* ht, const char* key);
 
+/**************** hashtable_insertHashed ****************/
+/* Like hashtable_insert, but with the key's hash already computed.
+ *
+ * Caller provides:
+ *   as for hashtable_insert, and
+ *   hash, which must be hash_bytes(key, strlen(key)) (see hash.h).
+ * We return:
+ *   as for hashtable_insert.
+ * Notes:
+ *   A caller that hashes each key once can use the hash for both
+ *   hashtable_findHashed and hashtable_insertHashed.  A wrong hash is
+ *   not detected, and leaves the key unfindable by hashtable_find.
+ */
+bool hashtable_insertHashed(hashtable_t* ht, const char* key,
+                            const uint64_t hash, void* item);
+
+/**************** hashtable_findHashed ****************/
+/* Like hashtable_find, but with the key's hash already computed.
+ *
+ * Caller provides:
+ *   as for hashtable_find, and
+ *   hash, which must be hash_bytes(key, strlen(key)) (see hash.h).
+ * We return:
+ *   as for hashtable_find.
+ */
+void* hashtable_findHashed(hashtable_t* ht, const char* key, const uint64_t hash);
+
 /**************** hashtable_print ****************/
 /* Print the whole table; provide the output file and func to print each item.
  * 
@@ -0,0 +1,228 @@
+/*
+ * hashtablebench.c - benchmark for the CS50 'hashtable' module
+ *
+ * Times the hashtable on the indexer's workload: for every word of every
+ * page, find the word and insert it if it is absent, starting from a
+ * 500-slot table as index_new does; then iterate over the whole table.
+ * The program uses only hashtable.h, so the Makefile links it both with
+ * hashtable.c and with libcs50-given.a to compare the two.
+ *
+ * usage: hashtablebench [pageDirectory]
+ *   Words are read from the crawler's page files 1, 2, 3, ... in
+ *   pageDirectory, as the indexer would (letters only, lowercased, at
+ *   least 3 long). Without a pageDirectory, a synthetic stream of
+ *   2,000,000 words with a Zipf-like distribution over a 200,000-word
+ *   vocabulary is used instead.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include "hashtable.h"
+
+/**************** file-local constants ****************/
+#define SLOTS 500               // initial size, as in index_new(500)
+#define SYNTH_WORDS 2000000     // synthetic stream length
+#define SYNTH_VOCAB 200000      // synthetic vocabulary size
+
+/**************** local types ****************/
+typedef struct words {
+  char* text;                   // all words, each terminated by '\0'
+  size_t len;                   // bytes of text in use
+  size_t cap;                   // bytes of text allocated
+  size_t count;                 // number of words
+} words_t;
+
+/**************** local functions ****************/
+static void words_add(words_t* words, const char* word, const size_t len);
+static void words_readPages(words_t* words, const char* pageDirectory);
+static void words_synthesize(words_t* words);
+static double now(void);
+static void count_item(void* arg, const char* key, void* item);
+
+int
+main(const int argc, char* argv[])
+{
+  if (argc > 2) {
+    fprintf(stderr, "usage: %s [pageDirectory]\n", argv[0]);
+    return 1;
+  }
+
+  words_t words = { NULL, 0, 0, 0 };
+  if (argc == 2) {
+    words_readPages(&words, argv[1]);
+  } else {
+    words_synthesize(&words);
+  }
+  if (words.count == 0) {
+    fprintf(stderr, "%s: no words to index\n", argv[0]);
+    return 2;
+  }
+
+  // the item is never used; any non-NULL pointer will do
+  static int present = 1;
+
+  double start = now();
+  hashtable_t* ht = hashtable_new(SLOTS);
+  size_t distinct = 0;
+  const char* word = words.text;
+  for (size_t i = 0; i < words.count; i++) {
+    if (hashtable_find(ht, word) == NULL) {
+      hashtable_insert(ht, word, &present);
+      distinct++;
+    }
+    word += strlen(word) + 1;
+  }
+  double built = now();
+
+  size_t iterated = 0;
+  hashtable_iterate(ht, &iterated, count_item);
+  double done = now();
+  hashtable_delete(ht, NULL);
+
+  printf("%s: %zu words, %zu distinct\n", argv[0], words.count, distinct);
+  printf("  find/insert %8.1f ns/word  (%.3f s)\n",
+         (built - start) * 1e9 / words.count, built - start);
+  printf("  iterate     %8.1f ns/item  (%zu items)\n",
+         (done - built) * 1e9 / (iterated ? iterated : 1), iterated);
+
+  free(words.text);
+  return 0;
+}
+
+/**************** words_add() ****************/
+/* Append a word of len bytes to the list. Exits if out of memory.
+ */
+static void
+words_add(words_t* words, const char* word, const size_t len)
+{
+  if (words->len + len + 1 > words->cap) {
+    words->cap = (words->cap == 0) ? 1 << 20 : words->cap * 2;
+    words->text = realloc(words->text, words->cap);
+    if (words->text == NULL) {
+      fprintf(stderr, "out of memory\n");
+      exit(3);
+    }
+  }
+  memcpy(words->text + words->len, word, len);
+  words->text[words->len + len] = '\0';
+  words->len += len + 1;
+  words->count++;
+}
+
+/**************** words_readPages() ****************/
+/* Read the words of page files 1, 2, 3, ... until one is missing,
+ * skipping each file's URL and depth lines.
+ */
+static void
+words_readPages(words_t* words, const char* pageDirectory)
+{
+  char path[4096];
+  char word[256];
+
+  for (int docID = 1; ; docID++) {
+    snprintf(path, sizeof(path), "%s/%d", pageDirectory, docID);
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+      break;
+    }
+
+    int lines = 0;
+    size_t len = 0;
+    int c;
+    while ((c = fgetc(fp)) != EOF) {
+      if (lines < 2) {
+        lines += (c == '\n');
+      } else if (isalpha(c)) {
+        if (len < sizeof(word) - 1) {
+          word[len++] = tolower(c);
+        }
+      } else {
+        if (len >= 3) {
+          words_add(words, word, len);
+        }
+        len = 0;
+      }
+    }
+    if (len >= 3) {
+      words_add(words, word, len);
+    }
+    fclose(fp);
+  }
+}
+
+/**************** words_synthesize() ****************/
+/* Build a deterministic stream in which the word of rank r appears
+ * with probability proportional to 1/r, like words in real text.
+ */
+static void
+words_synthesize(words_t* words)
+{
+  // cumulative weights of ranks 1..SYNTH_VOCAB
+  double* cumulative = malloc(SYNTH_VOCAB * sizeof(double));
+  if (cumulative == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(3);
+  }
+  double total = 0;
+  for (int r = 0; r < SYNTH_VOCAB; r++) {
+    total += 1.0 / (r + 1);
+    cumulative[r] = total;
+  }
+
+  unsigned long seed = 42;
+  char word[16];
+  for (int i = 0; i < SYNTH_WORDS; i++) {
+    seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+    double u = (double)(seed >> 11) / (double)(1UL << 53) * total;
+
+    // binary search for the rank whose cumulative weight covers u
+    int lo = 0;
+    int hi = SYNTH_VOCAB - 1;
+    while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      if (cumulative[mid] < u) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+
+    // spells the rank in letters, with a prefix so every word is >= 3 long
+    int len = 0;
+    word[len++] = 'w';
+    word[len++] = 'd';
+    for (int r = lo; ; r /= 26) {
+      word[len++] = 'a' + r % 26;
+      if (r < 26) {
+        break;
+      }
+    }
+    words_add(words, word, len);
+  }
+  free(cumulative);
+}
+
+/**************** now() ****************/
+/* Return a monotonic time in seconds.
+ */
+static double
+now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**************** count_item() ****************/
+/* Count one item of the table.
+ */
+static void
+count_item(void* arg, const char* key, void* item)
+{
+  (*(size_t*)arg)++;
+}
@@ -13,13 +13,15 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 #include "mem.h"
 
 /**************** file-local global variables ****************/
 // track malloc and free across *all* calls within this program.
-static int nmalloc = 0;         // number of successful malloc calls
-static int nfree = 0;           // number of free calls
-static int nfreenull = 0;       // number of free(NULL) calls
+// atomic, because the indexer and querier allocate from several threads.
+static _Atomic int nmalloc = 0;         // number of successful malloc calls
+static _Atomic int nfree = 0;           // number of free calls
+static _Atomic int nfreenull = 0;       // number of free(NULL) calls
 
 
 /**************** mem_assert ****************/
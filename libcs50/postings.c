@@ -0,0 +1,331 @@
+/*
+ * postings.c - CS50 'postings' module
+ *
+ * see postings.h for more information.
+ *
+ * The pairs live in one array, sorted by docID.  Until a list outgrows
+ * POSTINGS_INLINE pairs, that array is the one inside the structure;
+ * after that it is allocated, and doubles whenever it fills.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "postings.h"
+#include "mem.h"
+
+/**************** file-local constants ****************/
+#define POSTINGS_INLINE 4       // pairs stored inside the structure
+
+/**************** global types ****************/
+typedef struct postings {
+  posting_t* items;           // the pairs: inline, or allocated
+  int size;                   // number of pairs in use
+  int capacity;               // number of pairs items can hold
+  posting_t inline_items[POSTINGS_INLINE];
+} postings_t;
+
+/**************** local functions ****************/
+/* not visible outside this file */
+static int gallop(const posting_t* items, const int size, const int from,
+                  const int docID);
+static bool postings_grow(postings_t* postings, const int n);
+static bool postings_insertAt(postings_t* postings, const int pos,
+                              const int docID, const int count);
+
+/**************** postings_new() ****************/
+/* see postings.h for description */
+postings_t*
+postings_new(void)
+{
+  postings_t* postings = mem_malloc(sizeof(postings_t));
+  if (postings == NULL) {
+    return NULL;              // error allocating postings
+  }
+  postings->items = postings->inline_items;
+  postings->size = 0;
+  postings->capacity = POSTINGS_INLINE;
+  return postings;
+}
+
+/**************** postings_add() ****************/
+/* see postings.h for description */
+bool
+postings_add(postings_t* postings, const int docID, const int count)
+{
+  if (postings == NULL || docID < 0 || count <= 0) {
+    return false;
+  }
+
+  int n = postings->size;
+  if (n > 0 && postings->items[n - 1].docID == docID) {
+    postings->items[n - 1].count += count;    // same document again
+    return true;
+  }
+  if (n == 0 || postings->items[n - 1].docID < docID) {
+    if (n == postings->capacity && !postings_grow(postings, n + 1)) {
+      return false;
+    }
+    postings->items[n].docID = docID;         // append in order
+    postings->items[n].count = count;
+    postings->size++;
+    return true;
+  }
+
+  int pos = gallop(postings->items, n, 0, docID);
+  if (postings->items[pos].docID == docID) {
+    postings->items[pos].count += count;
+    return true;
+  }
+  return postings_insertAt(postings, pos, docID, count);
+}
+
+/**************** postings_set() ****************/
+/* see postings.h for description */
+bool
+postings_set(postings_t* postings, const int docID, const int count)
+{
+  if (postings == NULL || docID < 0 || count <= 0) {
+    return false;
+  }
+
+  int pos = gallop(postings->items, postings->size, 0, docID);
+  if (pos < postings->size && postings->items[pos].docID == docID) {
+    postings->items[pos].count = count;
+    return true;
+  }
+  return postings_insertAt(postings, pos, docID, count);
+}
+
+/**************** postings_get() ****************/
+/* see postings.h for description */
+int
+postings_get(const postings_t* postings, const int docID)
+{
+  if (postings == NULL) {
+    return 0;
+  }
+  int pos = gallop(postings->items, postings->size, 0, docID);
+  if (pos < postings->size && postings->items[pos].docID == docID) {
+    return postings->items[pos].count;
+  }
+  return 0;
+}
+
+/**************** postings_size() ****************/
+/* see postings.h for description */
+int
+postings_size(const postings_t* postings)
+{
+  return (postings == NULL) ? 0 : postings->size;
+}
+
+/**************** postings_items() ****************/
+/* see postings.h for description */
+const posting_t*
+postings_items(const postings_t* postings)
+{
+  return (postings == NULL) ? NULL : postings->items;
+}
+
+/**************** postings_reserve() ****************/
+/* see postings.h for description */
+bool
+postings_reserve(postings_t* postings, const int n)
+{
+  if (postings == NULL) {
+    return false;
+  }
+  return (n <= postings->capacity) || postings_grow(postings, n);
+}
+
+/**************** postings_clear() ****************/
+/* see postings.h for description */
+void
+postings_clear(postings_t* postings)
+{
+  if (postings != NULL) {
+    postings->size = 0;
+  }
+}
+
+/**************** postings_seek() ****************/
+/* see postings.h for description */
+int
+postings_seek(const postings_t* postings, const int from, const int docID)
+{
+  if (postings == NULL) {
+    return 0;
+  }
+  return gallop(postings->items, postings->size, from, docID);
+}
+
+/**************** postings_iterate() ****************/
+/* see postings.h for description */
+void
+postings_iterate(const postings_t* postings, void* arg,
+                 void (*itemfunc)(void* arg, const int docID, const int count))
+{
+  if (postings == NULL || itemfunc == NULL) {
+    return;
+  }
+  for (int i = 0; i < postings->size; i++) {
+    (*itemfunc)(arg, postings->items[i].docID, postings->items[i].count);
+  }
+}
+
+/**************** postings_print() ****************/
+/* see postings.h for description */
+void
+postings_print(const postings_t* postings, FILE* fp)
+{
+  if (fp == NULL) {
+    return;
+  }
+  if (postings == NULL) {
+    fputs("(null)", fp);
+    return;
+  }
+
+  fputc('{', fp);
+  for (int i = 0; i < postings->size; i++) {
+    if (i > 0) {
+      fputc(',', fp);
+    }
+    fprintf(fp, "%d=%d", postings->items[i].docID, postings->items[i].count);
+  }
+  fputc('}', fp);
+}
+
+/**************** postings_delete() ****************/
+/* see postings.h for description */
+void
+postings_delete(postings_t* postings)
+{
+  if (postings == NULL) {
+    return;
+  }
+  if (postings->items != postings->inline_items) {
+    mem_free(postings->items);
+  }
+  mem_free(postings);
+}
+
+/**************** postings_iter_init() ****************/
+/* see postings.h for description */
+void
+postings_iter_init(postings_iter_t* iter, const postings_t* postings)
+{
+  if (iter == NULL) {
+    return;
+  }
+  iter->items = (postings == NULL) ? NULL : postings->items;
+  iter->size = (postings == NULL) ? 0 : postings->size;
+  iter->pos = 0;
+}
+
+/**************** postings_iter_next() ****************/
+/* see postings.h for description */
+bool
+postings_iter_next(postings_iter_t* iter, int* docID, int* count)
+{
+  if (iter == NULL || iter->pos >= iter->size) {
+    return false;
+  }
+  if (docID != NULL) {
+    *docID = iter->items[iter->pos].docID;
+  }
+  if (count != NULL) {
+    *count = iter->items[iter->pos].count;
+  }
+  iter->pos++;
+  return true;
+}
+
+/**************** postings_iter_seek() ****************/
+/* see postings.h for description */
+bool
+postings_iter_seek(postings_iter_t* iter, const int docID)
+{
+  if (iter == NULL) {
+    return false;
+  }
+  iter->pos = gallop(iter->items, iter->size, iter->pos, docID);
+  return iter->pos < iter->size;
+}
+
+/**************** gallop() ****************/
+/* Return the position of the first pair at or after from whose docID
+ * is at least docID, or size if there is none.  Probes from+1, from+2,
+ * from+4, ... until it passes docID, then binary searches the last step.
+ */
+static int
+gallop(const posting_t* items, const int size, const int from, const int docID)
+{
+  if (from >= size || items[from].docID >= docID) {
+    return from;
+  }
+
+  // invariant: items[lo].docID < docID, and hi is past the answer
+  int lo = from;
+  int step = 1;
+  while (lo + step < size && items[lo + step].docID < docID) {
+    lo += step;
+    step *= 2;
+  }
+  int hi = (lo + step < size) ? lo + step : size;
+
+  while (hi - lo > 1) {
+    int mid = lo + (hi - lo) / 2;
+    if (items[mid].docID < docID) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return hi;
+}
+
+/**************** postings_grow() ****************/
+/* Make room for at least n pairs, moving the pairs out of the inline
+ * array if need be.  Returns false if out of memory.
+ */
+static bool
+postings_grow(postings_t* postings, const int n)
+{
+  int capacity = postings->capacity;
+  while (capacity < n) {
+    capacity *= 2;
+  }
+
+  posting_t* items = mem_malloc(capacity * sizeof(posting_t));
+  if (items == NULL) {
+    return false;
+  }
+  memcpy(items, postings->items, postings->size * sizeof(posting_t));
+  if (postings->items != postings->inline_items) {
+    mem_free(postings->items);
+  }
+  postings->items = items;
+  postings->capacity = capacity;
+  return true;
+}
+
+/**************** postings_insertAt() ****************/
+/* Insert a new pair at position pos, shifting the pairs after it.
+ */
+static bool
+postings_insertAt(postings_t* postings, const int pos,
+                  const int docID, const int count)
+{
+  if (postings->size == postings->capacity
+      && !postings_grow(postings, postings->size + 1)) {
+    return false;
+  }
+  memmove(&postings->items[pos + 1], &postings->items[pos],
+          (postings->size - pos) * sizeof(posting_t));
+  postings->items[pos].docID = docID;
+  postings->items[pos].count = count;
+  postings->size++;
+  return true;
+}
@@ -0,0 +1,175 @@
+/*
+ * postings.h - header file for CS50 postings module
+ *
+ * A "postings" list is a set of (docID, count) pairs kept in one
+ * contiguous array, sorted by increasing docID; each docID occurs at most
+ * once.  Unlike counters, it can be traversed in docID order and read in
+ * bulk, and lookups are searches rather than list walks.
+ *
+ * Appending a docID at or past the end of the list is the fast path and
+ * costs amortized O(1); adding a docID in the middle shifts the pairs
+ * after it.  Short lists are stored inside the postings structure
+ * itself, so most words' lists need only one allocation.
+ *
+ * Searches gallop: they probe 1, 2, 4, 8, ... pairs ahead of a starting
+ * position and then binary search the last step, so moving a cursor
+ * forward by d pairs costs O(log d).  That makes intersecting a short
+ * list with a long one cheap.
+ */
+
+#ifndef __POSTINGS_H
+#define __POSTINGS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/**************** global types ****************/
+typedef struct postings postings_t;  // opaque to users of the module
+
+/* One (docID, count) pair, as returned by postings_items. */
+typedef struct posting {
+  int docID;
+  int count;
+} posting_t;
+
+/* A cursor over a postings list, for walking it in docID order.
+ * Its fields are private; use postings_iter_* to move it.
+ * The list must not change while a cursor is in use.
+ */
+typedef struct postings_iter {
+  const posting_t* items;     // the list's pairs
+  int size;                   // the number of pairs
+  int pos;                    // index of the current pair
+} postings_iter_t;
+
+/**************** functions ****************/
+
+/**************** postings_new ****************/
+/* Create a new (empty) postings list.
+ *
+ * We return:
+ *   pointer to a new postings list; NULL if error (out of memory).
+ * Caller is responsible for:
+ *   later calling postings_delete();
+ */
+postings_t* postings_new(void);
+
+/**************** postings_add ****************/
+/* Add count to the counter of docID, adding docID if it is absent.
+ *
+ * Caller provides:
+ *   valid pointer to postings list, docID >= 0, count > 0.
+ * We return:
+ *   true on success; false if any argument is invalid or out of memory.
+ * Note:
+ *   a docID no smaller than the list's last docID is appended (or
+ *   added to the last pair) without searching; others are inserted in
+ *   order, shifting the pairs after them.
+ */
+bool postings_add(postings_t* postings, const int docID, const int count);
+
+/**************** postings_set ****************/
+/* Set the counter of docID to count, adding docID if it is absent.
+ *
+ * Caller provides:
+ *   valid pointer to postings list, docID >= 0, count > 0.
+ * We return:
+ *   true on success; false if any argument is invalid or out of memory.
+ */
+bool postings_set(postings_t* postings, const int docID, const int count);
+
+/**************** postings_get ****************/
+/* Return the counter of docID.
+ *
+ * We return:
+ *   the count for docID; 0 if postings is NULL or docID is absent.
+ */
+int postings_get(const postings_t* postings, const int docID);
+
+/**************** postings_size ****************/
+/* Return the number of pairs in the list; 0 if postings is NULL.
+ */
+int postings_size(const postings_t* postings);
+
+/**************** postings_items ****************/
+/* Return the list's pairs, in increasing docID order, for bulk reading.
+ *
+ * We return:
+ *   an array of postings_size() pairs; NULL if postings is NULL.
+ * Note:
+ *   the array belongs to the list, and moves when the list grows.
+ */
+const posting_t* postings_items(const postings_t* postings);
+
+/**************** postings_reserve ****************/
+/* Make room for the list to hold at least n pairs without reallocating.
+ *
+ * We return:
+ *   true on success; false if postings is NULL or out of memory.
+ */
+bool postings_reserve(postings_t* postings, const int n);
+
+/**************** postings_clear ****************/
+/* Empty the list, keeping its memory for reuse.
+ */
+void postings_clear(postings_t* postings);
+
+/**************** postings_seek ****************/
+/* Gallop forward from position from to the first pair whose docID is
+ * at least docID.
+ *
+ * Caller provides:
+ *   valid pointer to postings list, 0 <= from <= postings_size().
+ * We return:
+ *   the position of that pair; postings_size() if there is none.
+ */
+int postings_seek(const postings_t* postings, const int from, const int docID);
+
+/**************** postings_iterate ****************/
+/* Call itemfunc once for each pair, with (arg, docID, count), in
+ * increasing docID order.
+ *
+ * We do:
+ *   nothing, if postings==NULL or itemfunc==NULL.
+ */
+void postings_iterate(const postings_t* postings, void* arg,
+                      void (*itemfunc)(void* arg,
+                                       const int docID, const int count));
+
+/**************** postings_print ****************/
+/* Print the list as {docID=count,...}; "(null)" if postings is NULL;
+ * nothing if fp is NULL.
+ */
+void postings_print(const postings_t* postings, FILE* fp);
+
+/**************** postings_delete ****************/
+/* Delete the list; we ignore NULL.
+ */
+void postings_delete(postings_t* postings);
+
+/**************** postings_iter_init ****************/
+/* Start a cursor at the first pair of the list (which may be NULL,
+ * meaning an empty list).
+ */
+void postings_iter_init(postings_iter_t* iter, const postings_t* postings);
+
+/**************** postings_iter_next ****************/
+/* Read the cursor's current pair into *docID and *count (either may be
+ * NULL) and advance past it.
+ *
+ * We return:
+ *   true if there was a pair; false if the cursor is at the end.
+ */
+bool postings_iter_next(postings_iter_t* iter, int* docID, int* count);
+
+/**************** postings_iter_seek ****************/
+/* Gallop the cursor forward to the first pair, at or after its current
+ * position, whose docID is at least docID.
+ *
+ * We return:
+ *   true if there is such a pair (postings_iter_next reads it next);
+ *   false if the cursor reached the end.
+ */
+bool postings_iter_seek(postings_iter_t* iter, const int docID);
+
+#endif // __POSTINGS_H
@@ -0,0 +1,401 @@
+/*
+ * queue.c - CS50 'queue' module
+ *
+ * see queue.h for more information.
+ *
+ * This is Dmitry Vyukov's bounded multi-producer, multi-consumer queue:
+ * a ring of cells, each with a sequence number that says whose turn it
+ * is.  Pushes and pops take tickets from two counters, tail and head;
+ * the cell for ticket t is cells[t % capacity], and its sequence is t
+ * when it is free for the push with ticket t, and t + 1 when it holds
+ * that push's item, ready for the pop with ticket t.  The pop then sets
+ * it to t + capacity, freeing it for the next lap.  A thread claims a
+ * ticket (or a run of them, for a batch) with one compare-and-swap, then
+ * fills or empties its cells, so no lock is taken.
+ *
+ * Only waiting takes a lock.  A thread about to wait counts itself in
+ * producersWaiting or consumersWaiting, tries once more under the lock,
+ * and then sleeps on a condition variable; a thread that pushes or pops
+ * checks the count after a full fence, and signals only if someone
+ * waits.  The fences on both sides ensure that either the waiter sees
+ * the change or the changer sees the waiter, so no wakeup is lost.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "queue.h"
+#include "mem.h"
+
+/**************** file-local constants ****************/
+#define CACHE_LINE 64           // bytes per cache line
+#define SPINS 16                // tries before a blocking call waits
+
+/**************** local types ****************/
+typedef struct cell {
+  atomic_size_t seq;            // see above
+  void* item;
+} cell_t;
+
+/**************** global types ****************/
+typedef struct queue {
+  // the two counters that producers and consumers fight over are on
+  // cache lines of their own
+  _Alignas(CACHE_LINE) atomic_size_t tail;  // ticket of the next push
+  _Alignas(CACHE_LINE) atomic_size_t head;  // ticket of the next pop
+  _Alignas(CACHE_LINE) cell_t* cells;       // capacity cells
+  size_t mask;                  // capacity - 1; capacity is a power of two
+  atomic_bool closed;
+  atomic_int producersWaiting;  // threads waiting for room
+  atomic_int consumersWaiting;  // threads waiting for items
+  pthread_mutex_t lock;         // held to wait or to wake waiters
+  pthread_cond_t notFull;
+  pthread_cond_t notEmpty;
+} queue_t;
+
+/**************** local functions ****************/
+/* not visible outside this file */
+static size_t queue_put(queue_t* queue, void* const items[], const size_t count);
+static size_t queue_take(queue_t* queue, void* items[], const size_t max);
+static void queue_wake(queue_t* queue, atomic_int* waiting,
+                       pthread_cond_t* cond, const bool all);
+
+/**************** queue_new() ****************/
+/* see queue.h for description */
+queue_t*
+queue_new(const size_t capacity)
+{
+  if (capacity == 0 || capacity > SIZE_MAX / 2 / sizeof(cell_t)) {
+    return NULL;
+  }
+  size_t size = 2;
+  while (size < capacity) {
+    size *= 2;
+  }
+
+  // aligned_alloc needs a size that is a multiple of the alignment,
+  // which sizeof(queue_t) is
+  queue_t* queue = aligned_alloc(CACHE_LINE, sizeof(queue_t));
+  if (queue == NULL) {
+    return NULL;
+  }
+  queue->cells = mem_malloc(size * sizeof(cell_t));
+  if (queue->cells == NULL) {
+    free(queue);
+    return NULL;
+  }
+  for (size_t i = 0; i < size; i++) {
+    atomic_init(&queue->cells[i].seq, i);
+    queue->cells[i].item = NULL;
+  }
+  queue->mask = size - 1;
+  atomic_init(&queue->tail, 0);
+  atomic_init(&queue->head, 0);
+  atomic_init(&queue->closed, false);
+  atomic_init(&queue->producersWaiting, 0);
+  atomic_init(&queue->consumersWaiting, 0);
+  pthread_mutex_init(&queue->lock, NULL);
+  pthread_cond_init(&queue->notFull, NULL);
+  pthread_cond_init(&queue->notEmpty, NULL);
+  return queue;
+}
+
+/**************** queue_tryPush() ****************/
+/* see queue.h for description */
+bool
+queue_tryPush(queue_t* queue, void* item)
+{
+  return item != NULL && queue_tryPushBatch(queue, &item, 1) == 1;
+}
+
+/**************** queue_push() ****************/
+/* see queue.h for description */
+bool
+queue_push(queue_t* queue, void* item)
+{
+  return item != NULL && queue_pushBatch(queue, &item, 1) == 1;
+}
+
+/**************** queue_tryPop() ****************/
+/* see queue.h for description */
+void*
+queue_tryPop(queue_t* queue)
+{
+  void* item;
+  return (queue_tryPopBatch(queue, &item, 1) == 1) ? item : NULL;
+}
+
+/**************** queue_pop() ****************/
+/* see queue.h for description */
+void*
+queue_pop(queue_t* queue)
+{
+  void* item;
+  return (queue_popBatch(queue, &item, 1) == 1) ? item : NULL;
+}
+
+/**************** queue_tryPushBatch() ****************/
+/* see queue.h for description */
+size_t
+queue_tryPushBatch(queue_t* queue, void* const items[], const size_t count)
+{
+  if (queue == NULL || items == NULL || count == 0
+      || atomic_load(&queue->closed)) {
+    return 0;
+  }
+
+  size_t pushed = queue_put(queue, items, count);
+  if (pushed > 0) {
+    queue_wake(queue, &queue->consumersWaiting, &queue->notEmpty, pushed > 1);
+  }
+  return pushed;
+}
+
+/**************** queue_pushBatch() ****************/
+/* see queue.h for description */
+size_t
+queue_pushBatch(queue_t* queue, void* const items[], const size_t count)
+{
+  if (queue == NULL || items == NULL) {
+    return 0;
+  }
+
+  size_t done = 0;
+  int spins = 0;
+  while (done < count && !atomic_load(&queue->closed)) {
+    size_t pushed = queue_put(queue, items + done, count - done);
+    if (pushed == 0 && ++spins > SPINS) {
+      // the queue stays full: wait for a pop or a close
+      pthread_mutex_lock(&queue->lock);
+      atomic_fetch_add(&queue->producersWaiting, 1);
+      atomic_thread_fence(memory_order_seq_cst);
+      while ((pushed = queue_put(queue, items + done, count - done)) == 0
+             && !atomic_load(&queue->closed)) {
+        pthread_cond_wait(&queue->notFull, &queue->lock);
+      }
+      atomic_fetch_sub(&queue->producersWaiting, 1);
+      pthread_mutex_unlock(&queue->lock);
+    }
+    if (pushed > 0) {
+      queue_wake(queue, &queue->consumersWaiting, &queue->notEmpty, pushed > 1);
+      done += pushed;
+      spins = 0;
+    }
+  }
+  return done;
+}
+
+/**************** queue_tryPopBatch() ****************/
+/* see queue.h for description */
+size_t
+queue_tryPopBatch(queue_t* queue, void* items[], const size_t max)
+{
+  if (queue == NULL || items == NULL || max == 0) {
+    return 0;
+  }
+
+  size_t popped = queue_take(queue, items, max);
+  if (popped > 0) {
+    queue_wake(queue, &queue->producersWaiting, &queue->notFull, popped > 1);
+  }
+  return popped;
+}
+
+/**************** queue_popBatch() ****************/
+/* see queue.h for description */
+size_t
+queue_popBatch(queue_t* queue, void* items[], const size_t max)
+{
+  if (queue == NULL || items == NULL || max == 0) {
+    return 0;
+  }
+
+  size_t popped = 0;
+  for (int spins = 0; popped == 0 && spins < SPINS; spins++) {
+    popped = queue_take(queue, items, max);
+  }
+  if (popped == 0) {
+    // the queue stays empty: wait for a push or a close
+    pthread_mutex_lock(&queue->lock);
+    atomic_fetch_add(&queue->consumersWaiting, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+    while ((popped = queue_take(queue, items, max)) == 0
+           && !atomic_load(&queue->closed)) {
+      pthread_cond_wait(&queue->notEmpty, &queue->lock);
+    }
+    atomic_fetch_sub(&queue->consumersWaiting, 1);
+    pthread_mutex_unlock(&queue->lock);
+  }
+  if (popped > 0) {
+    queue_wake(queue, &queue->producersWaiting, &queue->notFull, popped > 1);
+  }
+  return popped;
+}
+
+/**************** queue_close() ****************/
+/* see queue.h for description */
+void
+queue_close(queue_t* queue)
+{
+  if (queue == NULL) {
+    return;
+  }
+
+  atomic_store(&queue->closed, true);
+  pthread_mutex_lock(&queue->lock);
+  pthread_cond_broadcast(&queue->notFull);
+  pthread_cond_broadcast(&queue->notEmpty);
+  pthread_mutex_unlock(&queue->lock);
+}
+
+/**************** queue_size() ****************/
+/* see queue.h for description */
+size_t
+queue_size(queue_t* queue)
+{
+  if (queue == NULL) {
+    return 0;
+  }
+
+  size_t head = atomic_load(&queue->head);
+  size_t tail = atomic_load(&queue->tail);
+  // a ticket may be claimed but its cell not yet filled or emptied
+  return (tail > head) ? tail - head : 0;
+}
+
+/**************** queue_delete() ****************/
+/* see queue.h for description */
+void
+queue_delete(queue_t* queue, void (*itemdelete)(void* item) )
+{
+  if (queue == NULL) {
+    return;
+  }
+
+  void* item;
+  while (queue_take(queue, &item, 1) == 1) {
+    if (itemdelete != NULL) {
+      (*itemdelete)(item);
+    }
+  }
+  pthread_cond_destroy(&queue->notEmpty);
+  pthread_cond_destroy(&queue->notFull);
+  pthread_mutex_destroy(&queue->lock);
+  mem_free(queue->cells);
+  free(queue);
+}
+
+/**************** queue_put() ****************/
+/* Push up to count items with consecutive tickets, without waiting.
+ * Returns the number pushed, 0 if the queue is full.
+ */
+static size_t
+queue_put(queue_t* queue, void* const items[], const size_t count)
+{
+  size_t pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  size_t n;
+  while (true) {
+    cell_t* cell = &queue->cells[pos & queue->mask];
+    size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+    intptr_t dif = (intptr_t)(seq - pos);
+    if (dif < 0) {
+      return 0;                 // the cell still holds last lap's item
+    }
+    if (dif > 0) {
+      // another producer took this ticket; catch up
+      pos = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+      continue;
+    }
+    // the cells after it that are free too can be claimed with it
+    n = 1;
+    while (n < count) {
+      cell = &queue->cells[(pos + n) & queue->mask];
+      if (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + n) {
+        break;
+      }
+      n++;
+    }
+    if (atomic_compare_exchange_weak_explicit(&queue->tail, &pos, pos + n,
+                                              memory_order_relaxed,
+                                              memory_order_relaxed)) {
+      break;
+    }
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    cell_t* cell = &queue->cells[(pos + i) & queue->mask];
+    cell->item = items[i];
+    atomic_store_explicit(&cell->seq, pos + i + 1, memory_order_release);
+  }
+  return n;
+}
+
+/**************** queue_take() ****************/
+/* Pop up to max items with consecutive tickets, without waiting.
+ * Returns the number popped, 0 if the queue is empty.
+ */
+static size_t
+queue_take(queue_t* queue, void* items[], const size_t max)
+{
+  size_t pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+  size_t n;
+  while (true) {
+    cell_t* cell = &queue->cells[pos & queue->mask];
+    size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+    intptr_t dif = (intptr_t)(seq - (pos + 1));
+    if (dif < 0) {
+      return 0;                 // the cell's item has not been pushed
+    }
+    if (dif > 0) {
+      // another consumer took this ticket; catch up
+      pos = atomic_load_explicit(&queue->head, memory_order_relaxed);
+      continue;
+    }
+    // the cells after it that are ready too can be claimed with it
+    n = 1;
+    while (n < max) {
+      cell = &queue->cells[(pos + n) & queue->mask];
+      if (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + n + 1) {
+        break;
+      }
+      n++;
+    }
+    if (atomic_compare_exchange_weak_explicit(&queue->head, &pos, pos + n,
+                                              memory_order_relaxed,
+                                              memory_order_relaxed)) {
+      break;
+    }
+  }
+
+  for (size_t i = 0; i < n; i++) {
+    cell_t* cell = &queue->cells[(pos + i) & queue->mask];
+    items[i] = cell->item;
+    atomic_store_explicit(&cell->seq, pos + i + queue->mask + 1,
+                          memory_order_release);
+  }
+  return n;
+}
+
+/**************** queue_wake() ****************/
+/* After a push or pop, wake one (or all) of the threads counted in
+ * waiting, if any, by signaling cond.
+ */
+static void
+queue_wake(queue_t* queue, atomic_int* waiting, pthread_cond_t* cond,
+           const bool all)
+{
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load_explicit(waiting, memory_order_relaxed) > 0) {
+    pthread_mutex_lock(&queue->lock);
+    if (all) {
+      pthread_cond_broadcast(cond);
+    } else {
+      pthread_cond_signal(cond);
+    }
+    pthread_mutex_unlock(&queue->lock);
+  }
+}
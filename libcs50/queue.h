@@ -0,0 +1,170 @@
+/*
+ * queue.h - header file for CS50 queue module
+ *
+ * A *queue* is a bounded first-in, first-out queue of items that any
+ * number of threads may push to and pop from at once (multi-producer,
+ * multi-consumer), meant for handing work from one stage of a pipeline
+ * to the next, as from a crawler's fetchers to its parsers.
+ *
+ * The queue is a ring of a fixed number of slots, allocated once; unlike
+ * a bag, pushing an item allocates nothing.  Pushes and pops that need
+ * not wait take no lock.  Each operation comes in a non-blocking form
+ * (queue_tryPush, queue_tryPop), which fails at once if the queue is
+ * full or empty, and a blocking form (queue_push, queue_pop), which
+ * waits; each also has a batch form, which moves many items for the
+ * cost of one.
+ *
+ * Items are pointers and must not be NULL, which signals an empty queue.
+ * Items pushed by one thread are popped in the order it pushed them.
+ *
+ * When producers are done, queue_close lets consumers drain the queue
+ * and then stop: pops of an empty, closed queue return at once.
+ */
+
+#ifndef __QUEUE_H
+#define __QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**************** global types ****************/
+typedef struct queue queue_t;  // opaque to users of the module
+
+/**************** functions ****************/
+
+/**************** queue_new ****************/
+/* Create a new (empty) queue.
+ *
+ * Caller provides:
+ *   capacity, the most items the queue holds (must be > 0; rounded up
+ *   to a power of two, at least 2).
+ * We return:
+ *   pointer to the new queue; return NULL if error.
+ * Caller is responsible for:
+ *   later calling queue_delete, when no other thread is using it.
+ */
+queue_t* queue_new(const size_t capacity);
+
+/**************** queue_tryPush ****************/
+/* Push item onto the queue, if there is room, without waiting.
+ *
+ * Caller provides:
+ *   valid pointer to queue, valid (non-NULL) pointer for item.
+ * We return:
+ *   true if pushed; false if the queue is full or closed, or any
+ *   parameter is NULL.
+ */
+bool queue_tryPush(queue_t* queue, void* item);
+
+/**************** queue_push ****************/
+/* Push item onto the queue, waiting while it is full.
+ *
+ * Caller provides:
+ *   valid pointer to queue, valid (non-NULL) pointer for item.
+ * We return:
+ *   true if pushed; false if the queue is (or becomes) closed, or any
+ *   parameter is NULL.
+ */
+bool queue_push(queue_t* queue, void* item);
+
+/**************** queue_tryPop ****************/
+/* Pop the oldest item from the queue, if any, without waiting.
+ *
+ * Caller provides:
+ *   valid pointer to queue.
+ * We return:
+ *   the item, or NULL if the queue is empty or NULL.
+ */
+void* queue_tryPop(queue_t* queue);
+
+/**************** queue_pop ****************/
+/* Pop the oldest item from the queue, waiting while it is empty.
+ *
+ * Caller provides:
+ *   valid pointer to queue.
+ * We return:
+ *   the item, or NULL once the queue is closed and empty, or if queue
+ *   is NULL.
+ */
+void* queue_pop(queue_t* queue);
+
+/**************** queue_tryPushBatch ****************/
+/* Push as many of items[0..count-1] as there is room for, in order,
+ * without waiting.
+ *
+ * Caller provides:
+ *   valid pointer to queue, array of count valid (non-NULL) items.
+ * We return:
+ *   the number of items pushed, the first ones of the array; 0 if the
+ *   queue is full or closed, or any parameter is NULL.
+ */
+size_t queue_tryPushBatch(queue_t* queue, void* const items[], const size_t count);
+
+/**************** queue_pushBatch ****************/
+/* Push all of items[0..count-1], in order, waiting for room as needed.
+ * Other threads' items may come between them.
+ *
+ * Caller provides:
+ *   valid pointer to queue, array of count valid (non-NULL) items.
+ * We return:
+ *   the number of items pushed: count, or fewer if the queue is (or
+ *   becomes) closed; 0 if any parameter is NULL.
+ */
+size_t queue_pushBatch(queue_t* queue, void* const items[], const size_t count);
+
+/**************** queue_tryPopBatch ****************/
+/* Pop up to max of the oldest items, without waiting.
+ *
+ * Caller provides:
+ *   valid pointer to queue, array with room for max items.
+ * We return:
+ *   the number of items popped into items[0..], oldest first; 0 if the
+ *   queue is empty, or any parameter is NULL.
+ */
+size_t queue_tryPopBatch(queue_t* queue, void* items[], const size_t max);
+
+/**************** queue_popBatch ****************/
+/* Pop up to max of the oldest items, waiting while the queue is empty.
+ *
+ * Caller provides:
+ *   valid pointer to queue, array with room for max items.
+ * We return:
+ *   the number of items popped into items[0..], oldest first, at least
+ *   1; 0 once the queue is closed and empty, or if any parameter is NULL.
+ */
+size_t queue_popBatch(queue_t* queue, void* items[], const size_t max);
+
+/**************** queue_close ****************/
+/* Close the queue: later pushes fail, and pops return what is left and
+ * then stop waiting.  Wakes every waiting thread.
+ *
+ * Caller provides:
+ *   valid pointer to queue (NULL is ignored).
+ * Notes:
+ *   A push that races with queue_close may or may not succeed, and an
+ *   item it pushes may be missed by consumers that have already seen
+ *   the queue empty and closed; so close the queue once the producers
+ *   have finished.
+ */
+void queue_close(queue_t* queue);
+
+/**************** queue_size ****************/
+/* Return the number of items in the queue (0 if queue is NULL).
+ * While other threads push or pop, this is only an estimate.
+ */
+size_t queue_size(queue_t* queue);
+
+/**************** queue_delete ****************/
+/* Delete the queue, calling a delete function on each item left in it.
+ *
+ * Caller provides:
+ *   valid queue pointer, used by no other thread,
+ *   valid pointer to function that handles one item (may be NULL).
+ * We do:
+ *   if queue==NULL, do nothing.
+ *   otherwise, unless itemdelete==NULL, call itemdelete on each item.
+ *   free the queue itself.
+ */
+void queue_delete(queue_t* queue, void (*itemdelete)(void* item) );
+
+#endif // __QUEUE_H
@@ -0,0 +1,243 @@
+/*
+ * queuebench.c - benchmark for the CS50 'queue' module under contention
+ *
+ * Moves numItems items from P producer threads to P consumer threads,
+ * for P = 1, 2, 4, ... up to maxThreads, through:
+ *   bag    - a bag guarded by a mutex, with a condition variable for
+ *            consumers to wait on, as a pipeline would share a bag
+ *            today; it allocates a node for every item,
+ *   queue  - a queue of QUEUE_SIZE items, one queue_push and queue_pop
+ *            per item,
+ *   batch  - the same queue, with queue_pushBatch and queue_popBatch
+ *            of up to BATCH items.
+ * Throughput is in millions of items per second.  Each run checks that
+ * every item arrived exactly once, by count and by sum, and exits
+ * non-zero if not.
+ *
+ * usage: queuebench [maxThreads [numItems]]
+ *   maxThreads defaults to the number of processors; numItems to 2000000.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "queue.h"
+#include "bag.h"
+
+/**************** file-local constants ****************/
+#define ITEMS 2000000           // default number of items
+#define QUEUE_SIZE 1024         // capacity of the queue
+#define BATCH 64                // items per batch
+
+/**************** local types ****************/
+typedef enum kind { BAG, QUEUE, BATCHED } kind_t;
+static const char* kindNames[] = { "bag", "queue", "batch" };
+
+// a bag with a lock, for comparison
+typedef struct lockedbag {
+  bag_t* bag;
+  pthread_mutex_t lock;
+  pthread_cond_t notEmpty;
+  bool closed;
+} lockedbag_t;
+
+// what one thread of a run does
+typedef struct worker {
+  pthread_t thread;
+  kind_t kind;
+  queue_t* queue;
+  lockedbag_t* bag;
+  long first;                   // producers: items first .. last-1
+  long last;
+  long count;                   // consumers: items received
+  uint64_t sum;                 // consumers: sum of items received
+} worker_t;
+
+/**************** local functions ****************/
+static double run(const kind_t kind, const int numThreads, const long numItems);
+static void* produce(void* arg);
+static void* consume(void* arg);
+static double now(void);
+
+int
+main(const int argc, char* argv[])
+{
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  int maxThreads = (argc > 1) ? atoi(argv[1]) : (cpus > 0 ? cpus : 1);
+  long numItems = (argc > 2) ? atol(argv[2]) : ITEMS;
+  if (argc > 3 || maxThreads < 1 || numItems < 1) {
+    fprintf(stderr, "usage: %s [maxThreads [numItems]]\n", argv[0]);
+    return 1;
+  }
+
+  printf("%s: %ld items, up to %d producers and %d consumers on %ld processors\n",
+         argv[0], numItems, maxThreads, maxThreads, cpus);
+  printf("%-7s %9s %10s\n", "kind", "threads", "Mitems/s");
+
+  // 1, 2, 4, ..., and maxThreads itself
+  for (int t = 1; t <= maxThreads;
+       t = (t < maxThreads && 2 * t > maxThreads) ? maxThreads : 2 * t) {
+    for (kind_t kind = BAG; kind <= BATCHED; kind++) {
+      double seconds = run(kind, t, numItems);
+      printf("%-7s %4d+%-4d %10.2f\n", kindNames[kind], t, t,
+             numItems / seconds / 1e6);
+      fflush(stdout);
+    }
+  }
+  return 0;
+}
+
+/**************** run() ****************/
+/* Move numItems items through one kind of hand-off, with numThreads
+ * producers and numThreads consumers; returns the seconds it took.
+ * Exits if any item is lost or repeated.
+ */
+static double
+run(const kind_t kind, const int numThreads, const long numItems)
+{
+  lockedbag_t bag = { bag_new(), PTHREAD_MUTEX_INITIALIZER,
+                      PTHREAD_COND_INITIALIZER, false };
+  queue_t* queue = queue_new(QUEUE_SIZE);
+  worker_t* producers = calloc(numThreads, sizeof(worker_t));
+  worker_t* consumers = calloc(numThreads, sizeof(worker_t));
+  if (bag.bag == NULL || queue == NULL || producers == NULL || consumers == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(2);
+  }
+
+  double start = now();
+  for (int i = 0; i < numThreads; i++) {
+    consumers[i] = (worker_t){ .kind = kind, .queue = queue, .bag = &bag };
+    producers[i] = (worker_t){ .kind = kind, .queue = queue, .bag = &bag,
+                               .first = numItems * i / numThreads,
+                               .last = numItems * (i + 1) / numThreads };
+    if (pthread_create(&consumers[i].thread, NULL, consume, &consumers[i]) != 0
+        || pthread_create(&producers[i].thread, NULL, produce, &producers[i]) != 0) {
+      fprintf(stderr, "cannot start threads\n");
+      exit(2);
+    }
+  }
+  for (int i = 0; i < numThreads; i++) {
+    pthread_join(producers[i].thread, NULL);
+  }
+  // the producers are done: let the consumers drain and stop
+  queue_close(queue);
+  pthread_mutex_lock(&bag.lock);
+  bag.closed = true;
+  pthread_cond_broadcast(&bag.notEmpty);
+  pthread_mutex_unlock(&bag.lock);
+
+  long count = 0;
+  uint64_t sum = 0;
+  for (int i = 0; i < numThreads; i++) {
+    pthread_join(consumers[i].thread, NULL);
+    count += consumers[i].count;
+    sum += consumers[i].sum;
+  }
+  double seconds = now() - start;
+
+  // items are 1 .. numItems
+  if (count != numItems || sum != (uint64_t)numItems * (numItems + 1) / 2) {
+    fprintf(stderr, "%s: %ld items received, expected %ld\n",
+            kindNames[kind], count, numItems);
+    exit(3);
+  }
+
+  free(consumers);
+  free(producers);
+  queue_delete(queue, NULL);
+  bag_delete(bag.bag, NULL);
+  pthread_cond_destroy(&bag.notEmpty);
+  pthread_mutex_destroy(&bag.lock);
+  return seconds;
+}
+
+/**************** produce() ****************/
+/* Push this producer's items, each item i as the pointer value i + 1.
+ */
+static void*
+produce(void* arg)
+{
+  worker_t* me = arg;
+  void* batch[BATCH];
+
+  for (long i = me->first; i < me->last; ) {
+    switch (me->kind) {
+    case BAG:
+      pthread_mutex_lock(&me->bag->lock);
+      bag_insert(me->bag->bag, (void*)(uintptr_t)(i + 1));
+      pthread_cond_signal(&me->bag->notEmpty);
+      pthread_mutex_unlock(&me->bag->lock);
+      i++;
+      break;
+    case QUEUE:
+      queue_push(me->queue, (void*)(uintptr_t)(i + 1));
+      i++;
+      break;
+    case BATCHED: {
+      size_t n = 0;
+      for (; n < BATCH && i < me->last; n++, i++) {
+        batch[n] = (void*)(uintptr_t)(i + 1);
+      }
+      queue_pushBatch(me->queue, batch, n);
+      break;
+    }
+    }
+  }
+  return NULL;
+}
+
+/**************** consume() ****************/
+/* Pop items until the hand-off is closed and empty, counting them.
+ */
+static void*
+consume(void* arg)
+{
+  worker_t* me = arg;
+  void* batch[BATCH];
+
+  while (true) {
+    size_t n = 0;
+    switch (me->kind) {
+    case BAG:
+      pthread_mutex_lock(&me->bag->lock);
+      while ((batch[0] = bag_extract(me->bag->bag)) == NULL && !me->bag->closed) {
+        pthread_cond_wait(&me->bag->notEmpty, &me->bag->lock);
+      }
+      pthread_mutex_unlock(&me->bag->lock);
+      n = (batch[0] != NULL);
+      break;
+    case QUEUE:
+      batch[0] = queue_pop(me->queue);
+      n = (batch[0] != NULL);
+      break;
+    case BATCHED:
+      n = queue_popBatch(me->queue, batch, BATCH);
+      break;
+    }
+    if (n == 0) {
+      return NULL;
+    }
+    for (size_t i = 0; i < n; i++) {
+      me->sum += (uintptr_t)batch[i];
+    }
+    me->count += n;
+  }
+}
+
+/**************** now() ****************/
+/* Return a monotonic time in seconds.
+ */
+static double
+now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
@@ -4,36 +4,312 @@
  * Implements the querier component of the Tiny Search Engine.
  * This program loads the inverted index built by the indexer,
  * reads search queries from stdin, and prints ranked matching documents.
+ *
+ * The index may be split into shards by docID range (indexFilename.0, 
+ * indexFilename.1, ...; see indexer --shards). The shards are loaded 
+ * concurrently, each query is evaluated on every shard in parallel, and 
+ * the shards' ranked results are merged.
+ *
+ * A query word ending in '*', such as comput*, matches every word with 
+ * that prefix; the counts of all matching words are added together.
+ *
+ * Each query is planned on each shard from its words' document 
+ * frequencies before any postings are decoded (see planQuery); --plan 
+ * prints the plans.
+ *
+ * With --top K, only the K best documents are printed. Each shard keeps 
+ * its K best matches in a bounded heap while collecting them; without a
+ * limit, each shard heapifies all its matches. Either way, results are 
+ * popped from the shards' heaps one at a time as they are printed, so 
+ * the first results come out without sorting all of them. Ties in score
+ * go to the lower docID.
+ *
+ * URLs are printed from the document table the indexer saves beside each
+ * index file (indexFilename.docs), which is mapped into memory once; page
+ * files are read only for an index saved without one.
+ *
+ * Ranked results are cached by the query's canonical form (see 
+ * canonicalQuery), within a memory limit set by --cache SIZE. The index
+ * is reloaded, and the cache cleared, when its files change.
+ *
+ * With --socket PATH, the querier serves queries to clients (see 
+ * queryclient.c) over a Unix domain socket instead of reading stdin.
  */
 
 #define _GNU_SOURCE
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdatomic.h>
 #include <string.h>
 #include <ctype.h>
 #include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
 #include "../common/index.h"
 #include "../common/word.h"
 #include "../common/pagedir.h"
+#include "../common/plist.h"
+#include "../common/doctable.h"
+#include "../common/qcache.h"
+#include "../common/workpool.h"
 #include "../libcs50/file.h"
 #include "../libcs50/mem.h"
-#include "../libcs50/counters.h"
-#include "../libcs50/hashtable.h"
+#include "../libcs50/postings.h"
+#include "../libcs50/bitmap.h"
+
+#define CACHE_SIZE (16 << 20)   //default memory limit of the result cache
+#define GALLOP_RATIO 8          //gallop into lists this many times longer
+#define MAX_CLIENTS 16          //default limit on a server's connected clients
+#define PARALLEL_OR 16384       //default postings an or must have to run in parallel
+#define RELOAD_CHECK 1          //seconds between checks for changed index files
+
+//written by stopServer to wake the server's accept loop
+static int stopPipe[2] = { -1, -1 };
+
+//one document in a query's results
+typedef struct result {
+  int docID;
+  int score;
+} result_t;
+
+//one result as printed, and as kept in the result cache
+typedef struct ranked {
+  result_t result;
+  int shard;            //the shard whose document table has its URL
+} ranked_t;
+
+//one loaded index file and its document table
+typedef struct shard {
+  const char* filename;
+  index_t* index;
+  doctable_t* docs;     //NULL if the index has no table
+} shard_t;
+
+//the querier's state: the loaded index, and how queries are answered
+typedef struct querier {
+  const char* pageDir;
+  const char* indexFilename;
+  shard_t* shards;
+  int numShards;
+  unsigned long stamp;  //of the index files when loaded (see indexStamp)
+  unsigned long failedStamp; //of index files that last failed to reload
+  time_t nextCheck;     //when refreshIndex next computes the stamp
+  int top;              //how many results to print, 0 for all
+  qcache_t* cache;      //earlier queries' results, or NULL
+  bool showPlan;        //print each shard's query plan
+  int numThreads;       //queries answered at once (see serve)
+  workpool_t* orPool;   //threads an or may use besides its own, or NULL
+  long parallelOr;      //postings an or needs to use them, 0 for never
+  pthread_rwlock_t indexLock; //read-held by queries, write-held to reload
+  pthread_mutex_t cacheLock;  //held while the cache is used
+  pthread_mutex_t checkLock;  //held while nextCheck is used
+} querier_t;
+
+//queries from a file answered in parallel (see runBatch)
+typedef struct batch {
+  pthread_mutex_t lock;
+  pthread_cond_t answered;  //broadcast when a query is answered
+} batch_t;
+
+//one query handed to a worker thread (see runQuery and runBatchQuery)
+typedef struct query_job {
+  querier_t* querier;
+  char* line;
+  FILE* out;            //where to print the results
+  FILE* err;            //where to print any error
+  batch_t* batch;       //the batch it is part of, or NULL
+  char* output;         //in a batch, what was printed to out and err
+  size_t outputLen;
+  char* errors;
+  size_t errorsLen;
+  double seconds;       //time taken to answer
+  long touched;         //postings decoded to answer
+  bool done;
+} query_job_t;
+
+//a querier serving clients over a socket (see serve)
+typedef struct server {
+  querier_t* querier;
+  workpool_t* pool;           //answers the clients' queries
+  pthread_mutex_t lock;       //held while the fields below change
+  pthread_cond_t idle;        //signaled when a client disconnects
+  int* clients;               //connected clients' sockets, -1 for free
+  int maxClients;
+  int numClients;
+} server_t;
+
+//one connected client, handed to its thread
+typedef struct client {
+  server_t* server;
+  int slot;             //its index in the server's clients
+} client_t;
+
+//one shard's part of a query, evaluated in its own thread
+typedef struct shard_query {
+  index_t* index;       //the shard
+  doctable_t* docs;     //its document table, or NULL
+  char** words;         //the query
+  int wordCount;
+  int top;              //how many results to keep, 0 for all
+  bool showPlan;        //describe the plan in plan
+  workpool_t* orPool;   //threads its or may use besides its own, or NULL
+  long parallelOr;      //postings its or needs to use them, 0 for never
+  char* plan;           //the query plan, if asked for
+  result_t* results;    //matching documents, as a heap with the best first
+  int numResults;
+  int resultCap;        //room in results, which is kept for the next query
+  long touched;         //postings decoded
+} shard_query_t;
+
+//memory a thread reuses from one query to the next
+typedef struct scratch {
+  shard_query_t* queries;   //one per shard
+  int queryCap;
+  pthread_t* threads;       //one per shard, to evaluate them in parallel
+  int threadCap;
+  bool* threaded;
+  int threadedCap;
+  ranked_t* ranked;         //the query's ranked results
+  int rankedCap;
+  long touched;             //postings the last query decoded
+} scratch_t;
+
+//one word of a query plan
+typedef struct plan_term {
+  const char* word;
+  int df;               //its postings in the index (for a prefix, the sum
+                        //over the words with that prefix)
+  int position;         //where it is in the query, to break ties
+  bool gallop;          //intersect by galloping instead of merging
+} plan_term_t;
+
+//one and-sequence of a query plan
+typedef struct plan_clause {
+  plan_term_t* terms;   //in the order they are intersected
+  int numTerms;
+  int estimate;         //most documents it can match: its smallest df
+  long cost;            //postings it decodes at most: the sum of its dfs
+  long touched;         //postings it decoded when evaluated
+} plan_clause_t;
+
+//how a query is evaluated on one index
+typedef struct plan {
+  plan_clause_t* clauses;   //in the order they are evaluated
+  int numClauses;
+} plan_t;
+
+//a word's or subquery's matching documents: a postings list, or for
+//words in many documents a compressed bitmap; exactly one is non-NULL
+typedef struct matches {
+  postings_t* postings;
+  bitmap_t* bitmap;
+} matches_t;
+
+//holds what the postings helpers need while decoding a word
+typedef struct postings_args {
+  index_t* index;
+  matches_t matches;      //list or bitmap being decoded into
+  matches_t* lists;       //one per word matching a prefix
+  int numLists;
+  int listCap;
+} postings_args_t;
+
+//an or whose and-sequences are evaluated in parallel (see evaluateOr)
+typedef struct or_args {
+  plan_t* plan;
+  index_t* index;
+  matches_t* results;   //each sequence's matches, then unions of them
+  int step;             //in a round of unions, the distance between pairs
+  void (*task)(struct or_args* args, const int t);
+  int numTasks;
+  atomic_int nextTask;  //the next task a thread takes
+  int helpers;          //pool tasks of runTasks not yet finished
+  pthread_mutex_t lock; //held while helpers is used
+  pthread_cond_t done;  //signaled when helpers reaches 0
+} or_args_t;
 
 //function prototypes
 static void prompt(void);
-static void processQuery(char* line, index_t* index, const char* pageDir);
-static bool validateQuery(char** words, const int wordCount);
-static char** parseWords(char* line, int* wordCount);
+static char** shardFilenames(const char* indexFilename, int* numShards);
+static shard_t* openIndex(const char* indexFilename, int* numShards);
+static shard_t* loadShards(char** filenames, const int numShards);
+static void* loadShard(void* arg);
+static void freeShards(shard_t* shards, const int numShards);
+static unsigned long indexStamp(const char* indexFilename);
+static size_t parseSize(const char* arg);
+static void refreshIndex(querier_t* querier);
+static void processQuery(char* line, querier_t* querier, scratch_t* scratch,
+                         FILE* out, FILE* err);
+static void answerQuery(char** words, const int wordCount, querier_t* querier,
+                        scratch_t* scratch, FILE* out);
+static int findCached(querier_t* querier, const char* key, scratch_t* scratch);
+static void runQuery(void* arg, void* scratch);
+static int runBatch(querier_t* querier, const char* batchFile);
+static void runBatchQuery(void* arg, void* scratch);
+static int doubleCmp(const void* a, const void* b);
+static double percentile(const double* sorted, const int n, const int p);
+static void* newScratch(void);
+static void freeScratch(void* arg);
+static bool reserve(void** array, int* capacity, const int needed, const size_t size);
+static int serve(querier_t* querier, const char* socketPath, const int maxClients);
+static int listenOn(const char* socketPath);
+static void* serveClient(void* arg);
+static void stopServer(int signum);
+static char* canonicalQuery(char** words, const int wordCount);
+static int stringCmp(const void* a, const void* b);
+static void* evaluateShard(void* arg);
+static void collectResults_helper(void* arg, const int docID, const int count);
+static int resultCmp(const void* a, const void* b);
+static void heapify(result_t* heap, const int n, const bool worstFirst);
+static void siftDown(result_t* heap, const int n, int i, const bool worstFirst);
+static bool heapPop(result_t* heap, int* n, result_t* top);
+static bool validateQuery(char** words, const int wordCount, FILE* err);
+static char** parseWords(char* line, int* wordCount, FILE* err);
 static void normalizeWords(char** words, int wordCount);
 static void freeWords(char** words, int wordCount);
-static counters_t* evaluateQuery(char** words, int wordCount, index_t* index);
-static counters_t* intersectCounters(counters_t* a, counters_t* b);
-static counters_t* unionCounters(counters_t* a, counters_t* b);
-static void rankAndPrint(counters_t* result, const char* pageDir);
-static counters_t* counters_copy(counters_t* source);
-static int counters_nonzero(counters_t* ctrs);
+static plan_t* planQuery(char** words, const int wordCount, index_t* index);
+static int wordFrequency(index_t* index, const char* word);
+static void prefixFrequency_helper(void* arg, const char* word, plist_t* postings);
+static int termCmp(const void* a, const void* b);
+static int clauseCmp(const void* a, const void* b);
+static matches_t evaluatePlan(plan_t* plan, index_t* index,
+                              workpool_t* orPool, const long parallelOr);
+static matches_t evaluateClause(plan_clause_t* clause, index_t* index);
+static matches_t evaluateOr(plan_t* plan, index_t* index,
+                            const int numClauses, workpool_t* pool);
+static void runTasks(or_args_t* args, void (*task)(or_args_t* args, const int t),
+                     const int numTasks, workpool_t* pool);
+static void runTasks_thread(or_args_t* args);
+static void runTasks_helper(void* arg, void* scratch);
+static void evaluateClause_task(or_args_t* args, const int t);
+static void unionPair_task(or_args_t* args, const int t);
+static char* describePlan(const plan_t* plan);
+static void freePlan(plan_t* plan);
+static matches_t intersectMatches(matches_t a, matches_t b, const bool gallop);
+static matches_t unionMatches(matches_t a, matches_t b);
+static int matchesSize(matches_t matches);
+static postings_t* intersectPostings(postings_t* a, postings_t* b, const bool gallop);
+static postings_t* unionPostings(postings_t* a, postings_t* b);
+static void iterateMatches(matches_t matches, void* arg,
+                           void (*itemfunc)(void* arg, const int docID, const int count));
+static void deleteMatches(matches_t matches);
+static int rankResults(shard_query_t* queries, const int numShards,
+                       const int top, scratch_t* scratch);
+static void printRanked(const ranked_t* ranked, const int numRanked,
+                        shard_t* shards, const char* pageDir, FILE* out);
+static void printResult(const result_t* result, doctable_t* docs,
+                        const char* pageDir, FILE* out);
+static matches_t wordToMatches(index_t* index, const char* word);
+static void decodeWord(postings_args_t* args, plist_t* postings);
+static void prefixToMatches_helper(void* arg, const char* word, plist_t* postings);
+static void addPosting_helper(void* arg, const int docID, const int count);
 
 /*
  * Validates command-line arguments, loads index from file, enters a loop 
@@ -46,29 +322,127 @@ static int counters_nonzero(counters_t* ctrs);
  *   0 on normal completion, non-zero exit code on error
  */
 int main(const int argc, char* argv[]) {
-  if (argc != 3) {
-    fprintf(stderr, "Usage: ./querier pageDirectory indexFilename\n");
+  //reads options, which come before the positional arguments
+  int top = 0;
+  size_t cacheSize = CACHE_SIZE;
+  bool cacheStats = false;
+  bool showPlan = false;
+  const char* socketPath = NULL;
+  const char* batchFile = NULL;
+  int maxClients = MAX_CLIENTS;
+  int numThreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  int orThreads = 0;     //0 for the default, set below
+  long parallelOr = PARALLEL_OR;
+  int arg = 1;
+  while (arg < argc && strncmp(argv[arg], "--", 2) == 0) {
+    if (strcmp(argv[arg], "--top") == 0 && arg + 1 < argc) {
+      char excess;
+      if (sscanf(argv[++arg], "%d%c", &top, &excess) != 1 || top < 1) {
+        fprintf(stderr, "Invalid number of results: %s\n", argv[arg]);
+        exit(1);
+      }
+    } else if (strcmp(argv[arg], "--cache") == 0 && arg + 1 < argc) {
+      arg++;
+      cacheSize = (strcmp(argv[arg], "0") == 0) ? 0 : parseSize(argv[arg]);
+      if (cacheSize == 0 && strcmp(argv[arg], "0") != 0) {
+        fprintf(stderr, "Invalid cache size: %s\n", argv[arg]);
+        exit(1);
+      }
+    } else if (strcmp(argv[arg], "--cache-stats") == 0) {
+      cacheStats = true;
+    } else if (strcmp(argv[arg], "--plan") == 0) {
+      showPlan = true;
+    } else if (strcmp(argv[arg], "--socket") == 0 && arg + 1 < argc) {
+      socketPath = argv[++arg];
+    } else if (strcmp(argv[arg], "--batch") == 0 && arg + 1 < argc) {
+      batchFile = argv[++arg];
+    } else if (strcmp(argv[arg], "--threads") == 0 && arg + 1 < argc) {
+      char excess;
+      if (sscanf(argv[++arg], "%d%c", &numThreads, &excess) != 1 || numThreads < 1) {
+        fprintf(stderr, "Invalid number of threads: %s\n", argv[arg]);
+        exit(1);
+      }
+    } else if (strcmp(argv[arg], "--or-threads") == 0 && arg + 1 < argc) {
+      char excess;
+      if (sscanf(argv[++arg], "%d%c", &orThreads, &excess) != 1 || orThreads < 1) {
+        fprintf(stderr, "Invalid number of threads: %s\n", argv[arg]);
+        exit(1);
+      }
+    } else if (strcmp(argv[arg], "--parallel-or") == 0 && arg + 1 < argc) {
+      char excess;
+      if (sscanf(argv[++arg], "%ld%c", &parallelOr, &excess) != 1 || parallelOr < 0) {
+        fprintf(stderr, "Invalid number of postings: %s\n", argv[arg]);
+        exit(1);
+      }
+    } else if (strcmp(argv[arg], "--max-clients") == 0 && arg + 1 < argc) {
+      char excess;
+      if (sscanf(argv[++arg], "%d%c", &maxClients, &excess) != 1 || maxClients < 1) {
+        fprintf(stderr, "Invalid number of clients: %s\n", argv[arg]);
+        exit(1);
+      }
+    } else {
+      fprintf(stderr, "Unknown option: %s\n", argv[arg]);
+      exit(1);
+    }
+    arg++;
+  }
+
+  if (argc - arg != 2 || (socketPath != NULL && batchFile != NULL)) {
+    fprintf(stderr, "Usage: ./querier [--top K] [--cache SIZE] [--cache-stats] "
+                    "[--plan] [--or-threads N] [--parallel-or POSTINGS] "
+                    "[--socket PATH [--max-clients N] | --batch FILE] [--threads N] "
+                    "pageDirectory indexFilename\n");
     exit(1);
   }
 
-  const char* pageDirectory = argv[1];
-  const char* indexFilename = argv[2];
+  //a server or a batch answers queries in parallel; stdin's are answered
+  //in turn
+  bool parallel = (socketPath != NULL || batchFile != NULL);
+  if (!parallel || numThreads < 1) {
+    numThreads = 1;
+  }
+  //by default, queries answered at once share the processors among 
+  //their ors, so there are about as many threads as processors
+  if (orThreads == 0) {
+    int perQuery = (int)sysconf(_SC_NPROCESSORS_ONLN) / numThreads;
+    orThreads = (perQuery > 1) ? perQuery : 1;
+  }
+  querier_t querier = { argv[arg], argv[arg + 1], NULL, 0, 0, 0, 0, top, NULL,
+                        showPlan, numThreads, NULL, parallelOr,
+                        PTHREAD_RWLOCK_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+                        PTHREAD_MUTEX_INITIALIZER };
+  //an or's caller works too, so the pool has one thread fewer
+  querier.orPool = (orThreads > 1) ? workpool_new(orThreads - 1, NULL, NULL) : NULL;
 
-  if (!pagedir_validate(pageDirectory)) {
-    fprintf(stderr, "Error: '%s' is not a valid crawler directory.\n", pageDirectory);
+  if (!pagedir_validate(querier.pageDir)) {
+    fprintf(stderr, "Error: '%s' is not a valid crawler directory.\n", querier.pageDir);
     exit(2);
   }
 
-  index_t* index = index_load(indexFilename);
-  if (index == NULL) {
-    fprintf(stderr, "Error: could not load index file '%s'\n", indexFilename);
+  struct timespec loaded;
+  clock_gettime(CLOCK_MONOTONIC, &loaded);
+  querier.nextCheck = loaded.tv_sec + RELOAD_CHECK;
+  querier.stamp = indexStamp(querier.indexFilename);
+  querier.shards = openIndex(querier.indexFilename, &querier.numShards);
+  if (querier.shards == NULL) {
+    fprintf(stderr, "Error: could not load index file '%s'\n", querier.indexFilename);
     exit(3);
   }
+  querier.cache = (cacheSize > 0) ? qcache_new(cacheSize) : NULL;
+
+  //as a server, answers clients' queries until stopped by a signal
+  int status = 0;
+  if (socketPath != NULL) {
+    status = serve(&querier, socketPath, maxClients);
+  } else if (batchFile != NULL) {
+    status = runBatch(&querier, batchFile);
+  }
 
   char* line = NULL;
   size_t len = 0;
+  scratch_t* scratch = parallel ? NULL : newScratch();
 
-  while (true) {
+  while (!parallel && scratch != NULL) {
     prompt();
 
     ssize_t nread = getline(&line, &len, stdin);
@@ -80,14 +454,501 @@ int main(const int argc, char* argv[]) {
       line[nread - 1] = '\0';
     }
 
-    processQuery(line, index, pageDirectory);
+    refreshIndex(&querier);
+    processQuery(line, &querier, scratch, stdout, stderr);
+  }
+
+  if (cacheStats) {
+    qcache_stats_t stats = qcache_stats(querier.cache);
+    fprintf(stderr, "Cache: %ld hits, %ld misses, %ld evictions, %ld invalidations, "
+                    "%d entries, %zu bytes\n", stats.hits, stats.misses,
+            stats.evictions, stats.invalidations, stats.entries, stats.bytes);
   }
 
   free(line);
-  index_delete(index);
+  freeScratch(scratch);
+  qcache_delete(querier.cache);
+  freeShards(querier.shards, querier.numShards);
+  workpool_delete(querier.orPool);
+  return status;
+}
+
+
+/*
+ * Finds the index files to load: indexFilename itself if it exists,
+ * otherwise the shards indexFilename.0, indexFilename.1, ... 
+ *
+ * Caller provides:
+ *   indexFilename - path given on the command line
+ *   numShards - where to store the number of files found
+ * Return:
+ *   array of allocated file names (empty if none exist)
+ */
+static char** shardFilenames(const char* indexFilename, int* numShards) {
+  char** filenames = malloc(sizeof(char*));
+  *numShards = 0;
+  if (filenames == NULL) {
+    return NULL;
+  }
+
+  if (access(indexFilename, F_OK) == 0) {
+    filenames[(*numShards)++] = strdup(indexFilename);
+    return filenames;
+  }
+
+  char* path;
+  while (asprintf(&path, "%s.%d", indexFilename, *numShards) != -1) {
+    if (access(path, F_OK) != 0) {
+      free(path);
+      break;
+    }
+    char** bigger = realloc(filenames, (*numShards + 1) * sizeof(char*));
+    if (bigger == NULL) {
+      free(path);
+      break;
+    }
+    filenames = bigger;
+    filenames[(*numShards)++] = path;
+  }
+  return filenames;
+}
+
+/*
+ * Finds and loads the index files for indexFilename
+ *
+ * Caller provides:
+ *   indexFilename - path given on the command line
+ *   numShards - where to store the number of shards loaded
+ * Return:
+ *   array of loaded shards, or NULL if there are none or any fails
+ */
+static shard_t* openIndex(const char* indexFilename, int* numShards) {
+  char** filenames = shardFilenames(indexFilename, numShards);
+  shard_t* shards = loadShards(filenames, *numShards);
+  for (int i = 0; i < *numShards; i++) {
+    free(filenames[i]);
+    if (shards != NULL) {
+      shards[i].filename = NULL;    //freed here; only loadShard needs it
+    }
+  }
+  free(filenames);
+  return shards;
+}
+
+/*
+ * Loads every shard, with its document table, each in its own thread
+ *
+ * Caller provides:
+ *   filenames - index files to load
+ *   numShards - number of files
+ * Return:
+ *   array of loaded shards, or NULL if there are none or any index fails
+ *   (a missing document table is not a failure)
+ */
+static shard_t* loadShards(char** filenames, const int numShards) {
+  if (filenames == NULL || numShards == 0) {
+    return NULL;
+  }
+
+  shard_t* shards = calloc(numShards, sizeof(shard_t));
+  pthread_t* threads = calloc(numShards, sizeof(pthread_t));
+  bool* started = calloc(numShards, sizeof(bool));
+  bool ok = (shards != NULL && threads != NULL && started != NULL);
+
+  for (int i = 0; ok && i < numShards; i++) {
+    shards[i].filename = filenames[i];
+    started[i] = (pthread_create(&threads[i], NULL, loadShard, &shards[i]) == 0);
+    ok = started[i];
+  }
+  for (int i = 0; started != NULL && i < numShards; i++) {
+    if (started[i]) {
+      pthread_join(threads[i], NULL);
+      ok = ok && (shards[i].index != NULL);
+    }
+  }
+
+  if (!ok && shards != NULL) {
+    freeShards(shards, numShards);
+    shards = NULL;
+  }
+  free(threads);
+  free(started);
+  return shards;
+}
+
+/* 
+ * HELPER FUNCTION
+ * Thread body that loads one index file and maps its document table,
+ * filling in the shard_t
+ */
+static void* loadShard(void* arg) {
+  shard_t* shard = arg;
+  shard->index = index_load(shard->filename);
+
+  char* docsFile;
+  if (asprintf(&docsFile, "%s.docs", shard->filename) != -1) {
+    shard->docs = doctable_load(docsFile);
+    free(docsFile);
+  }
+  return NULL;
+}
+
+
+/*
+ * Frees every shard's index and document table, and the array
+ */
+static void freeShards(shard_t* shards, const int numShards) {
+  for (int i = 0; i < numShards; i++) {
+    index_delete(shards[i].index);
+    doctable_delete(shards[i].docs);
+  }
+  free(shards);
+}
+
+/*
+ * Computes a stamp of the index files for indexFilename (each shard, its
+ * tombstones, and its document table) from their sizes, inode numbers,
+ * and modification times. The indexer and indexremove replace or rewrite
+ * these files, so the stamp changes whenever they change the index.
+ *
+ * Return:
+ *   the stamp, which is only compared with other stamps
+ */
+static unsigned long indexStamp(const char* indexFilename) {
+  int numFiles = 0;
+  char** filenames = shardFilenames(indexFilename, &numFiles);
+  unsigned long stamp = numFiles;
+  const char* suffixes[] = { "", ".deleted", ".docs" };
+
+  for (int i = 0; i < numFiles; i++) {
+    for (int s = 0; s < 3; s++) {
+      char* path;
+      struct stat st;
+      if (asprintf(&path, "%s%s", filenames[i], suffixes[s]) == -1) {
+        continue;
+      }
+      if (stat(path, &st) == 0) {
+        unsigned long parts[] = { st.st_size, st.st_ino, st.st_mtim.tv_sec,
+                                  st.st_mtim.tv_nsec };
+        for (int p = 0; p < 4; p++) {
+          stamp = stamp * 1000003 + parts[p];
+        }
+      }
+      stamp = stamp * 31 + s;
+      free(path);
+    }
+    free(filenames[i]);
+  }
+  free(filenames);
+  return stamp;
+}
+
+/*
+ * Reloads the index if the indexer or indexremove has changed its files
+ * since it was loaded, which also makes every cached result stale; if
+ * the new files cannot be loaded, keeps the old index. The reload waits
+ * for queries in progress to finish.
+ *
+ * Notes:
+ *   The files are stat'ed at most once every RELOAD_CHECK seconds, not 
+ *   on every query. Files that fail to load are not tried again until 
+ *   their stamp changes, as when the indexer finishes writing them.
+ */
+static void refreshIndex(querier_t* querier) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  pthread_mutex_lock(&querier->checkLock);
+  bool due = (now.tv_sec >= querier->nextCheck);
+  if (due) {
+    querier->nextCheck = now.tv_sec + RELOAD_CHECK;
+  }
+  pthread_mutex_unlock(&querier->checkLock);
+  if (!due) {
+    return;
+  }
+
+  unsigned long stamp = indexStamp(querier->indexFilename);
+  pthread_rwlock_rdlock(&querier->indexLock);
+  bool current = (stamp == querier->stamp || stamp == querier->failedStamp);
+  pthread_rwlock_unlock(&querier->indexLock);
+  if (current) {
+    return;
+  }
+
+  pthread_rwlock_wrlock(&querier->indexLock);
+  if (stamp != querier->stamp && stamp != querier->failedStamp) {
+    int numShards = 0;
+    shard_t* shards = openIndex(querier->indexFilename, &numShards);
+    if (shards == NULL) {
+      fprintf(stderr, "Warning: could not reload index file '%s'\n", querier->indexFilename);
+      querier->failedStamp = stamp;
+    } else {
+      freeShards(querier->shards, querier->numShards);
+      querier->shards = shards;
+      querier->numShards = numShards;
+      querier->stamp = stamp;
+      pthread_mutex_lock(&querier->cacheLock);
+      qcache_clear(querier->cache);
+      pthread_mutex_unlock(&querier->cacheLock);
+    }
+  }
+  pthread_rwlock_unlock(&querier->indexLock);
+}
+
+/*
+ * Serves queries over a Unix domain socket until SIGINT or SIGTERM, so 
+ * the index is loaded once for any number of clients (see queryclient).
+ * Each client sends one query per line; the reply is what the querier
+ * would print for it, errors included, followed by an empty line. Each
+ * client has its own thread, which hands its queries to a pool of 
+ * querier->numThreads workers, so independent queries are answered in 
+ * parallel against the same read-only index. A client beyond the limit 
+ * is sent an error and disconnected. To stop, the server stops 
+ * accepting, lets every client finish the query it is on, and removes 
+ * the socket.
+ *
+ * Caller provides:
+ *   querier - the loaded index and the options for answering
+ *   socketPath - where to create the socket
+ *   maxClients - most clients connected at once
+ * Return:
+ *   0 once stopped, 4 if the socket could not be created
+ */
+static int serve(querier_t* querier, const char* socketPath, const int maxClients) {
+  server_t server = { querier, NULL, PTHREAD_MUTEX_INITIALIZER,
+                      PTHREAD_COND_INITIALIZER, NULL, maxClients, 0 };
+  server.clients = malloc(maxClients * sizeof(int));
+  server.pool = workpool_new(querier->numThreads, newScratch, freeScratch);
+  if (server.clients == NULL || server.pool == NULL || pipe(stopPipe) == -1) {
+    free(server.clients);
+    workpool_delete(server.pool);
+    return 4;
+  }
+  for (int i = 0; i < maxClients; i++) {
+    server.clients[i] = -1;
+  }
+
+  int listener = listenOn(socketPath);
+  if (listener == -1) {
+    fprintf(stderr, "Error: could not listen on '%s'\n", socketPath);
+    close(stopPipe[0]);
+    close(stopPipe[1]);
+    free(server.clients);
+    workpool_delete(server.pool);
+    return 4;
+  }
+
+  //a client that disconnects mid-reply must not kill the server
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = SIG_IGN;
+  sigaction(SIGPIPE, &action, NULL);
+  action.sa_handler = stopServer;
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  fprintf(stderr, "Serving on %s\n", socketPath);
+
+  struct pollfd fds[2] = { { listener, POLLIN, 0 }, { stopPipe[0], POLLIN, 0 } };
+  while (true) {
+    if (poll(fds, 2, -1) == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    if (fds[1].revents != 0) {
+      break;
+    }
+    if ((fds[0].revents & POLLIN) == 0) {
+      continue;
+    }
+    int fd = accept(listener, NULL, NULL);
+    if (fd == -1) {
+      continue;
+    }
+
+    //takes a free slot, or turns the client away
+    pthread_mutex_lock(&server.lock);
+    int slot = 0;
+    while (slot < maxClients && server.clients[slot] != -1) {
+      slot++;
+    }
+    if (slot < maxClients) {
+      server.clients[slot] = fd;
+      server.numClients++;
+    }
+    pthread_mutex_unlock(&server.lock);
+    if (slot == maxClients) {
+      const char* busy = "Error: too many connections\n";
+      if (write(fd, busy, strlen(busy)) == -1) {
+        //the client is gone already
+      }
+      close(fd);
+      continue;
+    }
+
+    client_t* client = malloc(sizeof(client_t));
+    pthread_t thread;
+    if (client != NULL) {
+      client->server = &server;
+      client->slot = slot;
+    }
+    if (client == NULL || pthread_create(&thread, NULL, serveClient, client) != 0) {
+      free(client);
+      pthread_mutex_lock(&server.lock);
+      server.clients[slot] = -1;
+      server.numClients--;
+      pthread_mutex_unlock(&server.lock);
+      close(fd);
+      continue;
+    }
+    pthread_detach(thread);
+  }
+
+  //stops accepting, then ends every client's input so each thread exits
+  //once its current reply is sent
+  fprintf(stderr, "Shutting down\n");
+  close(listener);
+  unlink(socketPath);
+  pthread_mutex_lock(&server.lock);
+  for (int i = 0; i < maxClients; i++) {
+    if (server.clients[i] != -1) {
+      shutdown(server.clients[i], SHUT_RD);
+    }
+  }
+  while (server.numClients > 0) {
+    pthread_cond_wait(&server.idle, &server.lock);
+  }
+  pthread_mutex_unlock(&server.lock);
+
+  close(stopPipe[0]);
+  close(stopPipe[1]);
+  free(server.clients);
+  workpool_delete(server.pool);
   return 0;
 }
 
+/*
+ * HELPER FUNCTION
+ * Creates a Unix domain socket at socketPath, replacing a stale one, and
+ * listens on it
+ *
+ * Return:
+ *   the listening socket, or -1 on error
+ */
+static int listenOn(const char* socketPath) {
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (strlen(socketPath) >= sizeof(address.sun_path)) {
+    return -1;
+  }
+  strcpy(address.sun_path, socketPath);
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener == -1) {
+    return -1;
+  }
+  unlink(socketPath);
+  if (bind(listener, (struct sockaddr*)&address, sizeof(address)) == -1
+      || listen(listener, SOMAXCONN) == -1) {
+    close(listener);
+    return -1;
+  }
+  return listener;
+}
+
+/*
+ * HELPER FUNCTION
+ * Thread that answers one client's queries until it disconnects or the
+ * server stops, then frees the client's slot
+ */
+static void* serveClient(void* arg) {
+  client_t* client = arg;
+  server_t* server = client->server;
+  int fd = server->clients[client->slot];
+
+  //reads and writes through separate streams on the same socket
+  FILE* in = fdopen(fd, "r");
+  int outFd = (in != NULL) ? dup(fd) : -1;
+  FILE* out = (outFd != -1) ? fdopen(outFd, "w") : NULL;
+
+  char* line = NULL;
+  size_t len = 0;
+  ssize_t nread;
+  while (out != NULL && (nread = getline(&line, &len, in)) != -1) {
+    while (nread > 0 && (line[nread - 1] == '\n' || line[nread - 1] == '\r')) {
+      line[--nread] = '\0';
+    }
+
+    query_job_t job = { server->querier, line, out, out };
+    workpool_run(server->pool, runQuery, &job);
+
+    fputc('\n', out);
+    if (fflush(out) == EOF) {
+      break;
+    }
+  }
+  free(line);
+
+  pthread_mutex_lock(&server->lock);
+  if (out != NULL) {
+    fclose(out);
+  } else if (outFd != -1) {
+    close(outFd);
+  }
+  if (in != NULL) {
+    fclose(in);
+  } else {
+    close(fd);
+  }
+  server->clients[client->slot] = -1;
+  server->numClients--;
+  pthread_cond_signal(&server->idle);
+  pthread_mutex_unlock(&server->lock);
+
+  free(client);
+  return NULL;
+}
+
+/*
+ * HELPER FUNCTION
+ * Signal handler that wakes the server's accept loop to stop it
+ */
+static void stopServer(int signum) {
+  int saved = errno;
+  if (write(stopPipe[1], "", 1) == -1) {
+    //the loop is already being woken
+  }
+  errno = saved;
+}
+
+/* 
+ * Parses a size such as 4096, 64K, 512M, or 2G into a number of bytes
+ *
+ * Caller provides:
+ *   arg - the size string
+ * Return:
+ *   the size in bytes, or 0 if arg is not a valid positive size
+ */
+static size_t parseSize(const char* arg) {
+  char* end;
+  unsigned long long size = strtoull(arg, &end, 10);
+  if (end == arg || arg[0] == '-') {
+    return 0;
+  }
+
+  switch (*end) {
+    case 'G': case 'g': size <<= 10; //falls through
+    case 'M': case 'm': size <<= 10; //falls through
+    case 'K': case 'k': size <<= 10; end++; break;
+    default: break;
+  }
+  if (*end != '\0') {
+    return 0;
+  }
+  return (size_t)size;
+}
 
 /* 
  * Prints a prompt only if stdin is coming from a terminal
@@ -100,137 +961,640 @@ static void prompt(void) {
 }
 
 /* 
- * Creates a copy of a counters object
+ * Decodes a query word's compressed postings into new matches, leaving 
+ * out documents that have been removed from the index. A word found in 
+ * many documents (see plist_isDense) is decoded into a bitmap, others 
+ * into a postings list. A word ending in '*' is a prefix; each word in 
+ * the index's range of words with that prefix is decoded on its own, and
+ * the results are then unioned pairwise, so the counts of all the words 
+ * are added together.
  * 
  * Caller provides:
- *   source - the counters object to copy
+ *   index - the index to look the word up in
+ *   word - the query word
  * Return:
- *   new counters object
+ *   new matches (empty if nothing matches)
+ */
+static matches_t wordToMatches(index_t* index, const char* word) {
+  postings_args_t args = { index, { NULL, NULL }, NULL, 0, 0 };
+  size_t len = strlen(word);
+
+  if (len == 0 || word[len - 1] != '*') {
+    decodeWord(&args, index_find(index, word));
+    return args.matches;
+  }
+
+  char* prefix = strndup(word, len - 1);
+  if (prefix != NULL) {
+    index_prefix(index, prefix, &args, prefixToMatches_helper);
+    free(prefix);
+  }
+
+  //merges neighbouring lists in rounds, halving their number each time
+  while (args.numLists > 1) {
+    int merged = 0;
+    for (int i = 0; i < args.numLists; i += 2) {
+      if (i + 1 == args.numLists) {
+        args.lists[merged++] = args.lists[i];
+      } else {
+        matches_t pair = unionMatches(args.lists[i], args.lists[i + 1]);
+        deleteMatches(args.lists[i]);
+        deleteMatches(args.lists[i + 1]);
+        args.lists[merged++] = pair;
+      }
+    }
+    args.numLists = merged;
+  }
+
+  matches_t result = { postings_new(), NULL };
+  if (args.numLists == 1) {
+    postings_delete(result.postings);
+    result = args.lists[0];
+  }
+  free(args.lists);
+  return result;
+}
+
+/* 
+ * HELPER FUNCTION
+ * Decodes one word's compressed postings into args->matches, as a bitmap
+ * if the word is dense and as a postings list otherwise
+ */
+static void decodeWord(postings_args_t* args, plist_t* postings) {
+  if (plist_isDense(postings)) {
+    args->matches.postings = NULL;
+    args->matches.bitmap = bitmap_new();
+  } else {
+    args->matches.postings = postings_new();
+    args->matches.bitmap = NULL;
+    postings_reserve(args->matches.postings, plist_size(postings));
+  }
+  plist_iterate(postings, args, addPosting_helper);
+}
+
+/* 
+ * HELPER FUNCTION
+ * Called for each word matching a prefix; decodes its postings into 
+ * matches of their own
  */
-static counters_t* counters_copy(counters_t* source) {
-  counters_t* copy = counters_new();
-  if (source == NULL) {
-    return copy;
+static void prefixToMatches_helper(void* arg, const char* word, plist_t* postings) {
+  postings_args_t* args = arg;
+  if (args->numLists == args->listCap) {
+    int listCap = (args->listCap == 0) ? 8 : 2 * args->listCap;
+    matches_t* bigger = realloc(args->lists, listCap * sizeof(matches_t));
+    if (bigger == NULL) {
+      return;
+    }
+    args->lists = bigger;
+    args->listCap = listCap;
+  }
+
+  decodeWord(args, postings);
+  if (args->matches.postings != NULL || args->matches.bitmap != NULL) {
+    args->lists[args->numLists++] = args->matches;
   }
-  for (int i = 1; i <= 1000; i++) {
-    int val = counters_get(source, i);
-    if (val > 0) {
-      counters_set(copy, i, val);
+}
+
+/* 
+ * HELPER FUNCTION
+ * Called for each posting, in docID order; appends it to the postings 
+ * list or bitmap unless its document is tombstoned
+ */
+static void addPosting_helper(void* arg, const int docID, const int count) {
+  postings_args_t* args = arg;
+  if (!index_isRemoved(args->index, docID)) {
+    if (args->matches.bitmap != NULL) {
+      bitmap_add(args->matches.bitmap, docID, count);
+    } else {
+      postings_add(args->matches.postings, docID, count);
     }
   }
-  return copy;
 }
 
 /* 
- * Computes the intersection (AND) of two counters objects
+ * Computes the intersection (AND) of two sets of matches, in whichever
+ * form suits them: two bitmaps are ANDed a word at a time, a bitmap and a
+ * list by looking the list's documents up in the bitmap, and two lists 
+ * by intersectPostings
+ *
+ * Caller provides:
+ *   a - first matches
+ *   b - second matches
+ *   gallop - for two lists, whether to gallop (see intersectPostings)
+ * Return:
+ *   new matches representing intersection (a bitmap only if both are)
+ */
+static matches_t intersectMatches(matches_t a, matches_t b, const bool gallop) {
+  matches_t result = { NULL, NULL };
+  if (a.bitmap != NULL && b.bitmap != NULL) {
+    result.bitmap = bitmap_and(a.bitmap, b.bitmap);
+  } else if (a.bitmap != NULL) {
+    result.postings = bitmap_andPostings(a.bitmap, b.postings);
+  } else if (b.bitmap != NULL) {
+    result.postings = bitmap_andPostings(b.bitmap, a.postings);
+  } else {
+    result.postings = intersectPostings(a.postings, b.postings, gallop);
+  }
+  return result;
+}
+
+/* 
+ * Computes the union (OR) of two sets of matches: two bitmaps are ORed a
+ * word at a time, a list is united with a bitmap by making it a bitmap 
+ * first, and two lists are merged by unionPostings
+ *
+ * Caller provides:
+ *   a - first matches
+ *   b - second matches
+ * Return:
+ *   new matches representing union (a bitmap if either is)
+ */
+static matches_t unionMatches(matches_t a, matches_t b) {
+  matches_t result = { NULL, NULL };
+  if (a.bitmap != NULL && b.bitmap != NULL) {
+    result.bitmap = bitmap_or(a.bitmap, b.bitmap);
+  } else if (a.bitmap != NULL) {
+    result.bitmap = bitmap_orPostings(a.bitmap, b.postings);
+  } else if (b.bitmap != NULL) {
+    result.bitmap = bitmap_orPostings(b.bitmap, a.postings);
+  } else {
+    result.postings = unionPostings(a.postings, b.postings);
+  }
+  return result;
+}
+
+/* 
+ * Returns the number of documents in matches, in either form
+ */
+static int matchesSize(matches_t matches) {
+  return (matches.bitmap != NULL) ? bitmap_size(matches.bitmap)
+                                  : postings_size(matches.postings);
+}
+
+/* 
+ * Calls itemfunc(arg, docID, count) for each match, in docID order
+ */
+static void iterateMatches(matches_t matches, void* arg,
+                           void (*itemfunc)(void* arg, const int docID, const int count)) {
+  if (matches.bitmap != NULL) {
+    bitmap_iterate(matches.bitmap, arg, itemfunc);
+  } else {
+    postings_iterate(matches.postings, arg, itemfunc);
+  }
+}
+
+/* 
+ * Frees matches, in either form
+ */
+static void deleteMatches(matches_t matches) {
+  bitmap_delete(matches.bitmap);
+  postings_delete(matches.postings);
+}
+
+/* 
+ * Computes the intersection (AND) of two postings lists
  * For each docID in both, the score is the minimum count
+ * When galloping, whichever list is behind gallops forward to the 
+ * other's docID, so a short list intersected with a much longer one 
+ * skips most of the long one; otherwise the lists are merged one posting
+ * at a time, which is cheaper for lists of similar length.
+ *
+ * Caller provides:
+ *   a - first postings list
+ *   b - second postings list
+ *   gallop - whether to gallop
+ * Return:
+ *   new postings list representing intersection
+ */
+static postings_t* intersectPostings(postings_t* a, postings_t* b, const bool gallop) {
+  postings_t* result = postings_new();
+  int sizeA = postings_size(a);
+  int sizeB = postings_size(b);
+  postings_reserve(result, (sizeA < sizeB) ? sizeA : sizeB);
+
+  postings_iter_t iterA;
+  postings_iter_t iterB;
+  postings_iter_init(&iterA, a);
+  postings_iter_init(&iterB, b);
+  int docA, countA, docB, countB;
+  bool haveA = postings_iter_next(&iterA, &docA, &countA);
+  bool haveB = postings_iter_next(&iterB, &docB, &countB);
+
+  while (haveA && haveB) {
+    if (docA < docB) {
+      haveA = (!gallop || postings_iter_seek(&iterA, docB))
+              && postings_iter_next(&iterA, &docA, &countA);
+    } else if (docB < docA) {
+      haveB = (!gallop || postings_iter_seek(&iterB, docA))
+              && postings_iter_next(&iterB, &docB, &countB);
+    } else {
+      postings_add(result, docA, (countA < countB ? countA : countB));
+      haveA = postings_iter_next(&iterA, &docA, &countA);
+      haveB = postings_iter_next(&iterB, &docB, &countB);
+    }
+  }
+  return result;
+}
+
+/* 
+ * Computes the union (OR) of two postings lists
+ * For each docID in either, the score is the sum of the counts
+ * Merges the two sorted lists in one pass.
  *
  * Caller provides:
- *   a - first counters object
- *   b - second counters object
+ *   a - first postings list
+ *   b - second postings list
+ * Return:
+ *   new postings list representing union
+ */
+static postings_t* unionPostings(postings_t* a, postings_t* b) {
+  postings_t* result = postings_new();
+  postings_reserve(result, postings_size(a) + postings_size(b));
+
+  postings_iter_t iterA;
+  postings_iter_t iterB;
+  postings_iter_init(&iterA, a);
+  postings_iter_init(&iterB, b);
+  int docA, countA, docB, countB;
+  bool haveA = postings_iter_next(&iterA, &docA, &countA);
+  bool haveB = postings_iter_next(&iterB, &docB, &countB);
+
+  while (haveA || haveB) {
+    if (!haveB || (haveA && docA < docB)) {
+      postings_add(result, docA, countA);
+      haveA = postings_iter_next(&iterA, &docA, &countA);
+    } else if (!haveA || docB < docA) {
+      postings_add(result, docB, countB);
+      haveB = postings_iter_next(&iterB, &docB, &countB);
+    } else {
+      postings_add(result, docA, countA + countB);
+      haveA = postings_iter_next(&iterA, &docA, &countA);
+      haveB = postings_iter_next(&iterB, &docB, &countB);
+    }
+  }
+  return result;
+}
+
+/*
+ * Plans how to evaluate a validated query on one index. The document 
+ * frequency (df) of every word is read from the index first, without 
+ * decoding any postings. Within each and-sequence the words are ordered 
+ * by increasing df, so every intersection starts from the shortest list
+ * and the running result only shrinks; a word whose list is GALLOP_RATIO 
+ * times longer than the first is galloped into rather than merged. A 
+ * sequence with a word of df 0 can match nothing, so its estimate is 0 
+ * and it is skipped. Sequences are ordered by increasing estimate, so 
+ * the unions also start small.
+ *
+ * Caller provides:
+ *   words - query words (normalized and validated)
+ *   wordCount - number of words
+ *   index - the index the plan is for
  * Return:
- *   new counters object representing intersection
+ *   new plan, or NULL if out of memory
+ */
+static plan_t* planQuery(char** words, const int wordCount, index_t* index) {
+  plan_t* plan = malloc(sizeof(plan_t));
+  if (plan == NULL) {
+    return NULL;
+  }
+  plan->numClauses = 0;
+  plan->clauses = calloc(wordCount, sizeof(plan_clause_t));
+  if (plan->clauses == NULL) {
+    free(plan);
+    return NULL;
+  }
+
+  for (int i = 0; i < wordCount; i++) {
+    plan_clause_t* clause = &plan->clauses[plan->numClauses++];
+    clause->terms = malloc(wordCount * sizeof(plan_term_t));
+    if (clause->terms == NULL) {
+      freePlan(plan);
+      return NULL;
+    }
+    clause->estimate = -1;
+    clause->cost = 0;
+    clause->touched = 0;
+
+    for (; i < wordCount && strcmp(words[i], "or") != 0; i++) {
+      if (strcmp(words[i], "and") == 0) {
+        continue;
+      }
+      plan_term_t* term = &clause->terms[clause->numTerms++];
+      term->word = words[i];
+      term->df = wordFrequency(index, words[i]);
+      term->position = i;
+      term->gallop = false;
+      clause->cost += term->df;
+      if (clause->estimate == -1 || term->df < clause->estimate) {
+        clause->estimate = term->df;
+      }
+    }
+
+    qsort(clause->terms, clause->numTerms, sizeof(plan_term_t), termCmp);
+    for (int t = 1; t < clause->numTerms; t++) {
+      clause->terms[t].gallop = 
+        (long)clause->terms[t].df >= (long)GALLOP_RATIO * clause->terms[0].df;
+    }
+  }
+
+  qsort(plan->clauses, plan->numClauses, sizeof(plan_clause_t), clauseCmp);
+  return plan;
+}
+
+/* 
+ * HELPER FUNCTION
+ * Returns the number of documents in a word's postings, summed over the
+ * words with its prefix if it ends in '*'
+ */
+static int wordFrequency(index_t* index, const char* word) {
+  size_t len = strlen(word);
+  if (len == 0 || word[len - 1] != '*') {
+    return plist_size(index_find(index, word));
+  }
+
+  int df = 0;
+  char* prefix = strndup(word, len - 1);
+  if (prefix != NULL) {
+    index_prefix(index, prefix, &df, prefixFrequency_helper);
+    free(prefix);
+  }
+  return df;
+}
+
+/* 
+ * HELPER FUNCTION
+ * Called for each word matching a prefix; adds its df to the total
+ */
+static void prefixFrequency_helper(void* arg, const char* word, plist_t* postings) {
+  int* df = arg;
+  *df += plist_size(postings);
+}
+
+/* 
+ * HELPER FUNCTION
+ * Orders plan terms by increasing df, then by position in the query
+ */
+static int termCmp(const void* a, const void* b) {
+  const plan_term_t* termA = a;
+  const plan_term_t* termB = b;
+  if (termA->df != termB->df) {
+    return (termA->df < termB->df) ? -1 : 1;
+  }
+  return termA->position - termB->position;
+}
+
+/* 
+ * HELPER FUNCTION
+ * Orders plan clauses by increasing estimate, with empty clauses (which 
+ * are skipped) last, then by position in the query
+ */
+static int clauseCmp(const void* a, const void* b) {
+  const plan_clause_t* clauseA = a;
+  const plan_clause_t* clauseB = b;
+  bool emptyA = (clauseA->estimate == 0);
+  bool emptyB = (clauseB->estimate == 0);
+  if (emptyA != emptyB) {
+    return emptyA ? 1 : -1;
+  }
+  if (clauseA->estimate != clauseB->estimate) {
+    return (clauseA->estimate < clauseB->estimate) ? -1 : 1;
+  }
+  return clauseA->terms[0].position - clauseB->terms[0].position;
+}
+
+/*
+ * Evaluates a query plan: each and-sequence is intersected in the 
+ * plan's order, stopping as soon as its result is empty, and the 
+ * sequences' results are unioned. Sequences the plan found empty are 
+ * not evaluated at all, so their words are never decoded. An or of 
+ * several sequences that together may decode at least parallelOr 
+ * postings is evaluated on orPool's threads as well as the caller's (see
+ * evaluateOr); smaller ones are not worth handing to threads.
+ *
+ * Caller provides:
+ *   plan - from planQuery on the same index
+ *   index - in-memory index structure
+ *   orPool - threads the or may use besides the caller's, or NULL
+ *   parallelOr - postings the or must have to use them, 0 for never
+ * Return:
+ *   matches mapping docIDs to total relevance score
+ */
+static matches_t evaluatePlan(plan_t* plan, index_t* index,
+                              workpool_t* orPool, const long parallelOr) {
+  //the plan puts the sequences that are skipped last
+  int numClauses = 0;
+  long cost = 0;
+  while (numClauses < plan->numClauses && plan->clauses[numClauses].estimate > 0) {
+    cost += plan->clauses[numClauses++].cost;
+  }
+  if (numClauses > 1 && orPool != NULL && parallelOr > 0 && cost >= parallelOr) {
+    return evaluateOr(plan, index, numClauses, orPool);
+  }
+
+  matches_t result = { NULL, NULL };
+  for (int c = 0; c < numClauses; c++) {
+    matches_t subResult = evaluateClause(&plan->clauses[c], index);
+    if (c == 0) {
+      result = subResult;
+    } else {
+      matches_t temp = unionMatches(result, subResult);
+      deleteMatches(result);
+      deleteMatches(subResult);
+      result = temp;
+    }
+  }
+
+  if (numClauses == 0) {
+    result.postings = postings_new();
+  }
+  return result;
+}
+
+/*
+ * HELPER FUNCTION
+ * Intersects one and-sequence's words in the plan's order, stopping as 
+ * soon as the result is empty, and records the postings it decoded
+ */
+static matches_t evaluateClause(plan_clause_t* clause, index_t* index) {
+  matches_t result = wordToMatches(index, clause->terms[0].word);
+  clause->touched = clause->terms[0].df;
+  for (int t = 1; t < clause->numTerms && matchesSize(result) > 0; t++) {
+    clause->touched += clause->terms[t].df;
+    matches_t wordCopy = wordToMatches(index, clause->terms[t].word);
+    matches_t temp = intersectMatches(result, wordCopy, clause->terms[t].gallop);
+    deleteMatches(result);
+    deleteMatches(wordCopy);
+    result = temp;
+  }
+  return result;
+}
+
+/*
+ * Evaluates the first numClauses and-sequences of a plan in parallel, 
+ * then unions their results in parallel rounds: in each round, result 
+ * i takes in result i + step for every i that is a multiple of 2 * step,
+ * so n results are combined in log2(n) rounds, each of which unions 
+ * disjoint pairs. Since scores are summed, the order of the unions does
+ * not change them.
+ *
+ * Caller provides:
+ *   plan - from planQuery, with at least numClauses non-empty sequences
+ *   index - in-memory index structure
+ *   numClauses - sequences to evaluate
+ *   pool - threads to use besides the caller's
+ * Return:
+ *   matches mapping docIDs to total relevance score
+ */
+static matches_t evaluateOr(plan_t* plan, index_t* index,
+                            const int numClauses, workpool_t* pool) {
+  or_args_t args = { plan, index, calloc(numClauses, sizeof(matches_t)), 0, NULL, 0, 0, 0,
+                     PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER };
+  if (args.results == NULL) {
+    return evaluatePlan(plan, index, NULL, 0);
+  }
+
+  runTasks(&args, evaluateClause_task, numClauses, pool);
+  for (int step = 1; step < numClauses; step *= 2) {
+    args.step = step;
+    runTasks(&args, unionPair_task, (numClauses - step + 2 * step - 1) / (2 * step),
+             pool);
+  }
+
+  matches_t result = args.results[0];
+  free(args.results);
+  return result;
+}
+
+/*
+ * HELPER FUNCTION
+ * Runs task for t = 0 .. numTasks - 1 in the caller and on up to all of
+ * the pool's threads, which are shared by every query and live as long 
+ * as the querier; each thread takes the next t until none are left, so
+ * a slow task does not hold up the others. Returns when all are done,
+ * waiting for the pool tasks it submitted (which find nothing left to
+ * do if they start late).
+ */
+static void runTasks(or_args_t* args, void (*task)(or_args_t* args, const int t),
+                     const int numTasks, workpool_t* pool) {
+  args->task = task;
+  args->numTasks = numTasks;
+  atomic_store(&args->nextTask, 0);
+
+  int numHelpers = workpool_size(pool);
+  if (numHelpers > numTasks - 1) {
+    numHelpers = numTasks - 1;
+  }
+  pthread_mutex_lock(&args->lock);
+  for (int i = 0; i < numHelpers && workpool_submit(pool, runTasks_helper, args); i++) {
+    args->helpers++;
+  }
+  pthread_mutex_unlock(&args->lock);
+
+  runTasks_thread(args);
+
+  pthread_mutex_lock(&args->lock);
+  while (args->helpers > 0) {
+    pthread_cond_wait(&args->done, &args->lock);
+  }
+  pthread_mutex_unlock(&args->lock);
+}
+
+/*
+ * HELPER FUNCTION
+ * Runs runTasks' tasks until none are left
+ */
+static void runTasks_thread(or_args_t* args) {
+  int t;
+  while ((t = atomic_fetch_add(&args->nextTask, 1)) < args->numTasks) {
+    (*args->task)(args, t);
+  }
+}
+
+/*
+ * HELPER FUNCTION
+ * Worker pool task of runTasks: runs its tasks on a pool thread, then
+ * tells the caller this helper is done
+ */
+static void runTasks_helper(void* arg, void* scratch) {
+  or_args_t* args = arg;
+  runTasks_thread(args);
+  pthread_mutex_lock(&args->lock);
+  if (--args->helpers == 0) {
+    pthread_cond_signal(&args->done);
+  }
+  pthread_mutex_unlock(&args->lock);
+}
+
+/*
+ * HELPER FUNCTION
+ * Task of evaluateOr: evaluates and-sequence t
  */
-static counters_t* intersectCounters(counters_t* a, counters_t* b) {
-  counters_t* result = counters_new();
-  if (a == NULL || b == NULL) {
-    return result;
-  }
-  for (int i = 1; i <= 1000; i++) {
-    int countA = counters_get(a, i);
-    int countB = counters_get(b, i);
-    if (countA > 0 && countB > 0) {
-      counters_set(result, i, (countA < countB ? countA : countB));
-    }
-  }
-  return result;
+static void evaluateClause_task(or_args_t* args, const int t) {
+  args->results[t] = evaluateClause(&args->plan->clauses[t], args->index);
 }
 
-/* 
- * Computes the union (OR) of two counters objects
- * For each docID in either, the score is the sum of the counts
- *
- * Caller provides:
- *   a - first counters object
- *   b - second counters object
- * Return:
- *   new counters object representing union
+/*
+ * HELPER FUNCTION
+ * Task of evaluateOr: unions the t-th pair of the current round
  */
-static counters_t* unionCounters(counters_t* a, counters_t* b) {
-  counters_t* result = counters_new();
-  if (a == NULL && b == NULL) {
-    return result;
-  }
-  for (int i = 1; i <= 1000; i++) {
-    int count = (a ? counters_get(a, i) : 0) + (b ? counters_get(b, i) : 0);
-    if (count > 0) {
-      counters_set(result, i, count);
-    }
-  }
-  return result;
+static void unionPair_task(or_args_t* args, const int t) {
+  matches_t* a = &args->results[2 * t * args->step];
+  matches_t* b = &args->results[2 * t * args->step + args->step];
+  matches_t result = unionMatches(*a, *b);
+  deleteMatches(*a);
+  deleteMatches(*b);
+  *a = result;
+  b->postings = NULL;
+  b->bitmap = NULL;
 }
 
 /*
- * Interprets AND/OR logic on the input words and combines results using
- * index
+ * Describes a plan in one line: the and-sequences in the order they are
+ * evaluated, each word with its df and, after the first, whether it is 
+ * merged or galloped; sequences that are skipped are marked so.
  *
- * Caller provides:
- *   words - query words (normalized and validated)
- *   wordCount - number of words
- *   index - in-memory index structure
  * Return:
- *   counters object mapping docIDs to total relevance score
+ *   allocated string, or NULL if out of memory
  */
-static counters_t* evaluateQuery(char** words, int wordCount, index_t* index) {
-  counters_t* result = NULL;
-  int i = 0;
-
-  while (i < wordCount) {
-    counters_t* subResult = NULL;
-
-    while (i < wordCount && strcmp(words[i], "or") != 0) {
-      if (strcmp(words[i], "and") == 0) {
-        i++;
-        continue;
-      }
-
-      counters_t* wordCounts = index_find(index, words[i]);
-      counters_t* wordCopy = (wordCounts != NULL) ? counters_copy(wordCounts) : counters_new();
+static char* describePlan(const plan_t* plan) {
+  char* text = NULL;
+  size_t len = 0;
+  FILE* fp = open_memstream(&text, &len);
+  if (fp == NULL) {
+    return NULL;
+  }
 
-      if (subResult == NULL) {
-        subResult = wordCopy;
+  for (int c = 0; c < plan->numClauses; c++) {
+    const plan_clause_t* clause = &plan->clauses[c];
+    fprintf(fp, "%s%s", (c > 0) ? " or " : "",
+            (clause->estimate == 0) ? "(skipped) " : "");
+    for (int t = 0; t < clause->numTerms; t++) {
+      const plan_term_t* term = &clause->terms[t];
+      if (t == 0) {
+        fprintf(fp, "%s (%d)", term->word, term->df);
       } else {
-        counters_t* temp = intersectCounters(subResult, wordCopy);
-        counters_delete(subResult);
-        counters_delete(wordCopy);
-        subResult = temp;
+        fprintf(fp, " and %s (%d, %s)", term->word, term->df,
+                term->gallop ? "gallop" : "merge");
       }
-      i++;
-    }
-
-    if (subResult == NULL) {
-      subResult = counters_new();
-    }
-
-    if (result == NULL) {
-      result = subResult;
-    } else {
-      counters_t* temp = unionCounters(result, subResult);
-      counters_delete(result);
-      counters_delete(subResult);
-      result = temp;
-    }
-
-    if (i < wordCount && strcmp(words[i], "or") == 0) {
-      i++;
     }
   }
+  fclose(fp);
+  return text;
+}
 
-  if (result == NULL) {
-    result = counters_new();
+/*
+ * Frees a plan
+ */
+static void freePlan(plan_t* plan) {
+  if (plan == NULL) {
+    return;
   }
-
-  return result;
+  for (int c = 0; c < plan->numClauses; c++) {
+    free(plan->clauses[c].terms);
+  }
+  free(plan->clauses);
+  free(plan);
 }
 
 /*
@@ -240,22 +1604,23 @@ static counters_t* evaluateQuery(char** words, int wordCount, index_t* index) {
  * Caller provides:
  *   words - array of strings representing query tokens
  *   wordCount - number of tokens
+ *   err - where to print what is wrong
  * Return:
  *   true if query is valid, false otherwise
  */
-static bool validateQuery(char** words, const int wordCount) {
+static bool validateQuery(char** words, const int wordCount, FILE* err) {
   for (int i = 0; i < wordCount; i++) {
     if ((strcmp(words[i], "and") == 0 || strcmp(words[i], "or") == 0)) {
       if (i == 0) {
-        fprintf(stderr, "Error: '%s' cannot be first\n", words[i]);
+        fprintf(err, "Error: '%s' cannot be first\n", words[i]);
         return false;
       }
       if (i == wordCount - 1) {
-        fprintf(stderr, "Error: '%s' cannot be last\n", words[i]);
+        fprintf(err, "Error: '%s' cannot be last\n", words[i]);
         return false;
       }
       if (strcmp(words[i + 1], "and") == 0 || strcmp(words[i + 1], "or") == 0) {
-        fprintf(stderr, "Error: '%s' and '%s' cannot be adjacent\n", words[i], words[i + 1]);
+        fprintf(err, "Error: '%s' and '%s' cannot be adjacent\n", words[i], words[i + 1]);
         return false;
       }
     }
@@ -264,16 +1629,18 @@ static bool validateQuery(char** words, const int wordCount) {
 }
 
 /*
- * Tokenizes the input line into lowercase alphabetic words
+ * Tokenizes the input line into lowercase alphabetic words, each possibly
+ * ending in '*' to match a prefix
  * Checks for errors
  *
  * Caller provides:
  *   line - the input query string
  *   wordCount - pointer to store number of valid words
+ *   err - where to print what is wrong
  * Return:
  *   array of allocated strings (words), or NULL if fails
  */
-static char** parseWords(char* line, int* wordCount) {
+static char** parseWords(char* line, int* wordCount, FILE* err) {
   if (line == NULL || wordCount == NULL) return NULL;
 
   char* saveptr;
@@ -285,8 +1652,12 @@ static char** parseWords(char* line, int* wordCount) {
        token = strtok_r(NULL, " ", &saveptr)) {
 
     for (char* c = token; *c != '\0'; c++) {
+      //a '*' is allowed only to end a prefix word, like comput*
+      if (*c == '*' && c > token && c[1] == '\0') {
+        continue;
+      }
       if (!isalpha(*c)) {
-        fprintf(stderr, "Error: bad character '%c' in query.\n", *c);
+        fprintf(err, "Error: bad character '%c' in query.\n", *c);
         freeWords(words, count);
         return NULL;
       }
@@ -334,104 +1705,703 @@ static void freeWords(char** words, int wordCount) {
 }
 
 /*
- * Checks if counters object contains any non-zero entries
+ * Evaluates a query on one shard and ranks the shard's matches;
+ * runs in its own thread when there are several shards
  *
  * Caller provides:
- *   ctrs - counters object
- * Return:
- *   1 if an entry non-zero, 0 otherwise
+ *   arg - pointer to the shard_query_t; its results and numResults are
+ *         filled in, as a heap with the best result at the root
  */
-static int counters_nonzero(counters_t* ctrs) {
-  for (int i = 1; i <= 1000; i++) {
-    if (counters_get(ctrs, i) > 0) {
-      return 1;
+static void* evaluateShard(void* arg) {
+  shard_query_t* query = arg;
+  query->numResults = 0;
+  query->plan = NULL;
+  query->touched = 0;
+
+  matches_t result = { NULL, NULL };
+  plan_t* plan = planQuery(query->words, query->wordCount, query->index);
+  if (plan != NULL) {
+    result = evaluatePlan(plan, query->index, query->orPool, query->parallelOr);
+    if (query->showPlan) {
+      query->plan = describePlan(plan);
     }
+    for (int c = 0; c < plan->numClauses; c++) {
+      query->touched += plan->clauses[c].touched;
+    }
+    freePlan(plan);
   }
-  return 0;
+  if (query->top > 0) {
+    reserve((void**)&query->results, &query->resultCap, query->top, sizeof(result_t));
+  }
+  iterateMatches(result, query, collectResults_helper);
+  deleteMatches(result);
+
+  //turns the kept results (worst first, if bounded) into a best-first heap
+  heapify(query->results, query->numResults, false);
+  return NULL;
+}
+
+/* 
+ * HELPER FUNCTION
+ * Called for each posting of a shard's result. Without a limit, appends
+ * every matching document to the shard's results. With --top K, keeps 
+ * the K best seen so far in a heap with the worst at the root, which a
+ * better document replaces.
+ */
+static void collectResults_helper(void* arg, const int docID, const int count) {
+  shard_query_t* query = arg;
+  if (count <= 0) {
+    return;
+  }
+  result_t result = { docID, count };
+  int n = query->numResults;
+
+  if (query->top > 0) {
+    if (query->resultCap < query->top) {
+      return;
+    }
+    if (n < query->top) {
+      query->results[query->numResults++] = result;
+      if (query->numResults == query->top) {
+        heapify(query->results, query->numResults, true);
+      }
+    } else if (resultCmp(&result, &query->results[0]) < 0) {
+      query->results[0] = result;
+      siftDown(query->results, n, 0, true);
+    }
+    return;
+  }
+
+  if (!reserve((void**)&query->results, &query->resultCap, n + 1, sizeof(result_t))) {
+    return;
+  }
+  query->results[n] = result;
+  query->numResults++;
+}
+
+/* 
+ * HELPER FUNCTION
+ * Orders results by decreasing score, then increasing docID
+ */
+static int resultCmp(const void* a, const void* b) {
+  const result_t* ra = a;
+  const result_t* rb = b;
+  if (ra->score != rb->score) {
+    return (ra->score > rb->score) ? -1 : 1;
+  }
+  return (ra->docID > rb->docID) - (ra->docID < rb->docID);
+}
+
+/* 
+ * HELPER FUNCTION
+ * Arranges n results into a binary heap in O(n): with the best result
+ * at the root, or the worst if worstFirst is true
+ */
+static void heapify(result_t* heap, const int n, const bool worstFirst) {
+  for (int i = n / 2 - 1; i >= 0; i--) {
+    siftDown(heap, n, i, worstFirst);
+  }
+}
+
+/* 
+ * HELPER FUNCTION
+ * Moves heap[i] down until neither child belongs above it
+ */
+static void siftDown(result_t* heap, const int n, int i, const bool worstFirst) {
+  result_t moving = heap[i];
+  while (2 * i + 1 < n) {
+    //picks the child that belongs higher
+    int child = 2 * i + 1;
+    if (child + 1 < n) {
+      int cmp = resultCmp(&heap[child + 1], &heap[child]);
+      if (worstFirst ? cmp > 0 : cmp < 0) {
+        child++;
+      }
+    }
+    int cmp = resultCmp(&heap[child], &moving);
+    if (!(worstFirst ? cmp > 0 : cmp < 0)) {
+      break;
+    }
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = moving;
+}
+
+/* 
+ * HELPER FUNCTION
+ * Removes the root of a best-first heap of *n results into *top
+ *
+ * Return:
+ *   true if there was a result, false if the heap is empty
+ */
+static bool heapPop(result_t* heap, int* n, result_t* top) {
+  if (*n == 0) {
+    return false;
+  }
+  *top = heap[0];
+  heap[0] = heap[--(*n)];
+  siftDown(heap, *n, 0, false);
+  return true;
 }
 
 /*
- * Prints documents sorted by source, retrieves URLs from page files
+ * Ranks the documents by score, merging the shards' ranked results
  *
  * Caller provides:
- *   result - counters object mapping docIDs to relevance scores
- *   pageDir - directory of crawler page files
+ *   queries - each shard's results, as best-first heaps; they are 
+ *             consumed
+ *   numShards - number of shards
+ *   top - how many results to rank, 0 for all
+ *   scratch - where to store the results, best first, in ranked
+ * Return:
+ *   number of results, or -1 if out of memory
  */
-static void rankAndPrint(counters_t* result, const char* pageDir) {
-  while (1) {
-    int maxDoc = 0;
-    int maxScore = 0;
+static int rankResults(shard_query_t* queries, const int numShards,
+                       const int top, scratch_t* scratch) {
+  int total = 0;
+  for (int i = 0; i < numShards; i++) {
+    total += queries[i].numResults;
+  }
+  if (top > 0 && total > top) {
+    total = top;
+  }
+  if (!reserve((void**)&scratch->ranked, &scratch->rankedCap, total, sizeof(ranked_t))) {
+    return -1;
+  }
 
-    for (int i = 1; i <= 1000; i++) {
-      int score = counters_get(result, i);
-      if (score > maxScore) {
-        maxScore = score;
-        maxDoc = i;
+  int numRanked = 0;
+  while (numRanked < total) {
+    //picks the best of the shards' next results
+    int bestShard = -1;
+    for (int i = 0; i < numShards; i++) {
+      if (queries[i].numResults > 0 &&
+          (bestShard == -1 || 
+           resultCmp(&queries[i].results[0], &queries[bestShard].results[0]) < 0)) {
+        bestShard = i;
       }
     }
 
-    if (maxDoc == 0) break;
+    ranked_t* next = &scratch->ranked[numRanked];
+    if (bestShard == -1 || !heapPop(queries[bestShard].results,
+                                    &queries[bestShard].numResults, &next->result)) {
+      break;
+    }
+    next->shard = bestShard;
+    numRanked++;
+  }
+  return numRanked;
+}
 
-    char* path;
-    if (asprintf(&path, "%s/%d", pageDir, maxDoc) != -1) {
-      FILE* fp = fopen(path, "r");
-      if (fp != NULL) {
-        char* url = file_readLine(fp);
-        printf("score %4d doc %3d: %s\n", maxScore, maxDoc, url);
-        free(url);
-        fclose(fp);
-      }
-      free(path);
+/*
+ * Prints ranked results, taking URLs from the shards' document tables
+ *
+ * Caller provides:
+ *   ranked - results, best first, as from rankResults or the cache
+ *   numRanked - number of results
+ *   shards - the loaded shards
+ *   pageDir - directory of crawler page files
+ *   out - where to print them
+ */
+static void printRanked(const ranked_t* ranked, const int numRanked,
+                        shard_t* shards, const char* pageDir, FILE* out) {
+  if (numRanked == 0) {
+    fprintf(out, "No documents match.\n");
+  }
+  for (int i = 0; i < numRanked; i++) {
+    printResult(&ranked[i].result, shards[ranked[i].shard].docs, pageDir, out);
+  }
+}
+
+/* 
+ * HELPER FUNCTION
+ * Prints one result line with the document's URL, taken from the shard's
+ * document table or, failing that, from the first line of its page file
+ */
+static void printResult(const result_t* result, doctable_t* docs,
+                        const char* pageDir, FILE* out) {
+  const char* url = doctable_url(docs, result->docID);
+  if (url != NULL) {
+    fprintf(out, "score %4d doc %3d: %s\n", result->score, result->docID, url);
+    return;
+  }
+
+  char* path;
+  if (asprintf(&path, "%s/%d", pageDir, result->docID) != -1) {
+    FILE* fp = fopen(path, "r");
+    if (fp != NULL) {
+      char* pageURL = file_readLine(fp);
+      fprintf(out, "score %4d doc %3d: %s\n", result->score, result->docID, pageURL);
+      free(pageURL);
+      fclose(fp);
     }
-    counters_set(result, maxDoc, 0);
+    free(path);
   }
 }
 
 /*
  * Parses, validates, and evaluates a query line, then prints ranked 
- * results
+ * results. Any number of threads may answer queries at once, each with
+ * its own scratch; the index is held for reading until the results are 
+ * printed, since their URLs come from it.
  *
  * Caller provides:
  *   line - input string containing query
- *   index - loaded index from indexFilename
- *   pageDir - directory containing crawler-generated pages
+ *   querier - the loaded shards and the options for answering
+ *   scratch - memory of the calling thread, from newScratch
+ *   out - where to print the results
+ *   err - where to print what is wrong with an invalid query
+ * Notes:
+ *   With no scratch (newScratch failed), prints an out-of-memory error 
+ *   to err instead of answering.
  */
-static void processQuery(char* line, index_t* index, const char* pageDir) {
-  if (line == NULL || index == NULL || pageDir == NULL) return;
+static void processQuery(char* line, querier_t* querier, scratch_t* scratch,
+                         FILE* out, FILE* err) {
+  if (line == NULL || querier == NULL) return;
+  if (scratch == NULL) {
+    fprintf(err, "Error: out of memory\n");
+    return;
+  }
+  scratch->touched = 0;
   if (line[0] == '\0') {
-    printf("No documents match.\n");
+    fprintf(out, "No documents match.\n");
     return;
   }
 
   int wordCount = 0;
-  char** words = parseWords(line, &wordCount);
+  char** words = parseWords(line, &wordCount, err);
   if (words == NULL || wordCount == 0) {
     freeWords(words, wordCount);
-    printf("No documents match.\n");
+    fprintf(out, "No documents match.\n");
     return;
   }
 
   normalizeWords(words, wordCount);
 
-  if (!validateQuery(words, wordCount)) {
+  if (!validateQuery(words, wordCount, err)) {
     freeWords(words, wordCount);
     return;
   }
 
-  printf("Query:");
+  fprintf(out, "Query:");
   for (int i = 0; i < wordCount; i++) {
-    printf(" %s", words[i]);
+    fprintf(out, " %s", words[i]);
   }
-  printf("\n");
+  fprintf(out, "\n");
+
+  pthread_rwlock_rdlock(&querier->indexLock);
+  answerQuery(words, wordCount, querier, scratch, out);
+  pthread_rwlock_unlock(&querier->indexLock);
+  freeWords(words, wordCount);
+}
 
-  counters_t* result = evaluateQuery(words, wordCount, index);
+/*
+ * HELPER FUNCTION
+ * Answers a validated query from the cache or by evaluating it on every
+ * shard, and prints the ranked results; the caller holds the index
+ */
+static void answerQuery(char** words, const int wordCount, querier_t* querier,
+                        scratch_t* scratch, FILE* out) {
+  shard_t* shards = querier->shards;
+  int numShards = querier->numShards;
 
-  if (result == NULL || counters_nonzero(result) == 0) {
-    printf("No documents match.\n");
-  } else {
-    rankAndPrint(result, pageDir);
+  //a query equivalent to a cached one is answered from the cache
+  char* key = (querier->cache != NULL) ? canonicalQuery(words, wordCount) : NULL;
+  int numRanked = (key != NULL) ? findCached(querier, key, scratch) : -1;
+  if (numRanked >= 0) {
+    if (querier->showPlan) {
+      fprintf(out, "Plan: cached\n");
+    }
+    printRanked(scratch->ranked, numRanked, shards, querier->pageDir, out);
+    free(key);
+    return;
   }
 
-  counters_delete(result);
-  freeWords(words, wordCount);
+  if (!reserve((void**)&scratch->queries, &scratch->queryCap, numShards, sizeof(shard_query_t))
+      || !reserve((void**)&scratch->threads, &scratch->threadCap, numShards, sizeof(pthread_t))
+      || !reserve((void**)&scratch->threaded, &scratch->threadedCap, numShards, sizeof(bool))) {
+    free(key);
+    return;
+  }
+
+  //evaluates the query on every shard, in parallel if there are several
+  //and queries are not themselves answered in parallel
+  shard_query_t* queries = scratch->queries;
+  bool parallel = (numShards > 1 && querier->numThreads == 1);
+  for (int i = 0; i < numShards; i++) {
+    queries[i].index = shards[i].index;
+    queries[i].docs = shards[i].docs;
+    queries[i].words = words;
+    queries[i].wordCount = wordCount;
+    queries[i].top = querier->top;
+    queries[i].showPlan = querier->showPlan;
+    queries[i].orPool = querier->orPool;
+    queries[i].parallelOr = querier->parallelOr;
+    scratch->threaded[i] = parallel && 
+      (pthread_create(&scratch->threads[i], NULL, evaluateShard, &queries[i]) == 0);
+    if (!scratch->threaded[i]) {
+      evaluateShard(&queries[i]);
+    }
+  }
+
+  for (int i = 0; i < numShards; i++) {
+    if (scratch->threaded[i]) {
+      pthread_join(scratch->threads[i], NULL);
+    }
+    scratch->touched += queries[i].touched;
+    if (queries[i].plan != NULL) {
+      if (numShards == 1) {
+        fprintf(out, "Plan: %s\n", queries[i].plan);
+      } else {
+        fprintf(out, "Plan (shard %d): %s\n", i, queries[i].plan);
+      }
+      free(queries[i].plan);
+      queries[i].plan = NULL;
+    }
+  }
+
+  numRanked = rankResults(queries, numShards, querier->top, scratch);
+  if (numRanked >= 0) {
+    printRanked(scratch->ranked, numRanked, shards, querier->pageDir, out);
+    if (key != NULL) {
+      pthread_mutex_lock(&querier->cacheLock);
+      qcache_insert(querier->cache, key, scratch->ranked, numRanked * sizeof(ranked_t));
+      pthread_mutex_unlock(&querier->cacheLock);
+    }
+  }
+  free(key);
+}
+
+/*
+ * HELPER FUNCTION
+ * Looks a query's canonical form up in the cache and, if found, copies 
+ * its ranked results into scratch, so they can be printed after the 
+ * cache is released
+ *
+ * Return:
+ *   number of results, or -1 if the query is not cached
+ */
+static int findCached(querier_t* querier, const char* key, scratch_t* scratch) {
+  int numRanked = -1;
+  pthread_mutex_lock(&querier->cacheLock);
+  size_t size = 0;
+  const ranked_t* cached = qcache_find(querier->cache, key, &size);
+  if (cached != NULL) {
+    int n = size / sizeof(ranked_t);
+    if (reserve((void**)&scratch->ranked, &scratch->rankedCap, n, sizeof(ranked_t))) {
+      memcpy(scratch->ranked, cached, size);
+      numRanked = n;
+    }
+  }
+  pthread_mutex_unlock(&querier->cacheLock);
+  return numRanked;
+}
+
+/*
+ * Worker pool task: answers one query_job_t with the worker's scratch,
+ * first reloading the index if it has changed
+ */
+static void runQuery(void* arg, void* scratch) {
+  query_job_t* job = arg;
+  refreshIndex(job->querier);
+  processQuery(job->line, job->querier, scratch, job->out, job->err);
+}
+
+/*
+ * Answers every query in a file, one per line, in parallel on a pool of
+ * querier->numThreads workers, and prints the results to stdout (and 
+ * any errors to stderr) in the order of the file, as the querier would 
+ * for the same lines on stdin. Each query's output is collected in 
+ * memory and printed as soon as the queries before it are. Finally 
+ * prints a report to stderr: queries per second over the whole batch,
+ * percentiles of the time each query took, and the postings decoded.
+ *
+ * Caller provides:
+ *   querier - the loaded index and the options for answering
+ *   batchFile - the file of queries
+ * Return:
+ *   0 on success, 5 if the file cannot be read or out of memory
+ */
+static int runBatch(querier_t* querier, const char* batchFile) {
+  FILE* fp = fopen(batchFile, "r");
+  if (fp == NULL) {
+    fprintf(stderr, "Error: could not read batch file '%s'\n", batchFile);
+    return 5;
+  }
+
+  //reads every query first, so the timing covers only answering them
+  query_job_t* jobs = NULL;
+  int numJobs = 0;
+  int jobCap = 0;
+  char* line = NULL;
+  size_t len = 0;
+  ssize_t nread;
+  bool ok = true;
+  while (ok && (nread = getline(&line, &len, fp)) != -1) {
+    if (nread > 0 && line[nread - 1] == '\n') {
+      line[nread - 1] = '\0';
+    }
+    ok = reserve((void**)&jobs, &jobCap, numJobs + 1, sizeof(query_job_t))
+         && (jobs[numJobs].line = strdup(line)) != NULL;
+    if (ok) {
+      jobs[numJobs++].querier = querier;
+    }
+  }
+  free(line);
+  fclose(fp);
+
+  batch_t batch = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER };
+  workpool_t* pool = ok ? workpool_new(querier->numThreads, newScratch, freeScratch) : NULL;
+  if (pool == NULL) {
+    fprintf(stderr, "Error: out of memory\n");
+    for (int i = 0; i < numJobs; i++) {
+      free(jobs[i].line);
+    }
+    free(jobs);
+    return 5;
+  }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < numJobs; i++) {
+    query_job_t* job = &jobs[i];
+    job->batch = &batch;
+    job->out = open_memstream(&job->output, &job->outputLen);
+    job->err = open_memstream(&job->errors, &job->errorsLen);
+    if (job->out == NULL || job->err == NULL || !workpool_submit(pool, runBatchQuery, job)) {
+      fprintf(stderr, "Error: could not answer query %d\n", i + 1);
+      job->done = true;
+    }
+  }
+
+  //prints the answers in order as they arrive
+  for (int i = 0; i < numJobs; i++) {
+    query_job_t* job = &jobs[i];
+    pthread_mutex_lock(&batch.lock);
+    while (!job->done) {
+      pthread_cond_wait(&batch.answered, &batch.lock);
+    }
+    pthread_mutex_unlock(&batch.lock);
+
+    if (job->out != NULL) {
+      fclose(job->out);
+    }
+    if (job->err != NULL) {
+      fclose(job->err);
+    }
+    fflush(stdout);
+    if (job->errors != NULL) {
+      fputs(job->errors, stderr);
+    }
+    if (job->output != NULL) {
+      fputs(job->output, stdout);
+    }
+    free(job->output);
+    free(job->errors);
+    free(job->line);
+  }
+  fflush(stdout);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  workpool_delete(pool);
+
+  double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  double* seconds = malloc((numJobs > 0 ? numJobs : 1) * sizeof(double));
+  long touched = 0;
+  for (int i = 0; i < numJobs; i++) {
+    touched += jobs[i].touched;
+    if (seconds != NULL) {
+      seconds[i] = jobs[i].seconds;
+    }
+  }
+  fprintf(stderr, "Batch: %d queries in %.3f s on %d threads, %.1f queries/s\n",
+          numJobs, elapsed, querier->numThreads, (elapsed > 0) ? numJobs / elapsed : 0.0);
+  if (seconds != NULL && numJobs > 0) {
+    qsort(seconds, numJobs, sizeof(double), doubleCmp);
+    fprintf(stderr, "Latency: p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+            1e3 * percentile(seconds, numJobs, 50), 1e3 * percentile(seconds, numJobs, 90),
+            1e3 * percentile(seconds, numJobs, 99), 1e3 * seconds[numJobs - 1]);
+  }
+  fprintf(stderr, "Postings: %ld decoded, %.1f per query\n", touched,
+          (numJobs > 0) ? (double)touched / numJobs : 0.0);
+
+  free(seconds);
+  free(jobs);
+  return 0;
+}
+
+/*
+ * Worker pool task: answers one query of a batch into its job's memory
+ * streams, timing it, then marks it done
+ */
+static void runBatchQuery(void* arg, void* scratch) {
+  query_job_t* job = arg;
+  scratch_t* mine = scratch;
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  processQuery(job->line, job->querier, mine, job->out, job->err);
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  pthread_mutex_lock(&job->batch->lock);
+  job->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+  job->touched = (mine != NULL) ? mine->touched : 0;
+  job->done = true;
+  pthread_cond_broadcast(&job->batch->answered);
+  pthread_mutex_unlock(&job->batch->lock);
+}
+
+/* 
+ * HELPER FUNCTION
+ * Orders doubles increasingly
+ */
+static int doubleCmp(const void* a, const void* b) {
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+/* 
+ * HELPER FUNCTION
+ * Returns the p-th percentile (nearest rank) of n > 0 sorted values
+ */
+static double percentile(const double* sorted, const int n, const int p) {
+  int rank = (p * n + 99) / 100;
+  return sorted[(rank > 0) ? rank - 1 : 0];
+}
+
+/*
+ * Creates an empty scratch_t for one thread's queries
+ *
+ * Return:
+ *   new scratch, or NULL if out of memory
+ */
+static void* newScratch(void) {
+  return calloc(1, sizeof(scratch_t));
+}
+
+/*
+ * Frees a scratch_t and the buffers it has kept; ignores NULL
+ */
+static void freeScratch(void* arg) {
+  scratch_t* scratch = arg;
+  if (scratch == NULL) {
+    return;
+  }
+  for (int i = 0; i < scratch->queryCap; i++) {
+    free(scratch->queries[i].results);
+  }
+  free(scratch->queries);
+  free(scratch->threads);
+  free(scratch->threaded);
+  free(scratch->ranked);
+  free(scratch);
+}
+
+/*
+ * HELPER FUNCTION
+ * Makes room for at least needed elements (and at least one) of the 
+ * given size in a reusable array, doubling its capacity as needed; new
+ * elements are zeroed
+ *
+ * Return:
+ *   true if there is room, false if out of memory (the array is kept)
+ */
+static bool reserve(void** array, int* capacity, const int needed, const size_t size) {
+  if (needed <= *capacity && *array != NULL) {
+    return true;
+  }
+  int newCap = (*capacity > 0) ? *capacity : 1;
+  while (newCap < needed) {
+    newCap *= 2;
+  }
+  char* bigger = realloc(*array, newCap * size);
+  if (bigger == NULL) {
+    return false;
+  }
+  memset(bigger + *capacity * size, 0, (newCap - *capacity) * size);
+  *array = bigger;
+  *capacity = newCap;
+  return true;
+}
+
+/*
+ * Builds the canonical form of a validated query, the key under which 
+ * its results are cached. AND and OR are commutative, so the words of 
+ * each AND sequence are sorted (and a repeated word, which cannot change
+ * the minimum, is dropped), and the sequences are sorted and joined with
+ * " or ". Every ordering of the same words and sequences gives the same 
+ * key.
+ *
+ * Caller provides:
+ *   words - normalized, validated query words
+ *   wordCount - number of words
+ * Return:
+ *   allocated key string, or NULL if out of memory
+ */
+static char* canonicalQuery(char** words, const int wordCount) {
+  char** clauses = malloc(wordCount * sizeof(char*));
+  char** terms = malloc(wordCount * sizeof(char*));
+  if (clauses == NULL || terms == NULL) {
+    free(clauses);
+    free(terms);
+    return NULL;
+  }
+
+  int numClauses = 0;
+  size_t keyLen = 1;
+  bool ok = true;
+  for (int i = 0; i < wordCount; i++) {
+    int numTerms = 0;
+    size_t len = 1;
+    for (; i < wordCount && strcmp(words[i], "or") != 0; i++) {
+      if (strcmp(words[i], "and") != 0) {
+        terms[numTerms++] = words[i];
+        len += strlen(words[i]) + 1;
+      }
+    }
+    qsort(terms, numTerms, sizeof(char*), stringCmp);
+
+    char* clause = malloc(len);
+    if (clause == NULL) {
+      ok = false;
+      break;
+    }
+    clause[0] = '\0';
+    for (int t = 0; t < numTerms; t++) {
+      if (t == 0 || strcmp(terms[t], terms[t - 1]) != 0) {
+        if (t > 0) {
+          strcat(clause, " ");
+        }
+        strcat(clause, terms[t]);
+      }
+    }
+    clauses[numClauses++] = clause;
+    keyLen += strlen(clause) + 4;
+  }
+
+  char* key = ok ? malloc(keyLen) : NULL;
+  if (key != NULL) {
+    qsort(clauses, numClauses, sizeof(char*), stringCmp);
+    key[0] = '\0';
+    for (int c = 0; c < numClauses; c++) {
+      if (c > 0) {
+        strcat(key, " or ");
+      }
+      strcat(key, clauses[c]);
+    }
+  }
+
+  for (int c = 0; c < numClauses; c++) {
+    free(clauses[c]);
+  }
+  free(clauses);
+  free(terms);
+  return key;
+}
+
+/* 
+ * HELPER FUNCTION
+ * Compares two strings through pointers to them, for qsort
+ */
+static int stringCmp(const void* a, const void* b) {
+  return strcmp(*(char* const*)a, *(char* const*)b);
 }
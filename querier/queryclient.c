@@ -0,0 +1,144 @@
+/*
+ * queryclient.c    Gretchen Kerfoot    Spring 2025
+ *
+ * Sends queries to a querier running as a server (querier --socket) and
+ * prints its answers, so any number of query streams can be run against
+ * an index that is loaded only once.
+ *
+ * Usage: ./queryclient socketPath
+ *
+ * Queries are read from stdin, one per line, as by the querier. Each is
+ * sent to the server, and the reply, which ends with an empty line, is
+ * printed: lines starting with "Error:" to stderr, others to stdout. So
+ * the output is the same as the querier's own.
+ *
+ * Exit status: 0 at the end of stdin, 1 for bad arguments, 2 if the
+ * server cannot be reached, 3 if it closes the connection.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+static int connectTo(const char* socketPath);
+static bool readReply(FILE* in);
+
+/*
+ * Connects to the server, then sends it each line of stdin and prints
+ * its replies
+ *
+ * Caller provides:
+ *   argc - number of command-line arguments
+ *   argv - array of command-line argument strings
+ * Return:
+ *   0 on normal completion, non-zero exit code on error
+ */
+int main(const int argc, char* argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "Usage: ./queryclient socketPath\n");
+    exit(1);
+  }
+
+  int fd = connectTo(argv[1]);
+  if (fd == -1) {
+    fprintf(stderr, "Error: could not connect to '%s'\n", argv[1]);
+    exit(2);
+  }
+  //a server that has gone away is reported when its reply is read
+  signal(SIGPIPE, SIG_IGN);
+
+  FILE* in = fdopen(fd, "r");
+  FILE* out = fdopen(dup(fd), "w");
+  if (in == NULL || out == NULL) {
+    fprintf(stderr, "Error: could not connect to '%s'\n", argv[1]);
+    exit(2);
+  }
+
+  int status = 0;
+  char* line = NULL;
+  size_t len = 0;
+  while (true) {
+    if (isatty(fileno(stdin))) {
+      printf("Query? ");
+      fflush(stdout);
+    }
+
+    ssize_t nread = getline(&line, &len, stdin);
+    if (nread == -1) {
+      break;
+    }
+    if (line[nread - 1] == '\n') {
+      line[nread - 1] = '\0';
+    }
+
+    fprintf(out, "%s\n", line);
+    fflush(out);
+    if (!readReply(in)) {
+      fprintf(stderr, "Error: the server closed the connection\n");
+      status = 3;
+      break;
+    }
+  }
+
+  free(line);
+  fclose(out);
+  fclose(in);
+  return status;
+}
+
+/*
+ * HELPER FUNCTION
+ * Connects to the Unix domain socket at socketPath
+ *
+ * Return:
+ *   the connected socket, or -1 on error
+ */
+static int connectTo(const char* socketPath) {
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (strlen(socketPath) >= sizeof(address.sun_path)) {
+    return -1;
+  }
+  strcpy(address.sun_path, socketPath);
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1) {
+    return -1;
+  }
+  if (connect(fd, (struct sockaddr*)&address, sizeof(address)) == -1) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/*
+ * HELPER FUNCTION
+ * Prints one reply from the server, up to the empty line that ends it
+ *
+ * Return:
+ *   true if the whole reply was read, false if the connection closed
+ */
+static bool readReply(FILE* in) {
+  char* line = NULL;
+  size_t len = 0;
+  ssize_t nread;
+  bool complete = false;
+  while ((nread = getline(&line, &len, in)) != -1) {
+    if (strcmp(line, "\n") == 0) {
+      complete = true;
+      break;
+    }
+    fputs(line, strncmp(line, "Error:", 6) == 0 ? stderr : stdout);
+  }
+  free(line);
+  return complete;
+}
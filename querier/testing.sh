@@ -8,6 +8,13 @@
 #   Tests AND/OR precedence
 #   Tests for invalid and empty queries
 #   Tests for multiple matches with the same score
+#   Tests prefix (wildcard) queries
+#   Tests a sharded index against the unsharded one
+#   Tests documents with docIDs above 1000
+#   Tests limiting the number of results with --top
+#   Tests printing results from the document table, without page files
+#   Tests common words, whose postings are bitmaps, in either order
+#   Tests the result cache, and its invalidation when the index changes
 #   Tests querier under valgrind for memory leaks
 
 #establishing pageDirectory and indexFile 
@@ -64,6 +71,160 @@ echo "Test 10: multiple matches with same score"
 echo "Query: playground"
 ./querier $PAGEDIR $INDEXFILE <<< "playground"
 
+#prefix term expands to all words starting with it
+echo "Test 11: prefix query"
+echo "Query: comput*"
+./querier $PAGEDIR $INDEXFILE <<< "comput*"
+
+#misplaced wildcard is rejected
+echo "Test 12: misplaced wildcard"
+echo "Query: comp*ter"
+./querier $PAGEDIR $INDEXFILE <<< "comp*ter"
+
+#sharded index gives the same results
+echo "Test 13: index split into 3 shards"
+echo "Query: eniac or home and playground"
+../indexer/indexer --shards 3 $PAGEDIR shards
+./querier $PAGEDIR shards <<< "eniac or home and playground" > shards.out
+./querier $PAGEDIR $INDEXFILE <<< "eniac or home and playground" | cmp - shards.out && echo "sharded results match"
+rm -f shards.* 
+
+#docIDs are not limited to 1..1000: repeats the pages up to docID 1200
+echo "Test 14: docIDs above 1000"
+echo "Query: playground"
+mkdir -p bigpages
+cp $PAGEDIR/.crawler bigpages/
+NUMPAGES=$(ls $PAGEDIR | grep -c '^[0-9]*$')
+for ((i = 1; i <= 1200; i++)); do
+  cp $PAGEDIR/$(( (i - 1) % NUMPAGES + 1 )) bigpages/$i
+done
+../indexer/indexer bigpages bigindex
+./querier bigpages bigindex <<< "playground" | awk '$4 + 0 > 1000' | head -3
+rm -rf bigpages bigindex bigindex.docs
+
+#--top prints only the best K results, the same as the first K without it
+echo "Test 15: top 3 results"
+echo "Query: playground"
+./querier --top 3 $PAGEDIR $INDEXFILE <<< "playground" > top.out
+./querier $PAGEDIR $INDEXFILE <<< "playground" | head -4 | cmp - top.out && echo "top results match"
+rm -f top.out
+
+#invalid result limit
+echo "Test 16: invalid --top"
+./querier --top 0 $PAGEDIR $INDEXFILE <<< "playground"
+
+#the indexer's .docs table holds the URLs, so page files are not needed
+echo "Test 17: results without page files"
+echo "Query: playground"
+../indexer/indexer $PAGEDIR docsindex
+mkdir -p nopages
+cp $PAGEDIR/.crawler nopages/
+./querier $PAGEDIR docsindex <<< "playground" > pages.out
+./querier nopages docsindex <<< "playground" | cmp - pages.out && echo "results match without page files"
+rm -rf nopages pages.out docsindex docsindex.docs
+
+#words in many documents are decoded as bitmaps; combining them with 
+#each other and with lists gives the same results in either order
+echo "Test 18: common words as bitmaps"
+echo "Query: playground and search or home"
+mkdir -p densepages
+cp $PAGEDIR/.crawler densepages/
+for ((i = 1; i <= 400; i++)); do
+  cp $PAGEDIR/$(( (i - 1) % NUMPAGES + 1 )) densepages/$i
+done
+../indexer/indexer densepages denseindex
+./querier densepages denseindex <<< "playground and search or home" | tail -n +2 > dense1.out
+./querier densepages denseindex <<< "home or search playground" | tail -n +2 | cmp - dense1.out && echo "bitmap results match in either order"
+rm -rf densepages denseindex denseindex.docs dense1.out
+
+#repeated and reordered queries are answered from the cache
+echo "Test 19: result cache"
+printf "%s\n" "search and computational" "computational search" "search" \
+  "computational search or eniac" "eniac or search computational" > cachequeries
+./querier --cache-stats $PAGEDIR $INDEXFILE < cachequeries > cache1.out
+./querier --cache 0 $PAGEDIR $INDEXFILE < cachequeries | cmp - cache1.out && echo "cached results match uncached results"
+rm -f cachequeries cache1.out
+
+#removing a document changes the index files, which clears the cache;
+#the pause lets the querier answer the first query before the removal
+echo "Test 20: cache invalidated by indexremove"
+echo "Query: playground, before and after removing its best document"
+../indexer/indexer $PAGEDIR cacheindex
+BEST=$(./querier $PAGEDIR cacheindex <<< "playground" | awk 'NR == 2 {print $4 + 0}')
+{ echo "playground"; sleep 1; ../indexer/indexremove cacheindex $BEST; echo "playground"; } | \
+  ./querier --cache-stats $PAGEDIR cacheindex | grep -c "doc *$BEST:"
+rm -f cacheindex cacheindex.docs cacheindex.deleted
+
+#invalid cache size
+echo "Test 21: invalid --cache"
+./querier --cache 12Q $PAGEDIR $INDEXFILE <<< "playground"
+
+#the plan orders each and-sequence by document frequency and skips
+#sequences with a word in no document, without changing the results
+echo "Test 22: query plan"
+./querier --plan $PAGEDIR $INDEXFILE <<< "zzzzqq and search or computational search"
+./querier --plan $PAGEDIR $INDEXFILE <<< "search computational or zzzzqq" | grep -v "^Plan" > plan1.out
+./querier $PAGEDIR $INDEXFILE <<< "search computational or zzzzqq" | cmp - plan1.out && echo "planned results match"
+rm -f plan1.out
+
+#a server answers queries from several clients with the index loaded once
+echo "Test 23: querier server"
+printf "%s\n" "search" "computational and biology" "eniac or home" "and search" > serverqueries
+./querier $PAGEDIR $INDEXFILE < serverqueries > server1.out 2> server1.err
+./querier --max-clients 1 --socket querier.sock $PAGEDIR $INDEXFILE &
+SERVER=$!
+sleep 1
+./queryclient querier.sock < serverqueries > server2.out 2> server2.err
+cmp server1.out server2.out && cmp server1.err server2.err && echo "server results match"
+#a second client beyond the limit is turned away while the first is connected
+{ echo "search"; sleep 2; } | ./queryclient querier.sock > /dev/null &
+sleep 1
+./queryclient querier.sock <<< "search"
+echo "exit status $?"
+#SIGTERM lets connected clients finish, then removes the socket
+kill -TERM $SERVER
+wait
+ls querier.sock
+rm -f serverqueries server1.out server1.err server2.out server2.err
+
+#a pool of worker threads answers several clients' queries at once
+echo "Test 24: parallel queries"
+printf "%s\n" "search" "computational and biology" "eniac or home" "comput*" "playground search" > poolqueries
+./querier $PAGEDIR $INDEXFILE < poolqueries > pool0.out
+./querier --threads 4 --socket querier.sock $PAGEDIR $INDEXFILE &
+SERVER=$!
+sleep 1
+for i in 1 2 3 4; do
+  ./queryclient querier.sock < poolqueries > pool$i.out &
+done
+wait %2 %3 %4 %5
+for i in 1 2 3 4; do
+  cmp pool0.out pool$i.out && echo "client $i results match"
+done
+kill -TERM $SERVER
+wait
+rm -f poolqueries pool0.out pool1.out pool2.out pool3.out pool4.out
+
+#an or of several and-sequences can be evaluated on several threads;
+#the threshold of 1 posting makes every such query do so
+echo "Test 25: parallel or"
+printf "%s\n" "search or home or eniac or playground" "computational biology or search home or comput* or zzzzqq" \
+  "a or b or c" "tse and search or page or home and playground or biology" > orqueries
+./querier --or-threads 1 $PAGEDIR $INDEXFILE < orqueries > or1.out
+./querier --or-threads 4 --parallel-or 1 $PAGEDIR $INDEXFILE < orqueries | cmp - or1.out && echo "parallel or results match"
+rm -f orqueries or1.out
+
+#a batch answers a file of queries in parallel, printing them in order,
+#then reports its throughput on stderr
+echo "Test 26: batch mode"
+printf "%s\n" "search" "computational and biology" "or home" "eniac or home" "comput*" "" "playground search" > batchqueries
+./querier $PAGEDIR $INDEXFILE < batchqueries > batch1.out 2> batch1.err
+./querier --threads 4 --batch batchqueries $PAGEDIR $INDEXFILE > batch2.out 2> batch2.err
+cmp batch1.out batch2.out && echo "batch results match"
+grep -v "^Batch:\|^Latency:\|^Postings:" batch2.err | cmp - batch1.err && echo "batch errors match"
+grep -c "^Batch: 7 queries\|^Latency: p50\|^Postings:" batch2.err
+rm -f batchqueries batch1.out batch1.err batch2.out batch2.err
+
 #valgrind testing
 echo "Valgrind test: memory check on valid queries"
 valgrind --leak-check=full --error-exitcode=1 ./querier $PAGEDIR $INDEXFILE <<EOF